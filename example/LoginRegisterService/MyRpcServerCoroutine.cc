@@ -0,0 +1,57 @@
+//
+// 协程版 UserService：handler 写成 krpc::Task<Response>，阻塞的业务逻辑放进线程池，
+// IO 线程在等待期间可以继续处理其他连接上的请求。需以 -DKRPC_BUILD_COROUTINE=ON 构建（C++20）。
+//
+#include "../user.pb.h"
+#include "Application.h"
+#include "RPCServer.h"
+#include "RpcCoroutine.h"
+#include <muduo/base/ThreadPool.h>
+
+#include <string>
+
+class UserServiceImpl : public Kuser::UserServiceRpc
+{
+private:
+    muduo::ThreadPool workers_;
+public:
+    explicit UserServiceImpl(int thread_num = 3) : workers_("UserService Workers") {
+        workers_.start(thread_num);
+    }
+
+    // 本地阻塞逻辑，实际场景中是查 MySQL 连接池
+    bool Login(const std::string& name, const std::string& pwd) {
+        return !name.empty() && !pwd.empty();
+    }
+
+    // 协程 handler：request 由框架持有到回包为止，可以按引用捕获
+    krpc::Task<Kuser::LoginResponse> LoginCo(const Kuser::LoginRequest& request) {
+        bool ok = co_await krpc::runIn(workers_, [this, &request]() {
+            return Login(request.name(), request.pwd());
+        });
+        // 这里已经回到了收到请求的 IO 线程
+        Kuser::LoginResponse response;
+        Kuser::ResultCode* code = response.mutable_result();
+        code->set_errcode(ok ? 0 : 1);
+        code->set_errmsg(ok ? "" : "invalid name or password");
+        response.set_success(ok);
+        co_return response;
+    }
+
+    void Login(::google::protobuf::RpcController* controller,
+               const ::Kuser::LoginRequest* request,
+               ::Kuser::LoginResponse* response,
+               ::google::protobuf::Closure* done) override {
+        krpc::serve(controller, LoginCo(*request), response, done);
+    }
+};
+
+int main(int argc, char **argv) {
+    auto& app = Application::Instance(argc, argv);
+
+    RpcServer _rpc_server;
+    _rpc_server.NotifyService(new UserServiceImpl());
+    _rpc_server.Run(app.ServerHost(), app.ServerPort(), app.ZkHost(), std::to_string(app.ZkPort()));
+
+    return 0;
+}
@@ -6,6 +6,8 @@
 
 
 #include <thread>
+#include <chrono>
+#include <cstdlib>
 #include <string>
 /*
 UserService 原本是一个本地服务，提供了两个本地方法：Login 和 GetFriendLists。
@@ -88,6 +90,15 @@ int main(int argc, char **argv) {
     // 将 UserService 对象发布到 RPC 节点上，使其可以被远程调用
     _rpc_server.NotifyService(new UserServiceImpl());
 
+    // 预热完成后才注册到 ZooKeeper，这里用 warmup_seconds 模拟加载缓存、建立连接池的耗时
+    int warmupSeconds = std::atoi(app.GetConfig("warmup_seconds").c_str());
+    if (warmupSeconds > 0) {
+        _rpc_server.SetWarmupHook([warmupSeconds]() {
+            std::this_thread::sleep_for(std::chrono::seconds(warmupSeconds));
+            return true;
+        });
+    }
+
     // 启动 RPC 服务节点，进入阻塞状态，等待远程的 RPC 调用请求
     _rpc_server.Run(srvHost, srvPort, zkHost, std::to_string(zkPort));
 
@@ -7,12 +7,15 @@
 #include "muduo/net/TcpClient.h"
 #include "ServiceDiscovery.h"
 #include "RPCChannel.h"
+#include "RpcController.h"
+#include "ConcurrencyLimiter.h"
 #include "../user.pb.h"
 #include <google/protobuf/stubs/common.h>
 #include "Application.h"
 #include <vector>
 #include <thread>
 #include <atomic>
+#include <memory>
 
 using namespace muduo;
 using namespace muduo::net;
@@ -35,20 +38,23 @@ InetAddress getAddr(const std::string& service, const std::string& method){
     return InetAddress(ip, port);
 }
 
-// RpcClient 支持一次性并发发起 N 个 RPC
+// RpcClient 支持一次性并发发起 N 个 RPC；设置了 limiter 时在途数不超过其上限，其余的等前面的调用结束再发
 class RpcClient : noncopyable {
 public:
     RpcClient(EventLoop* loop,
               const InetAddress& serverAddr,
               int clientId,
-              int numRequests)
+              int numRequests,
+              bool adaptiveLimit)
             : loop_(loop),
               client_(loop, serverAddr, "RpcClient"),
               channel_(new RPCChannel()),
               stub_(channel_.get()),
               clientId_(clientId),
               totalRequests_(numRequests),
-              pendingResponses_(numRequests)
+              unsent_(numRequests),
+              pendingResponses_(numRequests),
+              limiter_(adaptiveLimit ? new ConcurrencyLimiter() : nullptr)
     {
         client_.setConnectionCallback(
                 std::bind(&RpcClient::onConnection, this, std::placeholders::_1));
@@ -62,39 +68,59 @@ public:
     }
 
 private:
-    // 连接成功时，立即并发发起所有请求
+    struct LoginCall {
+        Kuser::LoginResponse  response;
+        RpcController         controller;
+        int64_t               startUs;
+    };
+
+    // 连接成功时，立即并发发起所有请求（有 limiter 时只发到上限）
     void onConnection(const TcpConnectionPtr& conn) {
         if (conn->connected()) {
             LOG_INFO << "[Client " << clientId_ << "] connected, sending "
                      << totalRequests_ << " requests in parallel";
             channel_->setConnection(conn);
-            for (int i = 0; i < totalRequests_; ++i) {
-                sendLogin();
-            }
+            sendMore();
         } else {
             LOG_INFO << "[Client " << clientId_ << "] disconnected";
             loop_->quit();
         }
     }
 
+    // 回调都在本 loop 线程上执行，unsent_ 不需要加锁
+    void sendMore() {
+        while (unsent_ > 0 && (!limiter_ || limiter_->tryAcquire())) {
+            --unsent_;
+            sendLogin();
+        }
+    }
+
     // 真正发送一次 Login RPC
     void sendLogin() {
         Kuser::LoginRequest request;
         request.set_name("zhangsan");
         request.set_pwd("123456");
         // 注意：Response 对象必须是堆上分配，以便异步回调里 delete
-        auto* response = new Kuser::LoginResponse;
-        stub_.Login(nullptr, &request, response,
+        auto* call = new LoginCall;
+        call->startUs = Timestamp::now().microSecondsSinceEpoch();
+        stub_.Login(&call->controller, &request, &call->response,
                     google::protobuf::NewCallback(
-                            this, &RpcClient::onLoginDone, response));
+                            this, &RpcClient::onLoginDone, call));
     }
 
     // 每收到一个回调就递减 pendingResponses_
-    void onLoginDone(Kuser::LoginResponse* resp) {
-        if (resp->result().errcode() == 0) {
+    void onLoginDone(LoginCall* call) {
+        if (!call->controller.Failed() && call->response.result().errcode() == 0) {
             g_successCount.fetch_add(1, std::memory_order_relaxed);
         }
-        delete resp;
+        if (limiter_) {
+            limiter_->onResult(call->controller.Status(),
+                               Timestamp::now().microSecondsSinceEpoch() - call->startUs);
+        }
+        delete call;
+        if (limiter_) {
+            sendMore();
+        }
 
         // 所有回调都收完了，就断开连接
         if (pendingResponses_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
@@ -110,7 +136,9 @@ private:
     Kuser::UserServiceRpc_Stub   stub_;
     int                          clientId_;
     int                          totalRequests_;
+    int                          unsent_;
     std::atomic<int>             pendingResponses_;
+    std::unique_ptr<ConcurrencyLimiter>  limiter_;
 };
 
 int main(int argc, char** argv) {
@@ -125,17 +153,19 @@ int main(int argc, char** argv) {
 
     auto& app = Application::Instance(argc, argv);
     ServiceDiscovery::instance().init(app.ZkHost(), std::to_string(app.ZkPort()));
+    // concurrency_limit=adaptive：每个客户端按延迟自适应限制在途数，而不是一次把请求全部压到服务端
+    bool adaptiveLimit = app.GetConfig("concurrency_limit") == "adaptive";
 
     auto t_start = std::chrono::high_resolution_clock::now();
 
     std::vector<std::thread> threads;
     threads.reserve(numThreads);
     for (int i = 0; i < numThreads; ++i) {
-        threads.emplace_back([&service, &method, i, requestsPerClient]() {
+        threads.emplace_back([&service, &method, i, requestsPerClient, adaptiveLimit]() {
             EventLoop loop;
             InetAddress addr = getAddr(service, method);
             LOG_INFO << "[Client " << i << "] server addr = " << addr.toIpPort();
-            RpcClient client(&loop, addr, i, requestsPerClient);
+            RpcClient client(&loop, addr, i, requestsPerClient, adaptiveLimit);
             client.connect();
             loop.loop();
         });
@@ -0,0 +1,116 @@
+//
+// 共享客户端运行时示例：进程内只有 ClientRuntime 的固定 IO 线程，
+// 任意数量的业务线程通过 ServiceChannel（背后是 ChannelPool）共享到同一 endpoint 的连接，以同步阻塞方式发起调用。
+//
+#include "ServiceDiscovery.h"
+#include "ClientRuntime.h"
+#include "ChannelPool.h"
+#include "ServiceChannel.h"
+#include "RpcController.h"
+#include "../user.pb.h"
+#include <google/protobuf/stubs/common.h>
+#include "Application.h"
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+static std::atomic<int>  g_successCount{0};
+
+int main(int argc, char** argv) {
+    if (argc < 6) {
+        printf("Usage: %s <service> <method> <io_threads> <app_threads> <requests_per_thread>\n", argv[0]);
+        return 1;
+    }
+    std::string service  = argv[1];      // e.g. "UserServiceRpc"
+    std::string method   = argv[2];      // e.g. "Login"
+    int ioThreads        = std::atoi(argv[3]);
+    int appThreads       = std::atoi(argv[4]);
+    int requestsPerThread= std::atoi(argv[5]);
+
+    auto& app = Application::Instance(argc, argv);
+    // 本地快照：ZooKeeper 不可用时也能用上次的实例列表启动
+    std::string snapshotPath = app.GetConfig("discovery_snapshot");
+    if (!snapshotPath.empty()) {
+        ServiceDiscovery::instance().setSnapshotPath(snapshotPath);
+    }
+    // 只订阅要压测的方法，启动时预先拉取，其余服务不关心
+    ServiceDiscovery::instance().init(app.ZkHost(), std::to_string(app.ZkPort()),
+                                      std::vector<std::string>{service + "/" + method});
+    // 负载均衡策略：random / round_robin / p2c / ewma / ring_hash / maglev
+    std::string lbPolicy = app.GetConfig("lb_policy");
+    if (!lbPolicy.empty()) {
+        ServiceDiscovery::instance().setBalancer(service, lbPolicy);
+    }
+    // 新上线实例的慢启动窗口（秒）
+    std::string slowStart = app.GetConfig("slow_start_window");
+    if (!slowStart.empty()) {
+        ServiceDiscovery::instance().setSlowStartWindow(std::stod(slowStart));
+    }
+
+    // 整个进程只有 ioThreads 个 IO 线程
+    ClientRuntime::instance().start(ioThreads);
+    std::string connsPerEndpoint = app.GetConfig("connections_per_endpoint");
+    if (!connsPerEndpoint.empty()) {
+        ChannelPool::instance().setConnectionsPerEndpoint(std::stoi(connsPerEndpoint));
+    }
+    // concurrency_limit=adaptive：按延迟自适应限制每个实例的在途调用数，超出的同步调用在本地排队
+    if (app.GetConfig("concurrency_limit") == "adaptive") {
+        ConcurrencyLimiter::Options options;
+        options.maxQueue = appThreads;
+        ChannelPool::instance().setConcurrencyLimit(options);
+    }
+
+    // 所有线程共用一个 ServiceChannel：每次调用自动选取实例、复用池中的连接，失败时按重试策略换实例重试
+    ServiceChannel channel(service);
+    std::string maxAttempts = app.GetConfig("retry_max_attempts");
+    if (!maxAttempts.empty()) {
+        RetryPolicy policy;
+        policy.maxAttempts = std::stoi(maxAttempts);
+        policy.idempotent = true;   // 压测用的 Login 可以安全重试
+        channel.setRetryPolicy(method, policy);
+    }
+
+    auto t_start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> threads;
+    threads.reserve(appThreads);
+    for (int i = 0; i < appThreads; ++i) {
+        threads.emplace_back([&channel, requestsPerThread, i]() {
+            Kuser::UserServiceRpc_Stub stub(&channel);
+            for (int n = 0; n < requestsPerThread; ++n) {
+                Kuser::LoginRequest request;
+                request.set_name("user" + std::to_string(i));
+                request.set_pwd("123456");
+                Kuser::LoginResponse response;
+                RpcController controller;
+                // 一致性哈希策略（ring_hash / maglev）下同一用户总是落到同一实例
+                controller.SetHashKey(request.name());
+                // done 为空即同步调用，阻塞到回包或超时（包括重试）
+                stub.Login(&controller, &request, &response, nullptr);
+                if (!controller.Failed() && response.result().errcode() == 0) {
+                    g_successCount.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    for (auto& t : threads) t.join();
+
+    auto t_end = std::chrono::high_resolution_clock::now();
+    double elapsed = std::chrono::duration<double>(t_end - t_start).count();
+    int totalReqs = appThreads * requestsPerThread;
+    int success   = g_successCount.load();
+    double qps    = totalReqs / elapsed;
+
+    LOG(INFO) << "===== Pressure Test Summary =====";
+    LOG(INFO) << "IO Threads: " << ioThreads << ", App Threads: " << appThreads
+              << ", Requests/Thread: " << requestsPerThread;
+    LOG(INFO) << "Total Requests: " << totalReqs
+              << ", Success: " << success;
+    LOG(INFO) << "Elapsed Time: " << elapsed << " s";
+    LOG(INFO) << "Overall QPS: " << qps << " req/s";
+
+    google::protobuf::ShutdownProtobufLibrary();
+    return 0;
+}
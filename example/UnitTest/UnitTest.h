@@ -0,0 +1,63 @@
+// UnitTest.h
+// example/UnitTest 下各个单元测试共用的断言宏和测试数据。不依赖测试框架：断言失败时打印位置并计数，
+// 不中断后面的检查；main 最后返回 unitTestResult(...)，有失败时进程以 1 退出，ctest 据此判定
+#ifndef _UNITTEST_H_
+#define _UNITTEST_H_
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "Endpoint.h"
+
+inline int& unitTestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define EXPECT_TRUE(cond)                                                                   \
+    do {                                                                                    \
+        if (!(cond)) {                                                                      \
+            ++unitTestFailures();                                                           \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": expected " #cond << std::endl;   \
+        }                                                                                   \
+    } while (0)
+
+#define EXPECT_FALSE(cond) EXPECT_TRUE(!(cond))
+
+// 两边的值需要能用 operator<< 输出
+#define EXPECT_EQ(expected, actual)                                                         \
+    do {                                                                                    \
+        const auto& unitTestExpected = (expected);                                          \
+        const auto& unitTestActual = (actual);                                              \
+        if (!(unitTestExpected == unitTestActual)) {                                        \
+            ++unitTestFailures();                                                           \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": expected " #actual " == "        \
+                      << unitTestExpected << ", got " << unitTestActual << std::endl;       \
+        }                                                                                   \
+    } while (0)
+
+// n 个实例 10.0.0.<i>:8000（跳过下标 skip），各自带一份统计；detector 非空时设给每份统计
+inline EndpointList makeEndpoints(int n, int skip = -1, OutlierDetector* detector = nullptr) {
+    EndpointList endpoints;
+    for (int i = 0; i < n; ++i) {
+        if (i == skip) continue;
+        Endpoint ep;
+        ep.hostPort = "10.0.0." + std::to_string(i) + ":8000";
+        ep.stats = std::make_shared<EndpointStats>(ep.hostPort);
+        ep.stats->setDetector(detector);
+        endpoints.push_back(ep);
+    }
+    return endpoints;
+}
+
+inline int unitTestResult(const char* name) {
+    if (unitTestFailures() == 0) {
+        std::cout << "[PASS] " << name << std::endl;
+        return 0;
+    }
+    std::cout << "[FAIL] " << name << ": " << unitTestFailures() << " failed checks" << std::endl;
+    return 1;
+}
+
+#endif // _UNITTEST_H_
@@ -0,0 +1,173 @@
+// 自适应并发上限测试：名额占用与释放、Gradient2 的增长与收缩、超时退避、状态码映射、排队与排队超时
+#include <unistd.h>
+#include <vector>
+#include "ConcurrencyLimiter.h"
+#include "UnitTest.h"
+
+namespace {
+
+// 占满当前上限，再全部以 rttUs 完成，返回这一轮占到的名额数
+int saturatedRound(ConcurrencyLimiter* limiter, int64_t rttUs) {
+    int acquired = 0;
+    while (limiter->tryAcquire()) {
+        ++acquired;
+    }
+    for (int i = 0; i < acquired; ++i) {
+        limiter->onComplete(rttUs, false);
+    }
+    return acquired;
+}
+
+void testAcquireRelease() {
+    ConcurrencyLimiter::Options options;
+    options.initialLimit = 4;
+    ConcurrencyLimiter limiter(options);
+    EXPECT_EQ(4, limiter.limit());
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(limiter.tryAcquire());
+    }
+    EXPECT_FALSE(limiter.tryAcquire());
+    EXPECT_EQ(4, limiter.inflight());
+    limiter.onIgnore();
+    EXPECT_EQ(3, limiter.inflight());
+    EXPECT_TRUE(limiter.tryAcquire());
+
+    // 初始上限按 [minLimit, maxLimit] 截断
+    options.initialLimit = 1;
+    EXPECT_EQ(options.minLimit, ConcurrencyLimiter(options).limit());
+    options.initialLimit = 5000;
+    EXPECT_EQ(options.maxLimit, ConcurrencyLimiter(options).limit());
+}
+
+void testGradient() {
+    ConcurrencyLimiter::Options options;
+    options.maxLimit = 200;
+    ConcurrencyLimiter limiter(options);
+    // 在途数不到上限一半时延迟说明不了什么，上限不动
+    for (int round = 0; round < 100; ++round) {
+        for (int i = 0; i < 5; ++i) EXPECT_TRUE(limiter.tryAcquire());
+        for (int i = 0; i < 5; ++i) limiter.onComplete(1000, false);
+    }
+    EXPECT_EQ(20, limiter.limit());
+
+    // 用满上限且延迟稳定：每轮增长（每个样本约 smoothing × sqrt(limit)），直到 maxLimit
+    int last = limiter.limit();
+    for (int round = 0; round < 20 && last < options.maxLimit; ++round) {
+        EXPECT_EQ(last, saturatedRound(&limiter, 1000));
+        EXPECT_TRUE(limiter.limit() > last);
+        last = limiter.limit();
+    }
+    EXPECT_EQ(options.maxLimit, last);
+    saturatedRound(&limiter, 1000);
+    EXPECT_EQ(options.maxLimit, limiter.limit());
+
+    // 延迟明显上升（排队）：收缩
+    saturatedRound(&limiter, 5000);
+    EXPECT_TRUE(limiter.limit() < last);
+}
+
+void testBackoff() {
+    ConcurrencyLimiter::Options options;
+    options.initialLimit = 100;
+    options.minLimit = 4;
+    options.backoffRatio = 0.5;
+
+    // 还没有 RTT 样本时每次超时都收缩，直到 minLimit
+    ConcurrencyLimiter limiter(options);
+    const int expected[] = {50, 25, 12, 6, 4, 4};
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+        EXPECT_TRUE(limiter.tryAcquire());
+        limiter.onComplete(0, true);
+        EXPECT_EQ(expected[i], limiter.limit());
+    }
+    EXPECT_EQ(0, limiter.inflight());
+
+    // 同一波超时在一个短期 RTT 内只收缩一次
+    ConcurrencyLimiter slow(options);
+    EXPECT_TRUE(slow.tryAcquire());
+    slow.onComplete(1000 * 1000, false);
+    EXPECT_EQ(100, slow.limit());
+    EXPECT_TRUE(slow.tryAcquire());
+    EXPECT_TRUE(slow.tryAcquire());
+    slow.onComplete(0, true);
+    slow.onComplete(0, true);
+    EXPECT_EQ(50, slow.limit());
+}
+
+void testOnResult() {
+    ConcurrencyLimiter::Options options;
+    options.initialLimit = 10;
+    options.backoffRatio = 0.5;
+    ConcurrencyLimiter limiter(options);
+
+    // 取消、连接断开：只释放名额
+    EXPECT_TRUE(limiter.tryAcquire());
+    limiter.onResult(Krpc::CANCELLED, 1000);
+    EXPECT_TRUE(limiter.tryAcquire());
+    limiter.onResult(Krpc::UNAVAILABLE, 1000);
+    EXPECT_EQ(10, limiter.limit());
+    EXPECT_EQ(0, limiter.inflight());
+
+    // 超时 / 服务端资源不足：按 backoffRatio 收缩
+    EXPECT_TRUE(limiter.tryAcquire());
+    limiter.onResult(Krpc::RESOURCE_EXHAUSTED, 1000);
+    EXPECT_EQ(5, limiter.limit());
+
+    // 成功：计入延迟样本，没有用满时上限不变
+    EXPECT_TRUE(limiter.tryAcquire());
+    limiter.onResult(Krpc::OK, 1000);
+    EXPECT_EQ(5, limiter.limit());
+    EXPECT_EQ(0, limiter.inflight());
+}
+
+void testQueue() {
+    ConcurrencyLimiter::Options options;
+    options.initialLimit = 4;
+    options.maxQueue = 2;
+    options.maxQueueWait = 0.001;
+    ConcurrencyLimiter limiter(options);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(limiter.tryAcquire());
+    }
+
+    std::vector<int> admitted, expired;
+    bool armTimer = false;
+    EXPECT_TRUE(limiter.enqueue([&](bool ok) { (ok ? admitted : expired).push_back(1); }, &armTimer));
+    EXPECT_TRUE(armTimer);
+    EXPECT_TRUE(limiter.enqueue([&](bool ok) { (ok ? admitted : expired).push_back(2); }, &armTimer));
+    EXPECT_FALSE(armTimer);
+    // 队列满了，waiter 不会被调用
+    EXPECT_FALSE(limiter.enqueue([&](bool) { admitted.push_back(3); }, &armTimer));
+
+    // 释放的名额直接交给队首，在途数不变；有人排队时新来的调用不能插队
+    limiter.onIgnore();
+    EXPECT_EQ(1u, admitted.size());
+    EXPECT_EQ(1, admitted[0]);
+    EXPECT_EQ(4, limiter.inflight());
+    EXPECT_FALSE(limiter.tryAcquire());
+
+    // 排队超过 maxQueueWait 的以失败结束，队列空了返回 0
+    ::usleep(5 * 1000);
+    EXPECT_EQ(0.0, limiter.expire());
+    EXPECT_EQ(1u, expired.size());
+    EXPECT_EQ(2, expired[0]);
+    EXPECT_EQ(4, limiter.inflight());
+
+    // 不允许排队时直接失败
+    ConcurrencyLimiter noQueue;
+    while (noQueue.tryAcquire()) {
+    }
+    EXPECT_FALSE(noQueue.enqueue([&](bool) { admitted.push_back(4); }, &armTimer));
+    EXPECT_EQ(1u, admitted.size());
+}
+
+} // namespace
+
+int main() {
+    testAcquireRelease();
+    testGradient();
+    testBackoff();
+    testOnResult();
+    testQueue();
+    return unitTestResult("ConcurrencyLimiter");
+}
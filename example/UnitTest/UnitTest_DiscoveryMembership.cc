@@ -0,0 +1,270 @@
+// 服务发现成员变化测试：在真实的 ZooKeeper 上增删实例节点，检查 MembershipChange 差量
+// （新增、下线、属性变化，以及实例不再属于任何已订阅方法时的 gone），以及滚动升级期间
+// 新布局（/service/instances）与旧布局（/service/method）实例的合并。
+// ZooKeeper 地址取环境变量 KRPC_TEST_ZOOKEEPER（默认 127.0.0.1:2181），连不上时返回 77，ctest 记为跳过。
+// 每次运行使用带 pid 的 service 名，结束时删除创建的节点
+#include <unistd.h>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "ServiceDiscovery.h"
+#include "Zookeeperutil.h"
+#include "UnitTest.h"
+
+namespace {
+
+const int kSkipped = 77;
+
+// 供 EXPECT_EQ 输出
+std::ostream& operator<<(std::ostream& os, const std::set<std::string>& hosts) {
+    os << "{";
+    for (std::set<std::string>::const_iterator it = hosts.begin(); it != hosts.end(); ++it) {
+        os << (it == hosts.begin() ? "" : ", ") << *it;
+    }
+    return os << "}";
+}
+
+// 按 key 累积监听到的差量，得到监听者眼中的当前成员。只记录 service 下的方法，
+// 前一个测试删除节点引起的迟到回调不计入
+class MembershipRecorder {
+public:
+    explicit MembershipRecorder(const std::string& service) : prefix_(service + "/") {}
+
+    void onChange(const MembershipChange& change) {
+        if (change.key.compare(0, prefix_.size(), prefix_) != 0) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        changes_.push_back(change);
+        std::set<std::string>& members = members_[change.key];
+        for (size_t i = 0; i < change.added.size(); ++i) members.insert(change.added[i].hostPort);
+        for (size_t i = 0; i < change.removed.size(); ++i) members.erase(change.removed[i].hostPort);
+    }
+
+    size_t count() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return changes_.size();
+    }
+    MembershipChange at(size_t i) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return changes_[i];
+    }
+    std::set<std::string> members(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return members_[key];
+    }
+
+    // 等到第 n 个差量到达（watcher 事件和重新拉取都是异步的），超时返回 false
+    bool waitFor(size_t n) {
+        for (int i = 0; i < 500 && count() < n; ++i) {
+            ::usleep(10 * 1000);
+        }
+        return count() >= n;
+    }
+
+private:
+    const std::string prefix_;
+    std::mutex mutex_;
+    std::vector<MembershipChange> changes_;
+    std::map<std::string, std::set<std::string>> members_;
+};
+
+std::set<std::string> hostPorts(const EndpointList& endpoints) {
+    std::set<std::string> out;
+    for (size_t i = 0; i < endpoints.size(); ++i) out.insert(endpoints[i].hostPort);
+    return out;
+}
+
+// 多次选取看到的实例，默认的 random 策略下 100 次足以覆盖几个实例
+std::set<std::string> picked(const ServiceKey& key) {
+    std::set<std::string> out;
+    for (int i = 0; i < 100; ++i) out.insert(ServiceDiscovery::instance().pickEndpoint(key).hostPort);
+    return out;
+}
+
+std::set<std::string> hostSet(const char* a, const char* b = nullptr) {
+    std::set<std::string> out;
+    out.insert(a);
+    if (b != nullptr) out.insert(b);
+    return out;
+}
+
+// 测试用的注册端：创建节点并记下路径，结束时倒序删除
+class Registry {
+public:
+    explicit Registry(ZkClient* zk) : zk_(zk) {}
+    ~Registry() {
+        for (size_t i = paths_.size(); i > 0; --i) zk_->Delete(paths_[i - 1].c_str());
+    }
+    void create(const std::string& path, const std::string& data = std::string(), int flags = 0) {
+        EXPECT_TRUE(zk_->Create(path.c_str(), data.data(), static_cast<int>(data.size()), flags));
+        paths_.push_back(path);
+    }
+    void remove(const std::string& path) {
+        zk_->Delete(path.c_str());
+        for (size_t i = 0; i < paths_.size(); ++i) {
+            if (paths_[i] == path) {
+                paths_.erase(paths_.begin() + i);
+                break;
+            }
+        }
+    }
+
+private:
+    ZkClient* zk_;
+    std::vector<std::string> paths_;
+};
+
+// 旧布局（/service/method/<ip:port>）下的差量：Echo 和 Ping 共享 10.0.0.1
+void testMembershipDiff(ZkClient* zk, const std::string& service) {
+    ServiceDiscovery& sd = ServiceDiscovery::instance();
+    // 注销后仍可能有正在执行的回调，记录者由回调共同持有
+    std::shared_ptr<MembershipRecorder> recorder = std::make_shared<MembershipRecorder>(service);
+    int listener = sd.addMembershipListener([recorder](const MembershipChange& c) { recorder->onChange(c); });
+    const std::string echo = service + "/Echo";
+    const std::string ping = service + "/Ping";
+    const std::string echoPath = "/" + echo;
+    {
+        Registry registry(zk);
+        registry.create("/" + service);
+        registry.create(echoPath);
+        registry.create("/" + ping);
+        registry.create(echoPath + "/10.0.0.1:8000", "10.0.0.1:8000", ZOO_EPHEMERAL);
+        registry.create(echoPath + "/10.0.0.2:8000", "10.0.0.2:8000", ZOO_EPHEMERAL);
+        registry.create("/" + ping + "/10.0.0.1:8000", "10.0.0.1:8000", ZOO_EPHEMERAL);
+
+        // 首次拉取：全部实例都是新增
+        ServiceKey echoKey = sd.resolve(service, "Echo");
+        sd.resolve(service, "Ping");
+        EXPECT_TRUE(recorder->waitFor(2));
+        EXPECT_EQ(hostSet("10.0.0.1:8000", "10.0.0.2:8000"), recorder->members(echo));
+        EXPECT_EQ(hostSet("10.0.0.1:8000"), recorder->members(ping));
+        EXPECT_EQ(recorder->members(echo), picked(echoKey));
+
+        // 新实例上线
+        registry.create(echoPath + "/10.0.0.3:8000", "10.0.0.3:8000", ZOO_EPHEMERAL);
+        EXPECT_TRUE(recorder->waitFor(3));
+        MembershipChange change = recorder->at(2);
+        EXPECT_EQ(echo, change.key);
+        EXPECT_EQ(hostSet("10.0.0.3:8000"), hostPorts(change.added));
+        EXPECT_TRUE(change.removed.empty() && change.updated.empty() && change.gone.empty());
+
+        // 只在 Echo 下的实例下线：记入 gone，可以回收连接
+        registry.remove(echoPath + "/10.0.0.2:8000");
+        EXPECT_TRUE(recorder->waitFor(4));
+        change = recorder->at(3);
+        EXPECT_EQ(hostSet("10.0.0.2:8000"), hostPorts(change.removed));
+        EXPECT_EQ(1u, change.gone.size());
+        EXPECT_TRUE(change.added.empty());
+
+        // Ping 还在用的实例从 Echo 下线：不记入 gone
+        registry.remove(echoPath + "/10.0.0.1:8000");
+        EXPECT_TRUE(recorder->waitFor(5));
+        change = recorder->at(4);
+        EXPECT_EQ(hostSet("10.0.0.1:8000"), hostPorts(change.removed));
+        EXPECT_TRUE(change.gone.empty());
+
+        // 同一实例删除后带新权重重新注册，合并窗口内只拉取一次：记为属性变化
+        sd.setWatchDebounce(0.5);
+        registry.remove(echoPath + "/10.0.0.3:8000");
+        registry.create(echoPath + "/10.0.0.3:8000", "10.0.0.3:8000;weight=3", ZOO_EPHEMERAL);
+        EXPECT_TRUE(recorder->waitFor(6));
+        sd.setWatchDebounce(0);
+        change = recorder->at(5);
+        EXPECT_EQ(hostSet("10.0.0.3:8000"), hostPorts(change.updated));
+        EXPECT_TRUE(change.added.empty() && change.removed.empty());
+        EXPECT_EQ(3, change.updated.empty() ? 0 : change.updated[0].weight);
+        EXPECT_EQ(hostSet("10.0.0.3:8000"), recorder->members(echo));
+        EXPECT_EQ(recorder->members(echo), picked(echoKey));
+
+        // 没有变化的方法不会收到回调
+        for (size_t i = 2; i < recorder->count(); ++i) {
+            EXPECT_EQ(echo, recorder->at(i).key);
+        }
+    }
+    sd.removeMembershipListener(listener);
+}
+
+// 滚动升级：10.0.1.1 已按新布局注册（同时还留着旧布局节点），10.0.1.2 仍是旧布局
+void testLayoutMerge(ZkClient* zk, const std::string& service) {
+    ServiceDiscovery& sd = ServiceDiscovery::instance();
+    std::shared_ptr<MembershipRecorder> recorder = std::make_shared<MembershipRecorder>(service);
+    int listener = sd.addMembershipListener([recorder](const MembershipChange& c) { recorder->onChange(c); });
+    const std::string echo = service + "/Echo";
+    const std::string ping = service + "/Ping";
+    const std::string instances = "/" + service + "/instances";
+    const std::string echoPath = "/" + echo;
+    {
+        Registry registry(zk);
+        registry.create("/" + service);
+        registry.create(instances);
+        registry.create(echoPath);
+        registry.create(instances + "/10.0.1.1:8000", "10.0.1.1:8000;methods=Echo,Ping", ZOO_EPHEMERAL);
+        registry.create(echoPath + "/10.0.1.1:8000", "10.0.1.1:8000", ZOO_EPHEMERAL);
+        registry.create(echoPath + "/10.0.1.2:8000", "10.0.1.2:8000", ZOO_EPHEMERAL);
+
+        // 两种布局的实例合并，同一个 ip:port 只出现一次；Ping 没有旧布局节点，只有新布局展开的实例
+        ServiceKey echoKey = sd.resolve(service, "Echo");
+        ServiceKey pingKey = sd.resolve(service, "Ping");
+        EXPECT_TRUE(recorder->waitFor(2));
+        EXPECT_EQ(hostSet("10.0.1.1:8000", "10.0.1.2:8000"), recorder->members(echo));
+        EXPECT_EQ(hostSet("10.0.1.1:8000"), recorder->members(ping));
+        EXPECT_EQ(recorder->members(echo), picked(echoKey));
+        EXPECT_EQ(recorder->members(ping), picked(pingKey));
+
+        // 新布局的实例按数据中列出的方法展开，只影响 Ping
+        registry.create(instances + "/10.0.1.3:8000", "10.0.1.3:8000;methods=Ping", ZOO_EPHEMERAL);
+        EXPECT_TRUE(recorder->waitFor(3));
+        MembershipChange change = recorder->at(2);
+        EXPECT_EQ(ping, change.key);
+        EXPECT_EQ(hostSet("10.0.1.3:8000"), hostPorts(change.added));
+
+        // 旧布局的实例下线
+        registry.remove(echoPath + "/10.0.1.2:8000");
+        EXPECT_TRUE(recorder->waitFor(4));
+        change = recorder->at(3);
+        EXPECT_EQ(echo, change.key);
+        EXPECT_EQ(hostSet("10.0.1.2:8000"), hostPorts(change.removed));
+        EXPECT_EQ(1u, change.gone.size());
+
+        // 已升级的实例删掉旧布局节点：新布局里还有它，成员不变，不回调
+        registry.remove(echoPath + "/10.0.1.1:8000");
+        ::usleep(300 * 1000);
+        EXPECT_EQ(4u, recorder->count());
+        EXPECT_EQ(hostSet("10.0.1.1:8000"), picked(echoKey));
+
+        // 新布局的实例下线，两个方法各收到一次
+        registry.remove(instances + "/10.0.1.1:8000");
+        EXPECT_TRUE(recorder->waitFor(6));
+        EXPECT_EQ(std::set<std::string>(), recorder->members(echo));
+        EXPECT_EQ(hostSet("10.0.1.3:8000"), recorder->members(ping));
+        EXPECT_EQ(hostSet("10.0.1.3:8000"), picked(pingKey));
+    }
+    sd.removeMembershipListener(listener);
+}
+
+} // namespace
+
+int main() {
+    const char* env = ::getenv("KRPC_TEST_ZOOKEEPER");
+    std::string address = env != nullptr ? env : "127.0.0.1:2181";
+    size_t colon = address.rfind(':');
+    std::string host = address.substr(0, colon);
+    std::string port = colon == std::string::npos ? "2181" : address.substr(colon + 1);
+
+    ZkClient zk;
+    if (!zk.Connect(host, port) || !zk.WaitConnected(3)) {
+        std::cout << "[SKIP] DiscoveryMembership: no ZooKeeper at " << host << ":" << port << std::endl;
+        return kSkipped;
+    }
+    ServiceDiscovery& sd = ServiceDiscovery::instance();
+    sd.setWatchDebounce(0);
+    sd.init(host, port);
+
+    const std::string service = "KrpcUnitTest" + std::to_string(::getpid());
+    testMembershipDiff(&zk, service + "Diff");
+    testLayoutMerge(&zk, service + "Merge");
+    return unitTestResult("DiscoveryMembership");
+}
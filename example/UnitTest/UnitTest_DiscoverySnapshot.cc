@@ -0,0 +1,129 @@
+// 服务发现本地快照的读写测试：往返一致，文件缺失、截断或被改动时拒绝加载且不改动输出
+#include <unistd.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "DiscoverySnapshot.h"
+#include "UnitTest.h"
+
+namespace {
+
+typedef std::vector<DiscoverySnapshot::Entry> Entries;
+
+std::string tempPath(const char* name) {
+    return "/tmp/krpc_unittest_" + std::to_string(::getpid()) + "_" + name;
+}
+
+Entries sampleEntries() {
+    Entries entries(3);
+    entries[0].key = "UserServiceRpc/Login";
+    entries[0].hosts.push_back("10.0.0.1:8000;weight=3;zone=bj-a");
+    entries[0].hosts.push_back("10.0.0.2:8000");
+    entries[1].key = "UserServiceRpc/Register";
+    // protobuf 编码的实例数据可能包含 '\0'
+    entries[1].hosts.push_back(std::string("\x08\x01\x12\x00\x1a", 5));
+    entries[2].key = "EmptyService/Method";
+    return entries;
+}
+
+bool sameEntries(const Entries& a, const Entries& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].key != b[i].key || a[i].hosts != b[i].hosts) return false;
+    }
+    return true;
+}
+
+std::string readFile(const std::string& path) {
+    std::string data;
+    FILE* fp = std::fopen(path.c_str(), "rb");
+    if (fp == nullptr) return data;
+    char buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), fp)) > 0) {
+        data.append(buf, n);
+    }
+    std::fclose(fp);
+    return data;
+}
+
+void writeFile(const std::string& path, const std::string& data) {
+    FILE* fp = std::fopen(path.c_str(), "wb");
+    if (fp == nullptr) return;
+    std::fwrite(data.data(), 1, data.size(), fp);
+    std::fclose(fp);
+}
+
+void testRoundTrip() {
+    std::string path = tempPath("roundtrip");
+    Entries saved = sampleEntries();
+    EXPECT_TRUE(DiscoverySnapshot::save(path, saved));
+    // 写完后临时文件已经 rename 掉
+    EXPECT_TRUE(::access((path + ".tmp").c_str(), F_OK) != 0);
+
+    Entries loaded;
+    EXPECT_TRUE(DiscoverySnapshot::load(path, &loaded));
+    EXPECT_TRUE(sameEntries(saved, loaded));
+
+    // 覆盖写：读到的是新内容
+    Entries empty;
+    EXPECT_TRUE(DiscoverySnapshot::save(path, empty));
+    EXPECT_TRUE(DiscoverySnapshot::load(path, &loaded));
+    EXPECT_TRUE(loaded.empty());
+    ::unlink(path.c_str());
+}
+
+void testMissingFile() {
+    Entries out = sampleEntries();
+    EXPECT_FALSE(DiscoverySnapshot::load(tempPath("missing"), &out));
+    EXPECT_TRUE(sameEntries(sampleEntries(), out));
+}
+
+// 改动文件的任意部分都要被发现，out 保持调用前的内容
+void expectRejected(const std::string& path, const std::string& data) {
+    writeFile(path, data);
+    Entries out = sampleEntries();
+    EXPECT_FALSE(DiscoverySnapshot::load(path, &out));
+    EXPECT_TRUE(sameEntries(sampleEntries(), out));
+}
+
+void testCorruption() {
+    std::string path = tempPath("corrupt");
+    EXPECT_TRUE(DiscoverySnapshot::save(path, sampleEntries()));
+    const std::string good = readFile(path);
+    const size_t kHeaderSize = 32;
+    EXPECT_TRUE(good.size() > kHeaderSize);
+
+    std::string data = good;
+    data[0] = 'X';                                  // magic
+    expectRejected(path, data);
+
+    data = good;
+    data[8] ^= 0x7f;                                // formatVersion
+    expectRejected(path, data);
+
+    data = good;
+    data[kHeaderSize + 10] ^= 0x01;                 // payload 中的一个字节，校验和对不上
+    expectRejected(path, data);
+
+    expectRejected(path, good.substr(0, good.size() - 1));     // 截断 payload
+    expectRejected(path, good.substr(0, kHeaderSize - 1));     // 连 header 都不完整
+    expectRejected(path, good + "x");                           // 末尾多出数据
+    expectRejected(path, std::string());
+
+    // 改回原样仍然可以加载，说明上面的失败确实来自改动
+    writeFile(path, good);
+    Entries out;
+    EXPECT_TRUE(DiscoverySnapshot::load(path, &out));
+    EXPECT_TRUE(sameEntries(sampleEntries(), out));
+    ::unlink(path.c_str());
+}
+
+} // namespace
+
+int main() {
+    testRoundTrip();
+    testMissingFile();
+    testCorruption();
+    return unitTestResult("DiscoverySnapshot");
+}
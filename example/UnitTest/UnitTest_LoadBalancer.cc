@@ -0,0 +1,132 @@
+// 负载均衡策略的确定性测试：只用与随机数无关的性质（哈希稳定、调度序列、一致性、有界负载）
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "LoadBalancer.h"
+#include "UnitTest.h"
+
+namespace {
+
+// 所有客户端对同一个 key 必须得到同样的哈希，值不能随实现细节变化
+void testHashIsStable() {
+    EXPECT_EQ(0xd725c98e9509182eULL, LoadBalancer::hash(""));
+    EXPECT_EQ(0x207c6b6d8f15501fULL, LoadBalancer::hash("user42"));
+    EXPECT_EQ(LoadBalancer::hash("user42"), PickContext::withKey("user42").hashKey);
+    EXPECT_TRUE(PickContext::withKey("user42").hasHashKey);
+    EXPECT_FALSE(PickContext().hasHashKey);
+}
+
+void testCreate() {
+    const char* known[] = {"", "random", "round_robin", "p2c", "ewma", "ring_hash", "maglev",
+                           "ring_hash:1.5", "maglev:0", "maglev:abc", "maglev:1", "maglev:-2"};
+    for (size_t i = 0; i < sizeof(known) / sizeof(known[0]); ++i) {
+        EXPECT_TRUE(LoadBalancer::create(known[i]) != nullptr);
+    }
+    EXPECT_TRUE(LoadBalancer::create("least_conn") == nullptr);
+    // 只有一致性哈希策略带负载系数
+    EXPECT_TRUE(LoadBalancer::create("random:1.5") == nullptr);
+}
+
+// 平滑加权轮询：权重 5/1/1 的一轮调度与 nginx 的 smooth WRR 一致，低权重的实例被打散
+void testWeightedRoundRobin() {
+    EndpointList endpoints = makeEndpoints(3);
+    endpoints[0].weight = 5;
+    std::shared_ptr<LoadBalancer> lb = LoadBalancer::create("round_robin");
+    lb->rebuild(endpoints);
+    const size_t expected[] = {0, 0, 1, 0, 2, 0, 0};
+    for (int round = 0; round < 2; ++round) {
+        for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+            EXPECT_EQ(expected[i], lb->pick(endpoints, PickContext()));
+        }
+    }
+}
+
+// 只有两个实例时 p2c 总是比较这两个，必然选在途更少的
+void testP2CPrefersLessLoaded() {
+    EndpointList endpoints = makeEndpoints(2);
+    endpoints[0].stats->onStart();
+    endpoints[0].stats->onStart();
+    std::shared_ptr<LoadBalancer> lb = LoadBalancer::create("p2c");
+    lb->rebuild(endpoints);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(1u, lb->pick(endpoints, PickContext()));
+    }
+}
+
+// 一致性哈希：同一个 key 总是落到同一个实例；去掉一个实例后，原本不在它上面的 key 归属不变（ring_hash）
+// 或几乎不变（maglev）
+void testConsistentHashing(const char* policy, int maxMoved) {
+    const int kKeys = 10000;
+    EndpointList before = makeEndpoints(10);
+    EndpointList after = makeEndpoints(10, 3);
+    std::shared_ptr<LoadBalancer> lb = LoadBalancer::create(policy);
+    lb->rebuild(before);
+
+    std::vector<std::string> owners;
+    std::map<std::string, int> counts;
+    for (int k = 0; k < kKeys; ++k) {
+        PickContext ctx = PickContext::withKey("key" + std::to_string(k));
+        const std::string& owner = before[lb->pick(before, ctx)].hostPort;
+        EXPECT_EQ(owner, before[lb->pick(before, ctx)].hostPort);
+        owners.push_back(owner);
+        ++counts[owner];
+    }
+    // 10 个实例各分到一部分 key，不会有实例一个都没有
+    EXPECT_EQ(10u, counts.size());
+
+    lb->rebuild(after);
+    int moved = 0;
+    for (int k = 0; k < kKeys; ++k) {
+        const std::string& owner = after[lb->pick(after, PickContext::withKey("key" + std::to_string(k)))].hostPort;
+        EXPECT_TRUE(owner != before[3].hostPort);
+        if (owners[k] != before[3].hostPort && owner != owners[k]) ++moved;
+    }
+    if (moved > maxMoved) {
+        std::cerr << policy << ": " << moved << " keys moved off surviving endpoints" << std::endl;
+    }
+    EXPECT_TRUE(moved <= maxMoved);
+}
+
+// 有界负载：热点 key 的在途数超过 ceil(c × (总在途 + 1) / 实例数) 后溢出到其他实例
+void testBoundedLoad(const char* policy, bool bounded) {
+    const int kCalls = 100;
+    EndpointList endpoints = makeEndpoints(4);
+    std::shared_ptr<LoadBalancer> lb = LoadBalancer::create(policy);
+    lb->rebuild(endpoints);
+    std::map<size_t, int> counts;
+    for (int i = 0; i < kCalls; ++i) {
+        size_t idx = lb->pick(endpoints, PickContext::withKey("hot"));
+        endpoints[idx].stats->onStart();
+        ++counts[idx];
+    }
+    if (!bounded) {
+        EXPECT_EQ(1u, counts.size());
+        return;
+    }
+    // 默认系数 1.25：任何时刻都不超过 ceil(1.25 × 100 / 4) = 32
+    EXPECT_TRUE(counts.size() > 1);
+    for (std::map<size_t, int>::const_iterator it = counts.begin(); it != counts.end(); ++it) {
+        EXPECT_TRUE(it->second <= 32);
+    }
+}
+
+} // namespace
+
+int main() {
+    testHashIsStable();
+    testCreate();
+    testWeightedRoundRobin();
+    testP2CPrefersLessLoaded();
+    testConsistentHashing("ring_hash:0", 0);
+    // Maglev 重建查找表时少量表项会换主，允许不超过 2% 的 key 移动
+    testConsistentHashing("maglev:0", 200);
+    testBoundedLoad("maglev:0", false);
+    testBoundedLoad("ring_hash:0", false);
+    testBoundedLoad("maglev", true);
+    testBoundedLoad("ring_hash:1.25", true);
+    // 写错的系数按默认值处理，而不是变成 0 关闭有界负载
+    testBoundedLoad("maglev:abc", true);
+    testBoundedLoad("ring_hash:1", true);
+    return unitTestResult("LoadBalancer");
+}
@@ -0,0 +1,167 @@
+// 异常实例摘除测试：连续失败/超时摘除、摘除期间与半开探测、恢复与再次摘除、延迟异常检测及摘除比例上限
+#include <unistd.h>
+#include "Endpoint.h"
+#include "OutlierDetector.h"
+#include "UnitTest.h"
+
+namespace {
+
+const int64_t kSecondUs = 1000 * 1000;
+
+void finish(EndpointStats* stats, int64_t latencyUs, bool ok, bool timedOut = false) {
+    stats->onStart();
+    stats->onFinish(latencyUs, ok, timedOut);
+}
+
+void testConsecutiveErrors() {
+    OutlierDetector detector;
+    OutlierDetector::Options options;
+    options.consecutiveErrors = 3;
+    options.baseEjection = 10;
+    detector.setOptions(options);
+    EndpointList endpoints = makeEndpoints(1, -1, &detector);
+    EndpointStats* stats = endpoints[0].stats.get();
+
+    // 中间的一次成功清零连续失败计数
+    finish(stats, 1000, false);
+    finish(stats, 1000, false);
+    finish(stats, 1000, true);
+    finish(stats, 1000, false);
+    finish(stats, 1000, false);
+    EXPECT_FALSE(stats->ejected());
+    EXPECT_TRUE(detector.admit(stats, OutlierDetector::nowUs()));
+
+    int64_t before = OutlierDetector::nowUs();
+    finish(stats, 1000, false);
+    int64_t after = OutlierDetector::nowUs();
+    EXPECT_TRUE(stats->ejected());
+    EXPECT_EQ(1, stats->ejections());
+
+    // 摘除 baseEjection 秒；到期后半开，同一时间只放行一个探测请求，探测超时（1s）后再放行下一个
+    EXPECT_FALSE(detector.admit(stats, before + 10 * kSecondUs - 1));
+    EXPECT_TRUE(detector.admit(stats, after + 10 * kSecondUs));
+    EXPECT_FALSE(detector.admit(stats, after + 10 * kSecondUs));
+    EXPECT_TRUE(detector.admit(stats, after + 11 * kSecondUs));
+
+    // 摘除期间迟到的结果不改变状态
+    finish(stats, 1000, true);
+    EXPECT_TRUE(stats->ejected());
+}
+
+void testConsecutiveTimeouts() {
+    OutlierDetector detector;
+    OutlierDetector::Options options;
+    options.consecutiveErrors = 0;
+    options.consecutiveTimeouts = 2;
+    detector.setOptions(options);
+    EndpointList endpoints = makeEndpoints(1, -1, &detector);
+    EndpointStats* stats = endpoints[0].stats.get();
+
+    // 普通失败不算超时，关闭了连续失败检测时不摘除
+    for (int i = 0; i < 10; ++i) {
+        finish(stats, 1000, false);
+    }
+    EXPECT_FALSE(stats->ejected());
+    finish(stats, 1000, false, true);
+    EXPECT_FALSE(stats->ejected());
+    finish(stats, 1000, false, true);
+    EXPECT_TRUE(stats->ejected());
+}
+
+// 半开状态的探测结果：成功恢复，失败则以更长的时长再次摘除
+void testHalfOpen() {
+    OutlierDetector detector;
+    OutlierDetector::Options options;
+    options.consecutiveErrors = 1;
+    options.baseEjection = 0.001;
+    options.maxEjection = 0.004;
+    detector.setOptions(options);
+    EndpointList endpoints = makeEndpoints(1, -1, &detector);
+    EndpointStats* stats = endpoints[0].stats.get();
+
+    finish(stats, 1000, false);
+    EXPECT_TRUE(stats->ejected());
+    ::usleep(5 * 1000);
+    EXPECT_TRUE(detector.admit(stats, OutlierDetector::nowUs()));
+    finish(stats, 1000, true);
+    EXPECT_FALSE(stats->ejected());
+    EXPECT_TRUE(detector.admit(stats, OutlierDetector::nowUs()));
+
+    finish(stats, 1000, false);
+    EXPECT_TRUE(stats->ejected());
+    EXPECT_EQ(2, stats->ejections());
+    ::usleep(5 * 1000);
+    int64_t before = OutlierDetector::nowUs();
+    EXPECT_TRUE(detector.admit(stats, before));
+    finish(stats, 1000, false);
+    EXPECT_TRUE(stats->ejected());
+    EXPECT_EQ(3, stats->ejections());
+    // 第三次摘除时长为 base × 2^2 = 4ms（正好等于 max）
+    EXPECT_FALSE(detector.admit(stats, before + 4000 - 1));
+}
+
+void testOverEjectionLimit() {
+    OutlierDetector detector;
+    OutlierDetector::Options options;
+    options.consecutiveErrors = 1;
+    options.maxEjectionPercent = 50;
+    detector.setOptions(options);
+    EndpointList endpoints = makeEndpoints(4, -1, &detector);
+
+    finish(endpoints[0].stats.get(), 1000, false);
+    finish(endpoints[1].stats.get(), 1000, false);
+    EXPECT_FALSE(detector.overEjectionLimit(endpoints));
+    finish(endpoints[2].stats.get(), 1000, false);
+    EXPECT_TRUE(detector.overEjectionLimit(endpoints));
+}
+
+void testLatencySweep() {
+    OutlierDetector detector;
+    OutlierDetector::Options options;
+    options.latencyFactor = 3;
+    options.minLatency = 0.005;
+    options.maxEjectionPercent = 20;
+    detector.setOptions(options);
+
+    // 少于 3 个实例时中位数没有意义，不检测
+    EndpointList pair = makeEndpoints(2, -1, &detector);
+    finish(pair[0].stats.get(), 1000, true);
+    finish(pair[1].stats.get(), 100 * 1000, true);
+    detector.sweep(pair);
+    EXPECT_FALSE(pair[1].stats->ejected());
+
+    // 4 个 1ms、3 个 50ms：中位数 1ms，阈值取 max(3ms, minLatency 5ms)；
+    // 3 个慢实例都超过阈值，但 20% 的上限只允许摘除 7 个中的 1 个
+    EndpointList endpoints = makeEndpoints(7, -1, &detector);
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        finish(endpoints[i].stats.get(), i < 4 ? 1000 : 50 * 1000, true);
+    }
+    detector.sweep(endpoints);
+    int ejected = 0;
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        if (endpoints[i].stats->ejected()) {
+            EXPECT_TRUE(i >= 4);
+            ++ejected;
+        }
+    }
+    EXPECT_EQ(1, ejected);
+
+    // 都很快时即使相差超过 3 倍也不摘除
+    EndpointList fast = makeEndpoints(3, -1, &detector);
+    finish(fast[0].stats.get(), 100, true);
+    finish(fast[1].stats.get(), 100, true);
+    finish(fast[2].stats.get(), 4000, true);
+    detector.sweep(fast);
+    EXPECT_FALSE(fast[2].stats->ejected());
+}
+
+} // namespace
+
+int main() {
+    testConsecutiveErrors();
+    testConsecutiveTimeouts();
+    testHalfOpen();
+    testOverEjectionLimit();
+    testLatencySweep();
+    return unitTestResult("OutlierDetector");
+}
@@ -0,0 +1,117 @@
+// 重试相关组件的测试：RetryPolicy 的退避与可重试状态码、LatencyHistogram 的分桶与分位数、RetryBudget 的令牌桶
+#include <unistd.h>
+#include <cstdint>
+#include <limits>
+#include "RetryPolicy.h"
+#include "UnitTest.h"
+
+namespace {
+
+void testRetryPolicy() {
+    RetryPolicy policy;
+    EXPECT_TRUE(policy.retryable(Krpc::UNAVAILABLE));
+    EXPECT_TRUE(policy.retryable(Krpc::DEADLINE_EXCEEDED));
+    EXPECT_FALSE(policy.retryable(Krpc::INTERNAL));
+    EXPECT_FALSE(policy.retryable(Krpc::OK));
+
+    // 不加抖动时按倍数增长，到 maxBackoff 为止
+    policy.initialBackoff = 0.01;
+    policy.maxBackoff = 0.05;
+    policy.backoffMultiplier = 2;
+    policy.jitter = 0;
+    EXPECT_EQ(0.01, policy.backoff(1));
+    EXPECT_EQ(0.02, policy.backoff(2));
+    EXPECT_EQ(0.04, policy.backoff(3));
+    EXPECT_EQ(0.05, policy.backoff(4));
+    EXPECT_EQ(0.05, policy.backoff(100));
+
+    // 抖动落在 backoff × [1 - jitter, 1 + jitter] 内
+    policy.jitter = 0.2;
+    for (int i = 0; i < 1000; ++i) {
+        double delay = policy.backoff(2);
+        EXPECT_TRUE(delay >= 0.02 * 0.8 - 1e-12 && delay <= 0.02 * 1.2 + 1e-12);
+    }
+}
+
+// 每个延迟都落在 [上一个桶的上界, 所在桶的上界) 内，桶的宽度不超过下界的 25%
+void testHistogramBuckets() {
+    for (int64_t us = 0; us < 1000 * 1000; ++us) {
+        int bucket = LatencyHistogram::bucketOf(us);
+        EXPECT_TRUE(us < LatencyHistogram::bucketUpperUs(bucket));
+        if (bucket > 0) {
+            int64_t lower = LatencyHistogram::bucketUpperUs(bucket - 1);
+            EXPECT_TRUE(lower <= us);
+            EXPECT_TRUE(LatencyHistogram::bucketUpperUs(bucket) - lower <= lower / 4 + 1);
+        }
+        if (unitTestFailures() > 0) {
+            std::cerr << "first failure at " << us << "us" << std::endl;
+            return;
+        }
+    }
+    EXPECT_EQ(0, LatencyHistogram::bucketOf(-5));
+    EXPECT_EQ(3, LatencyHistogram::bucketOf(3));
+    EXPECT_EQ(4, LatencyHistogram::bucketOf(4));
+    EXPECT_EQ(5, LatencyHistogram::bucketUpperUs(4));
+    EXPECT_EQ(8, LatencyHistogram::bucketOf(9));
+    EXPECT_EQ(10, LatencyHistogram::bucketUpperUs(8));
+    EXPECT_EQ(LatencyHistogram::kBuckets - 1, LatencyHistogram::bucketOf(std::numeric_limits<int64_t>::max()));
+}
+
+void testHistogramQuantile() {
+    const int kBatch = LatencyHistogram::kRecomputeEvery;
+    LatencyHistogram histogram;
+    histogram.setPercentile(95);
+    for (int i = 0; i < kBatch - 1; ++i) {
+        histogram.record(i < 1000 ? 100 : 10000);
+    }
+    // 每 kRecomputeEvery 个样本计算一次，之前没有分位数
+    EXPECT_EQ(0, histogram.quantileUs());
+    histogram.record(10000);
+    // 1000 个 100us、24 个 10ms：p95 落在 100us 所在的桶 [96, 112)
+    EXPECT_EQ(112, histogram.quantileUs());
+
+    // 计数减半后又来了一批 10ms：p99 落到 10ms 所在的桶
+    histogram.setPercentile(99);
+    for (int i = 0; i < kBatch; ++i) {
+        histogram.record(10000);
+    }
+    EXPECT_EQ(LatencyHistogram::bucketUpperUs(LatencyHistogram::bucketOf(10000)), histogram.quantileUs());
+}
+
+void testRetryBudget() {
+    // 不按时间补充：初始是满的，每个请求存 0.1 个令牌，最多 2 个
+    RetryBudget budget(0.1, 0, 2);
+    EXPECT_EQ(2.0, budget.tokens());
+    EXPECT_TRUE(budget.tryRetry());
+    EXPECT_TRUE(budget.tryRetry());
+    EXPECT_FALSE(budget.tryRetry());
+
+    for (int i = 0; i < 9; ++i) {
+        budget.onRequest();
+    }
+    EXPECT_FALSE(budget.tryRetry());
+    budget.onRequest();
+    EXPECT_TRUE(budget.tryRetry());
+    EXPECT_FALSE(budget.tryRetry());
+
+    for (int i = 0; i < 100; ++i) {
+        budget.onRequest();
+    }
+    EXPECT_EQ(2.0, budget.tokens());
+
+    // 每秒补充 1000 个，用完后等几毫秒就又能重试
+    RetryBudget refilled(0, 1000, 1);
+    EXPECT_TRUE(refilled.tryRetry());
+    ::usleep(5 * 1000);
+    EXPECT_TRUE(refilled.tryRetry());
+}
+
+} // namespace
+
+int main() {
+    testRetryPolicy();
+    testHistogramBuckets();
+    testHistogramQuantile();
+    testRetryBudget();
+    return unitTestResult("RetryPolicy");
+}
@@ -0,0 +1,188 @@
+// Future 组合子测试：Promise 只完成一次、then 的三种返回类型与异常、whenAll / whenAny 的完成时机与结果顺序、
+// 无效的 Future，以及输入永远不完成时组合的释放。
+// 不发起 RPC，由测试直接完成 Promise，续体都在完成它的线程上同步执行
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "RpcFuture.h"
+#include "UnitTest.h"
+
+using krpc::Future;
+using krpc::Promise;
+
+namespace {
+
+void testPromise() {
+    Promise<int> promise;
+    Future<int> future = promise.getFuture();
+    EXPECT_TRUE(future.valid());
+    EXPECT_FALSE(future.ready());
+    EXPECT_TRUE(future.value() == nullptr);
+
+    EXPECT_TRUE(promise.setValue(std::make_shared<int>(1)));
+    EXPECT_FALSE(promise.setValue(std::make_shared<int>(2)));
+    EXPECT_FALSE(promise.setFailed("late"));
+    EXPECT_TRUE(future.ready());
+    EXPECT_FALSE(future.failed());
+    EXPECT_EQ(1, *future.value());
+
+    Future<int> failed = krpc::makeFailedFuture<int>("boom");
+    EXPECT_TRUE(failed.failed());
+    EXPECT_EQ(std::string("boom"), failed.errorText());
+    EXPECT_TRUE(failed.value() == nullptr);
+}
+
+void testThen() {
+    Promise<int> promise;
+    int calls = 0;
+    Future<int> doubled = promise.getFuture().then([&calls](const Future<int>& f) {
+        ++calls;
+        return *f.value() * 2;
+    });
+    Future<krpc::Unit> done = doubled.then([](const Future<int>&) {});
+    EXPECT_FALSE(doubled.ready());
+    EXPECT_EQ(0, calls);
+
+    promise.setValue(std::make_shared<int>(21));
+    EXPECT_EQ(1, calls);
+    EXPECT_EQ(42, *doubled.value());
+    EXPECT_TRUE(done.ready() && !done.failed());
+
+    // 已完成的 Future 上 then，续体立即在当前线程执行
+    Future<std::string> text = doubled.then([](const Future<int>& f) { return std::to_string(*f.value()); });
+    EXPECT_TRUE(text.ready());
+    EXPECT_EQ(std::string("42"), *text.value());
+
+    // 续体返回 Future 时自动展开，等内层完成
+    Promise<std::string> inner;
+    Future<std::string> chained = doubled.then([inner](const Future<int>&) { return inner.getFuture(); });
+    EXPECT_FALSE(chained.ready());
+    inner.setValue(std::make_shared<std::string>("next"));
+    EXPECT_EQ(std::string("next"), *chained.value());
+
+    // 续体抛出的异常使下游失败；上游失败时续体照常执行，由它决定怎么处理
+    Future<int> thrown = doubled.then([](const Future<int>&) -> int { throw std::runtime_error("bad value"); });
+    EXPECT_TRUE(thrown.failed());
+    EXPECT_EQ(std::string("bad value"), thrown.errorText());
+    Future<bool> seen = krpc::makeFailedFuture<int>("upstream").then([](const Future<int>& f) { return f.failed(); });
+    EXPECT_TRUE(*seen.value());
+}
+
+void testWhenAll() {
+    std::vector<Promise<int>> promises(3);
+    std::vector<Future<int>> futures;
+    for (size_t i = 0; i < promises.size(); ++i) {
+        futures.push_back(promises[i].getFuture());
+    }
+    Future<std::vector<Future<int>>> all = krpc::whenAll(futures);
+
+    // 完成顺序与输入顺序无关，结果按输入顺序给出；有失败也要等全部完成
+    promises[2].setValue(std::make_shared<int>(2));
+    promises[0].setFailed("first failed");
+    EXPECT_FALSE(all.ready());
+    promises[1].setValue(std::make_shared<int>(1));
+    EXPECT_TRUE(all.ready());
+    EXPECT_FALSE(all.failed());
+    const std::vector<Future<int>>& results = *all.value();
+    EXPECT_EQ(3u, results.size());
+    EXPECT_TRUE(results[0].failed());
+    EXPECT_EQ(1, *results[1].value());
+    EXPECT_EQ(2, *results[2].value());
+
+    EXPECT_TRUE(krpc::whenAll(std::vector<Future<int>>()).ready());
+
+    // 异构版本
+    Promise<int> number;
+    Promise<std::string> text;
+    Future<std::tuple<Future<int>, Future<std::string>>> both = krpc::whenAll(number.getFuture(), text.getFuture());
+    text.setValue(std::make_shared<std::string>("done"));
+    EXPECT_FALSE(both.ready());
+    number.setValue(std::make_shared<int>(7));
+    EXPECT_TRUE(both.ready());
+    EXPECT_EQ(7, *std::get<0>(*both.value()).value());
+    EXPECT_EQ(std::string("done"), *std::get<1>(*both.value()).value());
+}
+
+void testWhenAny() {
+    std::vector<Promise<int>> promises(3);
+    std::vector<Future<int>> futures;
+    for (size_t i = 0; i < promises.size(); ++i) {
+        futures.push_back(promises[i].getFuture());
+    }
+    Future<std::pair<size_t, Future<int>>> any = krpc::whenAny(futures);
+    EXPECT_FALSE(any.ready());
+
+    // 失败也算完成；之后完成的不再改变结果
+    promises[1].setFailed("second failed");
+    promises[0].setValue(std::make_shared<int>(0));
+    EXPECT_TRUE(any.ready());
+    EXPECT_EQ(1u, any.value()->first);
+    EXPECT_TRUE(any.value()->second.failed());
+
+    // 已经完成的输入立即决定结果
+    Future<std::pair<size_t, Future<int>>> ready =
+            krpc::whenAny(std::vector<Future<int>>{promises[2].getFuture(), promises[0].getFuture()});
+    EXPECT_EQ(1u, ready.value()->first);
+
+    Future<std::pair<size_t, Future<int>>> none = krpc::whenAny(std::vector<Future<int>>());
+    EXPECT_TRUE(none.failed());
+}
+
+// 默认构造的 Future 视为已失败；续体返回它时下游失败，不会永远等下去
+void testInvalidFuture() {
+    Future<int> invalid;
+    EXPECT_FALSE(invalid.valid());
+    EXPECT_TRUE(invalid.ready());
+    EXPECT_TRUE(invalid.failed());
+    EXPECT_TRUE(invalid.value() == nullptr);
+    Future<bool> seen = invalid.then([](const Future<int>& f) { return f.failed(); });
+    EXPECT_TRUE(*seen.value());
+
+    Future<int> unwrapped = krpc::makeReadyFuture(std::make_shared<int>(1)).then([](const Future<int>&) {
+        return Future<int>();
+    });
+    EXPECT_TRUE(unwrapped.failed());
+
+    Future<std::vector<Future<int>>> all = krpc::whenAll(std::vector<Future<int>>{invalid, Future<int>()});
+    EXPECT_TRUE(all.ready());
+    EXPECT_TRUE(all.value()->at(1).failed());
+}
+
+// 构造和析构时增减计数，用来观察已完成输入的结果是否被释放
+struct Tracked {
+    explicit Tracked(int* alive) : alive(alive) { ++*alive; }
+    ~Tracked() { --*alive; }
+    int* alive;
+};
+
+// whenAll 的某个输入永远不完成：丢弃它的 Promise 后，整个组合连同已完成输入的结果一起释放
+void testWhenAllReleasesAbandoned() {
+    int alive = 0;
+    {
+        Promise<Tracked> done;
+        Promise<Tracked> never;
+        done.setValue(std::make_shared<Tracked>(&alive));
+        Future<std::vector<Future<Tracked>>> all = krpc::whenAll(
+                std::vector<Future<Tracked>>{done.getFuture(), never.getFuture()});
+        Future<std::tuple<Future<Tracked>, Future<Tracked>>> both =
+                krpc::whenAll(done.getFuture(), never.getFuture());
+        EXPECT_FALSE(all.ready());
+        EXPECT_FALSE(both.ready());
+        EXPECT_EQ(1, alive);
+    }
+    EXPECT_EQ(0, alive);
+}
+
+} // namespace
+
+int main() {
+    testPromise();
+    testThen();
+    testWhenAll();
+    testWhenAny();
+    testInvalidFuture();
+    testWhenAllReleasesAbandoned();
+    return unitTestResult("RpcFuture");
+}
@@ -0,0 +1,241 @@
+#include "ChannelPool.h"
+#include "ClientRuntime.h"
+#include "Logger.h"
+#include "ServiceDiscovery.h"
+#include "FutexWaiter.h"
+
+#include <muduo/base/Timestamp.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace {
+const double kDefaultIdleTimeout = 60.0;
+const double kDefaultRetireGrace = 10.0;
+}
+
+ChannelPool& ChannelPool::instance() {
+    static ChannelPool inst;   //c++11线程安全
+    return inst;
+}
+
+ChannelPool::ChannelPool()
+        : connectionsPerEndpoint_(1),
+          limitConcurrency_(false),
+          idleTimeout_(kDefaultIdleTimeout),
+          retireGrace_(kDefaultRetireGrace),
+          listenerId_(0),
+          reaperStarted_(false),
+          timerLoop_(nullptr),
+          nextRetireGeneration_(0) {
+    // 静态对象按构造的逆序析构：先构造 ClientRuntime，本对象析构时 channel 所在的 loop 还在
+    ClientRuntime::instance();
+    // 实例不再属于任何已订阅方法时回收其连接；仍在线的实例在成员变化中不受影响
+    listenerId_ = ServiceDiscovery::instance().addMembershipListener([this](const MembershipChange& change) {
+        for (size_t i = 0; i < change.gone.size(); ++i) {
+            retire(change.gone[i]);
+        }
+    });
+}
+
+ChannelPool::~ChannelPool() {
+    ServiceDiscovery::instance().removeMembershipListener(listenerId_);
+    std::vector<ClientChannelPtr> channels;
+    std::vector<TimerId> timers;
+    EventLoop* loop;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = endpoints_.begin(); it != endpoints_.end(); ++it) {
+            channels.insert(channels.end(), it->second.channels.begin(), it->second.channels.end());
+        }
+        endpoints_.clear();
+        if (reaperStarted_) timers.push_back(reaperTimer_);
+        for (auto it = retireTimers_.begin(); it != retireTimers_.end(); ++it) {
+            timers.push_back(it->second.second);
+        }
+        retireTimers_.clear();
+        loop = timerLoop_;
+    }
+    // 定时器回调引用 this：在其 loop 上取消，并等正在执行的回调结束
+    if (loop != nullptr && !timers.empty()) {
+        FutexWaiter cancelled;
+        loop->runInLoop([loop, &timers, &cancelled]() {
+            for (size_t i = 0; i < timers.size(); ++i) {
+                loop->cancel(timers[i]);
+            }
+            cancelled.wake();
+        });
+        cancelled.wait();
+    }
+    // 池中的引用在这里释放，channel 在各自的 loop 线程上析构（仍被 Stub 持有的等最后一个引用释放）
+    channels.clear();
+}
+
+void ChannelPool::setConnectionsPerEndpoint(int n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connectionsPerEndpoint_ = n > 0 ? n : 1;
+}
+
+void ChannelPool::setIdleTimeout(double seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idleTimeout_ = seconds;
+}
+
+void ChannelPool::setRetireGrace(double seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    retireGrace_ = seconds > 0 ? seconds : 0;
+}
+
+void ChannelPool::setConcurrencyLimit(const ConcurrencyLimiter::Options& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    limitConcurrency_ = true;
+    limiterOptions_ = options;
+}
+
+ClientChannelPtr ChannelPool::getChannel(const std::string& hostPort) {
+    // 与服务发现解析实例数据的规则相同（IPv6 写成 "[::1]:8000"）；非法地址不进池，也不建立连接
+    ::Endpoint endpoint;
+    if (!::Endpoint::parse(hostPort, &endpoint)) {
+        LOG(ERROR) << "ChannelPool: invalid endpoint " << hostPort;
+        return ClientRuntime::instance().newInvalidChannel("invalid endpoint address: " + hostPort);
+    }
+    return getChannel(endpoint.hostPort, endpoint.addr);
+}
+
+ClientChannelPtr ChannelPool::getChannel(const InetAddress& addr) {
+    return getChannel(addr.toIpPort(), addr);
+}
+
+ClientChannelPtr ChannelPool::getChannel(const ::Endpoint& endpoint) {
+    return getChannel(endpoint.hostPort, endpoint.addr);
+}
+
+ClientChannelPtr ChannelPool::getChannel(const std::string& key, const InetAddress& addr) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Endpoint& ep = endpoints_[key];
+    if (ep.channels.empty()) {
+        EndpointStatsPtr stats = ServiceDiscovery::instance().endpointStats(key);
+        std::shared_ptr<ConcurrencyLimiter> limiter;
+        if (limitConcurrency_) limiter = std::make_shared<ConcurrencyLimiter>(limiterOptions_);
+        for (int i = 0; i < connectionsPerEndpoint_; ++i) {
+            ClientChannelPtr channel = ClientRuntime::instance().newChannel(addr);
+            channel->setStats(stats);
+            channel->setLimiter(limiter);
+            ep.channels.push_back(channel);
+        }
+        ep.next = 0;
+        ep.retiredAtUs = 0;
+        LOG(INFO) << "ChannelPool: opened " << connectionsPerEndpoint_ << " connections to " << key;
+        startReaper();
+    } else if (ep.retiredAtUs != 0) {
+        LOG(INFO) << "ChannelPool: endpoint " << key << " is back, reusing its connections";
+        ep.retiredAtUs = 0;
+    }
+    ep.lastUsedUs = Timestamp::now().microSecondsSinceEpoch();
+    return ep.channels[ep.next++ % ep.channels.size()];
+}
+
+void ChannelPool::remove(const std::string& hostPort) {
+    std::vector<ClientChannelPtr> channels;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = endpoints_.find(hostPort);
+        if (it == endpoints_.end()) return;
+        channels.swap(it->second.channels);
+        endpoints_.erase(it);
+    }
+    for (size_t i = 0; i < channels.size(); ++i) {
+        channels[i]->disconnect();
+    }
+    LOG(INFO) << "ChannelPool: removed endpoint " << hostPort;
+}
+
+void ChannelPool::retire(const std::string& hostPort) {
+    double grace;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = endpoints_.find(hostPort);
+        if (it == endpoints_.end() || it->second.retiredAtUs != 0) return;
+        it->second.retiredAtUs = Timestamp::now().microSecondsSinceEpoch();
+        grace = retireGrace_;
+        EventLoop* loop = timerLoopLocked();
+        auto timer = retireTimers_.find(hostPort);
+        if (timer != retireTimers_.end()) {
+            // 上一次下线的回收还没到期（期间重新上线过），以这次为准
+            loop->cancel(timer->second.second);
+        }
+        uint64_t generation = ++nextRetireGeneration_;
+        retireTimers_[hostPort] = std::make_pair(generation,
+                loop->runAfter(grace, std::bind(&ChannelPool::reapRetired, this, hostPort, generation)));
+    }
+    LOG(INFO) << "ChannelPool: endpoint " << hostPort << " went away, closing in " << grace << "s unless it returns";
+}
+
+void ChannelPool::reapRetired(const std::string& hostPort, uint64_t generation) {
+    std::vector<ClientChannelPtr> channels;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto timer = retireTimers_.find(hostPort);
+        if (timer != retireTimers_.end() && timer->second.first == generation) {
+            retireTimers_.erase(timer);
+        }
+        auto it = endpoints_.find(hostPort);
+        // 期间重新上线过（retiredAtUs 被清零）则保留；再次下线会另外安排一次回收
+        if (it == endpoints_.end() || it->second.retiredAtUs == 0) return;
+        int64_t graceUs = static_cast<int64_t>(retireGrace_ * Timestamp::kMicroSecondsPerSecond);
+        if (Timestamp::now().microSecondsSinceEpoch() - it->second.retiredAtUs < graceUs) return;
+        channels.swap(it->second.channels);
+        endpoints_.erase(it);
+    }
+    LOG(INFO) << "ChannelPool: released retired endpoint " << hostPort;
+    // 锁外释放，channel 在各自的 loop 线程上析构（仍被 Stub 持有的等最后一个引用释放）
+    channels.clear();
+}
+
+size_t ChannelPool::endpointCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return endpoints_.size();
+}
+
+// 调用方需持有 mutex_
+EventLoop* ChannelPool::timerLoopLocked() {
+    if (timerLoop_ == nullptr) {
+        timerLoop_ = ClientRuntime::instance().nextLoop();
+    }
+    return timerLoop_;
+}
+
+// 调用方需持有 mutex_
+void ChannelPool::startReaper() {
+    if (reaperStarted_ || idleTimeout_ <= 0) return;
+    reaperStarted_ = true;
+    double interval = idleTimeout_ / 2;
+    reaperTimer_ = timerLoopLocked()->runEvery(interval, std::bind(&ChannelPool::reapIdle, this));
+}
+
+// 回收条件：超过 idleTimeout_ 没有 getChannel，且池外已没有任何引用（没有 Stub 还拿着它）
+void ChannelPool::reapIdle() {
+    std::vector<ClientChannelPtr> reaped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idleTimeout_ <= 0) return;
+        int64_t now = Timestamp::now().microSecondsSinceEpoch();
+        int64_t idleUs = static_cast<int64_t>(idleTimeout_ * Timestamp::kMicroSecondsPerSecond);
+        for (auto it = endpoints_.begin(); it != endpoints_.end(); ) {
+            Endpoint& ep = it->second;
+            bool unused = now - ep.lastUsedUs > idleUs;
+            for (size_t i = 0; unused && i < ep.channels.size(); ++i) {
+                unused = ep.channels[i].use_count() == 1;
+            }
+            if (unused) {
+                LOG(INFO) << "ChannelPool: reaping idle endpoint " << it->first;
+                reaped.insert(reaped.end(), ep.channels.begin(), ep.channels.end());
+                it = endpoints_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    // 锁外释放，channel 在各自的 loop 线程上析构
+    reaped.clear();
+}
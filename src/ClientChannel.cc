@@ -0,0 +1,351 @@
+#include "ClientChannel.h"
+#include "Logger.h"
+#include "RpcController.h"
+
+#include <muduo/base/Timestamp.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace {
+const double kDefaultConnectTimeout = 3.0;
+const size_t kMaxPendingCalls = 10000;
+
+// 包在用户 done 外面，调用结束时把延迟和成败回填到 endpoint 统计
+class StatsClosure : public ::google::protobuf::Closure {
+public:
+    StatsClosure(const EndpointStatsPtr& stats,
+                 ::google::protobuf::RpcController* controller,
+                 ::google::protobuf::Closure* done)
+            : stats_(stats), controller_(controller), done_(done),
+              startUs_(Timestamp::now().microSecondsSinceEpoch()) {
+        stats_->onStart();
+    }
+
+    void Run() override {
+        finish();
+        done_->Run();
+        delete this;
+    }
+
+    // 同步调用没有 done，直接在返回后结算
+    void finish() {
+        Krpc::StatusCode status = RpcController::StatusOf(controller_);
+        if (status == Krpc::CANCELLED) {
+            stats_->onCancel();
+            return;
+        }
+        bool ok = status == Krpc::OK;
+        stats_->onFinish(Timestamp::now().microSecondsSinceEpoch() - startUs_, ok, status == Krpc::DEADLINE_EXCEEDED);
+    }
+
+private:
+    EndpointStatsPtr                     stats_;
+    ::google::protobuf::RpcController*   controller_;
+    ::google::protobuf::Closure*         done_;
+    int64_t                              startUs_;
+};
+
+// 调用结束时把往返延迟交给 limiter 调整并发上限并释放名额
+class LimitClosure : public ::google::protobuf::Closure {
+public:
+    LimitClosure(const std::shared_ptr<ConcurrencyLimiter>& limiter,
+                 ::google::protobuf::RpcController* controller,
+                 ::google::protobuf::Closure* done)
+            : limiter_(limiter), controller_(controller), done_(done),
+              startUs_(Timestamp::now().microSecondsSinceEpoch()) {}
+
+    void Run() override {
+        finish();
+        done_->Run();
+        delete this;
+    }
+
+    void finish() {
+        limiter_->onResult(RpcController::StatusOf(controller_),
+                           Timestamp::now().microSecondsSinceEpoch() - startUs_);
+    }
+
+private:
+    std::shared_ptr<ConcurrencyLimiter>  limiter_;
+    ::google::protobuf::RpcController*   controller_;
+    ::google::protobuf::Closure*         done_;
+    int64_t                              startUs_;
+};
+
+// 同步调用在 limiter 中排队时等待的状态，由 waiter 共同持有
+struct SyncAdmission {
+    SyncAdmission() : admitted(false) {}
+
+    FutexWaiter        waiter;
+    std::atomic<bool>  admitted;
+};
+
+// limiter 的队列由空变为非空时启动，队列不空就继续按下一个调用的超时时间重新调度
+void scheduleLimiterExpire(EventLoop* loop, const std::weak_ptr<ConcurrencyLimiter>& weak, double delay) {
+    loop->runAfter(delay, [loop, weak]() {
+        std::shared_ptr<ConcurrencyLimiter> limiter = weak.lock();
+        if (!limiter) return;
+        double next = limiter->expire();
+        if (next > 0) {
+            scheduleLimiterExpire(loop, weak, next);
+        }
+    });
+}
+}
+
+ClientChannel::ClientChannel(EventLoop* loop, const InetAddress& serverAddr, const std::string& name)
+        : loop_(loop),
+          serverAddr_(serverAddr),
+          client_(loop, serverAddr, name),
+          channel_(new RPCChannel()),
+          connected_(false),
+          connectTimeout_(kDefaultConnectTimeout),
+          expireScheduled_(false)
+{
+    client_.setConnectionCallback(
+            std::bind(&ClientChannel::onConnection, this, std::placeholders::_1));
+    client_.setMessageCallback(
+            std::bind(&RPCChannel::onMessage, channel_.get(),
+                      std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    client_.enableRetry();      // 连接断开后自动重连
+}
+
+ClientChannel::~ClientChannel() {
+    loop_->assertInLoopThread();
+    // TcpClient 析构时可能异步关闭连接，此时本对象已不存在，先摘掉连接上的回调
+    TcpConnectionPtr conn = client_.connection();
+    if (conn) {
+        conn->setConnectionCallback([](const TcpConnectionPtr&) {});
+        conn->setMessageCallback([](const TcpConnectionPtr&, Buffer* buf, Timestamp) { buf->retrieveAll(); });
+    }
+    channel_->setConnection(TcpConnectionPtr());
+    channel_->failOutstandings("client channel destroyed");
+    {
+        MutexLockGuard lock(mutex_);
+        if (expireScheduled_) loop_->cancel(expireTimer_);
+    }
+    expirePending(true);
+}
+
+void ClientChannel::setStats(const EndpointStatsPtr& stats) {
+    stats_ = stats;
+    if (!stats) {
+        channel_->setLoadCallback(RPCChannel::LoadCallback());
+        return;
+    }
+    channel_->setLoadCallback([stats](const Krpc::ServerLoad& load) {
+        stats->onServerLoad(static_cast<int>(load.inflight()), load.queue_delay_us(),
+                            static_cast<int>(load.cpu_permille()));
+    });
+}
+
+void ClientChannel::connect() {
+    client_.connect();
+}
+
+void ClientChannel::disconnect() {
+    client_.disconnect();
+}
+
+void ClientChannel::CallMethod(const ::google::protobuf::MethodDescriptor* method,
+                               ::google::protobuf::RpcController* controller,
+                               const ::google::protobuf::Message* request,
+                               ::google::protobuf::Message* response,
+                               ::google::protobuf::Closure* done) {
+    if (done != nullptr || !addressError_.empty()) {
+        CallAsync(method, controller, request, response, done);
+        return;
+    }
+    // 同步调用：等首次连接（在本 loop 线程上等待会死锁，直接交给 RPCChannel 报错）
+    if (!connected() && !loop_->isInLoopThread()) {
+        firstConnected_.waitFor(connectTimeout_);
+    }
+    dispatch(method, controller, request, response, nullptr);
+}
+
+int64_t ClientChannel::CallAsync(const ::google::protobuf::MethodDescriptor* method,
+                                 ::google::protobuf::RpcController* controller,
+                                 const ::google::protobuf::Message* request,
+                                 ::google::protobuf::Message* response,
+                                 ::google::protobuf::Closure* done) {
+    if (!addressError_.empty()) {
+        RpcController::Fail(controller, addressError_, Krpc::INVALID_ARGUMENT);
+        if (done != nullptr) done->Run();
+        return 0;
+    }
+    if (!connected()) {
+        MutexLockGuard lock(mutex_);
+        // 加锁后再确认一次，避免与 flushPending 交错
+        if (!connected_.load(std::memory_order_acquire)) {
+            if (pending_.size() >= kMaxPendingCalls) {
+                RpcController::Fail(controller, "too many calls pending on connect", Krpc::RESOURCE_EXHAUSTED);
+                done->Run();
+                return 0;
+            }
+            std::shared_ptr<::google::protobuf::Message> copy(request->New());
+            copy->CopyFrom(*request);
+            pending_.push_back(PendingCall{method, controller, copy, response, done,
+                                           Timestamp::now().microSecondsSinceEpoch()});
+            // 定时器按最早排队的调用设置，到期后再按剩下最早的重新设置
+            if (!expireScheduled_) {
+                expireScheduled_ = true;
+                expireTimer_ = loop_->runAfter(connectTimeout_, std::bind(&ClientChannel::expirePending, this, false));
+            }
+            return 0;
+        }
+    }
+    return dispatch(method, controller, request, response, done);
+}
+
+int64_t ClientChannel::dispatch(const ::google::protobuf::MethodDescriptor* method,
+                             ::google::protobuf::RpcController* controller,
+                             const ::google::protobuf::Message* request,
+                             ::google::protobuf::Message* response,
+                             ::google::protobuf::Closure* done) {
+    if (limiter_ && !limiter_->tryAcquire()) {
+        return throttle(method, controller, request, response, done);
+    }
+    return send(channel_, stats_, limiter_, method, controller, request, response, done);
+}
+
+int64_t ClientChannel::throttle(const ::google::protobuf::MethodDescriptor* method,
+                                ::google::protobuf::RpcController* controller,
+                                const ::google::protobuf::Message* request,
+                                ::google::protobuf::Message* response,
+                                ::google::protobuf::Closure* done) {
+    std::shared_ptr<ConcurrencyLimiter> limiter = limiter_;
+    const std::string addr = serverAddr_.toIpPort();
+    bool queued = false;
+    bool armTimer = false;
+    if (done != nullptr) {
+        std::shared_ptr<::google::protobuf::Message> copy(request->New());
+        copy->CopyFrom(*request);
+        std::shared_ptr<RPCChannel> channel = channel_;
+        EndpointStatsPtr stats = stats_;
+        queued = limiter->enqueue([=](bool admitted) {
+            if (admitted) {
+                send(channel, stats, limiter, method, controller, copy.get(), response, done);
+            } else {
+                RpcController::Fail(controller, "queued too long for concurrency limit of " + addr, Krpc::RESOURCE_EXHAUSTED);
+                done->Run();
+            }
+        }, &armTimer);
+        if (armTimer) {
+            scheduleLimiterExpire(loop_, limiter, limiter->maxQueueWait());
+        }
+        if (!queued) {
+            RpcController::Fail(controller, "concurrency limit of " + addr + " reached", Krpc::RESOURCE_EXHAUSTED);
+            done->Run();
+        }
+        return 0;
+    }
+    // 同步调用：排队超时要靠本 loop 上的定时器，在 loop 线程上等待会死锁，只能直接失败
+    std::shared_ptr<SyncAdmission> admission;
+    if (!loop_->isInLoopThread()) {
+        admission = std::make_shared<SyncAdmission>();
+        queued = limiter->enqueue([admission](bool admitted) {
+            admission->admitted.store(admitted);
+            admission->waiter.wake();
+        }, &armTimer);
+    }
+    if (!queued) {
+        RpcController::Fail(controller, "concurrency limit of " + addr + " reached", Krpc::RESOURCE_EXHAUSTED);
+        return 0;
+    }
+    if (armTimer) {
+        scheduleLimiterExpire(loop_, limiter, limiter->maxQueueWait());
+    }
+    admission->waiter.wait();
+    if (!admission->admitted.load()) {
+        RpcController::Fail(controller, "queued too long for concurrency limit of " + addr, Krpc::RESOURCE_EXHAUSTED);
+        return 0;
+    }
+    return send(channel_, stats_, limiter, method, controller, request, response, nullptr);
+}
+
+int64_t ClientChannel::send(const std::shared_ptr<RPCChannel>& channel,
+                            const EndpointStatsPtr& stats,
+                            const std::shared_ptr<ConcurrencyLimiter>& limiter,
+                            const ::google::protobuf::MethodDescriptor* method,
+                            ::google::protobuf::RpcController* controller,
+                            const ::google::protobuf::Message* request,
+                            ::google::protobuf::Message* response,
+                            ::google::protobuf::Closure* done) {
+    if (done != nullptr) {
+        if (limiter) done = new LimitClosure(limiter, controller, done);
+        if (stats) done = new StatsClosure(stats, controller, done);
+        return channel->CallAsync(method, controller, request, response, done);
+    }
+    if (!stats && !limiter) {
+        channel->CallMethod(method, controller, request, response, nullptr);
+        return 0;
+    }
+    RpcController local;
+    if (controller == nullptr) controller = &local;
+    std::unique_ptr<StatsClosure> statsClosure(stats ? new StatsClosure(stats, controller, nullptr) : nullptr);
+    std::unique_ptr<LimitClosure> limitClosure(limiter ? new LimitClosure(limiter, controller, nullptr) : nullptr);
+    channel->CallMethod(method, controller, request, response, nullptr);
+    if (statsClosure) statsClosure->finish();
+    if (limitClosure) limitClosure->finish();
+    return 0;
+}
+
+void ClientChannel::flushPending() {
+    std::deque<PendingCall> calls;
+    {
+        MutexLockGuard lock(mutex_);
+        calls.swap(pending_);
+    }
+    for (size_t i = 0; i < calls.size(); ++i) {
+        const PendingCall& c = calls[i];
+        dispatch(c.method, c.controller, c.request.get(), c.response, c.done);
+    }
+}
+
+// 连接超时：排队超过 connectTimeout 的调用以失败结束
+void ClientChannel::expirePending(bool all) {
+    std::vector<PendingCall> calls;
+    {
+        MutexLockGuard lock(mutex_);
+        int64_t now = Timestamp::now().microSecondsSinceEpoch();
+        int64_t deadline = now - static_cast<int64_t>(connectTimeout_ * Timestamp::kMicroSecondsPerSecond);
+        while (!pending_.empty() && (all || pending_.front().enqueuedUs <= deadline)) {
+            calls.push_back(pending_.front());
+            pending_.pop_front();
+        }
+        expireScheduled_ = false;
+        if (!all && !pending_.empty()) {
+            expireScheduled_ = true;
+            double delay = static_cast<double>(pending_.front().enqueuedUs - deadline) / Timestamp::kMicroSecondsPerSecond;
+            expireTimer_ = loop_->runAfter(delay, std::bind(&ClientChannel::expirePending, this, false));
+        }
+    }
+    if (!calls.empty()) {
+        LOG(WARNING) << "connect to " << serverAddr_.toIpPort() << " timed out, failing "
+                     << calls.size() << " pending calls";
+    }
+    for (size_t i = 0; i < calls.size(); ++i) {
+        RpcController::Fail(calls[i].controller, "connect to " + serverAddr_.toIpPort() + " timed out", Krpc::UNAVAILABLE);
+        calls[i].done->Run();
+    }
+}
+
+void ClientChannel::onConnection(const TcpConnectionPtr& conn) {
+    if (conn->connected()) {
+        LOG(INFO) << "ClientChannel connected to " << serverAddr_.toIpPort();
+        conn->setTcpNoDelay(true);
+        channel_->setConnection(conn);
+        {
+            MutexLockGuard lock(mutex_);
+            connected_.store(true, std::memory_order_release);
+        }
+        firstConnected_.wake();
+        flushPending();
+    } else {
+        LOG(WARNING) << "ClientChannel disconnected from " << serverAddr_.toIpPort();
+        connected_.store(false, std::memory_order_release);
+        channel_->setConnection(TcpConnectionPtr());
+        channel_->failOutstandings("connection to " + serverAddr_.toIpPort() + " lost");
+    }
+}
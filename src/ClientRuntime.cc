@@ -0,0 +1,93 @@
+#include "ClientRuntime.h"
+#include "Logger.h"
+
+#include <functional>
+#include <thread>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace {
+void destroyChannel(ClientChannel* channel) {
+    delete channel;
+}
+}
+
+ClientRuntime& ClientRuntime::instance() {
+    static ClientRuntime inst;   //c++11线程安全
+    return inst;
+}
+
+ClientRuntime::ClientRuntime() : started_(false), next_(0) {}
+
+ClientRuntime::~ClientRuntime() {
+    // EventLoopThread 析构时会 quit 并 join 对应线程
+    threads_.clear();
+}
+
+void ClientRuntime::start(int numThreads) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (started_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (numThreads <= 0) {
+        numThreads = static_cast<int>(std::thread::hardware_concurrency());
+        if (numThreads <= 0) numThreads = 1;
+    }
+    for (int i = 0; i < numThreads; ++i) {
+        std::unique_ptr<EventLoopThread> t(
+                new EventLoopThread(EventLoopThread::ThreadInitCallback(), "krpc-client-io" + std::to_string(i)));
+        loops_.push_back(t->startLoop());
+        threads_.push_back(std::move(t));
+    }
+    started_.store(true, std::memory_order_release);
+    LOG(INFO) << "ClientRuntime started with " << numThreads << " io threads";
+}
+
+int ClientRuntime::threadNum() const {
+    return started() ? static_cast<int>(loops_.size()) : 0;
+}
+
+EventLoop* ClientRuntime::nextLoop() {
+    if (!started()) start();
+    size_t idx = next_.fetch_add(1, std::memory_order_relaxed);
+    return loops_[idx % loops_.size()];
+}
+
+EventLoop* ClientRuntime::loopForKey(const std::string& key) {
+    if (!started()) start();
+    return loops_[std::hash<std::string>()(key) % loops_.size()];
+}
+
+bool ClientRuntime::inLoopThread() const {
+    if (!started()) return false;
+    for (size_t i = 0; i < loops_.size(); ++i) {
+        if (loops_[i]->isInLoopThread()) return true;
+    }
+    return false;
+}
+
+ClientChannelPtr ClientRuntime::newChannel(const InetAddress& serverAddr) {
+    const std::string key = serverAddr.toIpPort();
+    EventLoop* loop = loopForKey(key);
+    ClientChannel* channel = new ClientChannel(loop, serverAddr, "RpcClient-" + key);
+    channel->connect();
+    return own(loop, channel);
+}
+
+ClientChannelPtr ClientRuntime::newInvalidChannel(const std::string& errorText) {
+    EventLoop* loop = nextLoop();
+    ClientChannel* channel = new ClientChannel(loop, InetAddress(), "RpcClient-invalid");
+    channel->setAddressError(errorText);
+    return own(loop, channel);
+}
+
+ClientChannelPtr ClientRuntime::own(EventLoop* loop, ClientChannel* channel) {
+    return ClientChannelPtr(channel, [loop](ClientChannel* c) {
+        if (loop->isInLoopThread()) {
+            delete c;
+        } else {
+            loop->queueInLoop(std::bind(&destroyChannel, c));
+        }
+    });
+}
@@ -0,0 +1,185 @@
+#include "ConcurrencyLimiter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace {
+// 短期 / 长期 RTT 的 EWMA 权重
+const double kShortRttWeight = 0.1;
+const double kLongRttWeight  = 1.0 / 600;
+// 负载恢复后长期 RTT 明显高于短期 RTT 时，按该比例往下拉，否则要很久才能回到空载水平
+const double kLongRttDecay   = 0.95;
+const double kMinGradient    = 0.5;
+}
+
+ConcurrencyLimiter::Options::Options()
+        : initialLimit(20),
+          minLimit(4),
+          maxLimit(1000),
+          tolerance(1.5),
+          smoothing(0.2),
+          backoffRatio(0.9),
+          maxQueue(0),
+          maxQueueWait(0.1) {}
+
+ConcurrencyLimiter::ConcurrencyLimiter(const Options& options)
+        : options_(options),
+          limit_(std::min(std::max(options.initialLimit, options.minLimit), options.maxLimit)),
+          inflight_(0),
+          estimatedLimit_(limit_.load()),
+          shortRttUs_(0),
+          longRttUs_(0),
+          lastBackoffUs_(0),
+          queued_(0) {}
+
+int64_t ConcurrencyLimiter::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool ConcurrencyLimiter::tryAcquire() {
+    // 有人排队时不插队，名额由 release 按顺序交给队首
+    return queued_.load() == 0 && acquireSlot();
+}
+
+bool ConcurrencyLimiter::acquireSlot() {
+    int inflight = inflight_.load();
+    while (inflight < limit_.load(std::memory_order_relaxed)) {
+        if (inflight_.compare_exchange_weak(inflight, inflight + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ConcurrencyLimiter::enqueue(const Waiter& waiter, bool* armTimer) {
+    Waiter next;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (static_cast<int>(queue_.size()) >= options_.maxQueue) {
+            return false;
+        }
+        *armTimer = queue_.empty();
+        queue_.push_back(QueuedCall{waiter, nowUs()});
+        queued_.store(queue_.size());
+        // 入队之后再试一次：与 release 并发时名额可能在入队前刚被释放，release 又没看到队列中的调用
+        if (acquireSlot()) {
+            next = popLocked();
+        }
+    }
+    if (next) {
+        next(true);
+    }
+    return true;
+}
+
+double ConcurrencyLimiter::expire() {
+    std::vector<Waiter> expired;
+    double next = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int64_t deadline = nowUs() - static_cast<int64_t>(options_.maxQueueWait * 1000 * 1000);
+        while (!queue_.empty() && queue_.front().enqueuedUs <= deadline) {
+            expired.push_back(queue_.front().waiter);
+            queue_.pop_front();
+        }
+        queued_.store(queue_.size());
+        if (!queue_.empty()) {
+            next = (queue_.front().enqueuedUs - deadline) / 1e6;
+        }
+    }
+    for (size_t i = 0; i < expired.size(); ++i) {
+        expired[i](false);
+    }
+    return next;
+}
+
+void ConcurrencyLimiter::onComplete(int64_t rttUs, bool dropped) {
+    int inflight = inflight_.load(std::memory_order_relaxed);
+    update(rttUs, dropped, inflight);
+    release();
+}
+
+void ConcurrencyLimiter::onResult(Krpc::StatusCode status, int64_t rttUs) {
+    if (status == Krpc::OK) {
+        onComplete(rttUs, false);
+    } else if (status == Krpc::DEADLINE_EXCEEDED || status == Krpc::RESOURCE_EXHAUSTED) {
+        onComplete(0, true);
+    } else {
+        // 取消、连接断开等情况的延迟说明不了服务端的负载
+        onIgnore();
+    }
+}
+
+// 名额优先交给队首的调用，不经过 inflight_，新来的调用插不了队
+void ConcurrencyLimiter::release() {
+    Waiter next;
+    if (queued_.load() > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!queue_.empty() && inflight_.load() <= limit_.load(std::memory_order_relaxed)) {
+            next = popLocked();
+        }
+    }
+    if (next) {
+        next(true);
+        return;
+    }
+    inflight_.fetch_sub(1);
+    // 与 enqueue 并发时，可能在上面的检查之后才有调用入队：再看一次，避免它空等到超时
+    if (queued_.load() > 0) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!queue_.empty() && acquireSlot()) {
+                next = popLocked();
+            }
+        }
+        if (next) {
+            next(true);
+        }
+    }
+}
+
+// 调用方需持有 mutex_
+ConcurrencyLimiter::Waiter ConcurrencyLimiter::popLocked() {
+    Waiter next;
+    next.swap(queue_.front().waiter);
+    queue_.pop_front();
+    queued_.store(queue_.size());
+    return next;
+}
+
+void ConcurrencyLimiter::update(int64_t rttUs, bool dropped, int inflight) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double limit = estimatedLimit_;
+    if (dropped) {
+        // 同一波超时会连续到达，一个 RTT 内只收缩一次，避免上限直接掉到最小值
+        int64_t now = nowUs();
+        if (now - lastBackoffUs_ < static_cast<int64_t>(shortRttUs_)) {
+            return;
+        }
+        lastBackoffUs_ = now;
+        limit *= options_.backoffRatio;
+    } else {
+        double rtt = static_cast<double>(std::max<int64_t>(rttUs, 1));
+        if (longRttUs_ == 0) {
+            shortRttUs_ = longRttUs_ = rtt;
+        }
+        shortRttUs_ += (rtt - shortRttUs_) * kShortRttWeight;
+        longRttUs_  += (rtt - longRttUs_) * kLongRttWeight;
+        if (longRttUs_ > shortRttUs_ * 2) {
+            longRttUs_ *= kLongRttDecay;
+        }
+        // 没有用满上限时，延迟不能说明上限是否合适
+        if (inflight * 2 < limit) {
+            return;
+        }
+        double gradient = std::max(kMinGradient, std::min(1.0, options_.tolerance * longRttUs_ / shortRttUs_));
+        double target = limit * gradient + std::sqrt(limit);
+        limit = limit * (1 - options_.smoothing) + target * options_.smoothing;
+    }
+    estimatedLimit_ = std::min(std::max(limit, static_cast<double>(options_.minLimit)),
+                               static_cast<double>(options_.maxLimit));
+    limit_.store(static_cast<int>(estimatedLimit_), std::memory_order_relaxed);
+}
@@ -0,0 +1,170 @@
+#include "DiscoverySnapshot.h"
+#include "LoadBalancer.h"
+#include "Logger.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const char     kMagic[8]      = {'K', 'R', 'P', 'C', 'S', 'N', 'A', 'P'};
+const uint32_t kFormatVersion = 1;
+
+struct Header {
+    char     magic[8];
+    uint32_t formatVersion;
+    uint32_t entryCount;
+    uint64_t payloadSize;
+    uint64_t checksum;
+};
+
+void appendU32(std::string* buf, uint32_t v) {
+    buf->append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+// 顺序读取 mmap 区域，越界时置 ok = false
+class Reader {
+public:
+    Reader(const char* data, size_t size) : cur_(data), end_(data + size), ok_(true) {}
+
+    uint32_t u32() {
+        uint32_t v = 0;
+        if (static_cast<size_t>(end_ - cur_) < sizeof(v)) {
+            ok_ = false;
+            return 0;
+        }
+        std::memcpy(&v, cur_, sizeof(v));
+        cur_ += sizeof(v);
+        return v;
+    }
+    std::string bytes(uint32_t len) {
+        if (static_cast<size_t>(end_ - cur_) < len) {
+            ok_ = false;
+            return std::string();
+        }
+        std::string s(cur_, len);
+        cur_ += len;
+        return s;
+    }
+    bool ok() const { return ok_; }
+    bool done() const { return cur_ == end_; }
+
+private:
+    const char* cur_;
+    const char* end_;
+    bool        ok_;
+};
+
+bool writeAll(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len  -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+bool DiscoverySnapshot::load(const std::string& path, std::vector<Entry>* out) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        LOG(WARNING) << "discovery snapshot " << path << " is truncated, ignored";
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        LOG(WARNING) << "mmap discovery snapshot " << path << " failed: " << std::strerror(errno);
+        return false;
+    }
+
+    const char* base = static_cast<const char*>(addr);
+    Header header;
+    std::memcpy(&header, base, sizeof(header));
+    const char* payload = base + sizeof(Header);
+    bool ok = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+           && header.formatVersion == kFormatVersion
+           && header.payloadSize == size - sizeof(Header)
+           && header.checksum == LoadBalancer::hash(payload, static_cast<size_t>(header.payloadSize));
+
+    std::vector<Entry> entries;
+    if (ok) {
+        Reader reader(payload, static_cast<size_t>(header.payloadSize));
+        entries.reserve(header.entryCount);
+        for (uint32_t i = 0; i < header.entryCount && reader.ok(); ++i) {
+            Entry entry;
+            uint32_t keyLen    = reader.u32();
+            uint32_t hostCount = reader.u32();
+            entry.key = reader.bytes(keyLen);
+            for (uint32_t j = 0; j < hostCount && reader.ok(); ++j) {
+                entry.hosts.push_back(reader.bytes(reader.u32()));
+            }
+            entries.push_back(std::move(entry));
+        }
+        ok = reader.ok() && reader.done();
+    }
+    ::munmap(addr, size);
+
+    if (!ok) {
+        LOG(WARNING) << "discovery snapshot " << path << " is corrupt or from another version, ignored";
+        return false;
+    }
+    out->swap(entries);
+    return true;
+}
+
+bool DiscoverySnapshot::save(const std::string& path, const std::vector<Entry>& entries) {
+    std::string payload;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const Entry& entry = entries[i];
+        appendU32(&payload, static_cast<uint32_t>(entry.key.size()));
+        appendU32(&payload, static_cast<uint32_t>(entry.hosts.size()));
+        payload.append(entry.key);
+        for (size_t j = 0; j < entry.hosts.size(); ++j) {
+            appendU32(&payload, static_cast<uint32_t>(entry.hosts[j].size()));
+            payload.append(entry.hosts[j]);
+        }
+    }
+
+    Header header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.formatVersion = kFormatVersion;
+    header.entryCount    = static_cast<uint32_t>(entries.size());
+    header.payloadSize   = payload.size();
+    header.checksum      = LoadBalancer::hash(payload.data(), payload.size());
+
+    // 先写临时文件再 rename，进程在写入途中退出也不会留下半个快照
+    std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG(ERROR) << "open " << tmp << " failed: " << std::strerror(errno);
+        return false;
+    }
+    bool ok = writeAll(fd, reinterpret_cast<const char*>(&header), sizeof(header))
+           && writeAll(fd, payload.data(), payload.size())
+           && ::fdatasync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(tmp.c_str(), path.c_str()) != 0) {
+        LOG(ERROR) << "write discovery snapshot " << path << " failed: " << std::strerror(errno);
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
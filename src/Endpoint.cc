@@ -0,0 +1,218 @@
+#include "Endpoint.h"
+#include "OutlierDetector.h"
+#include "rpc.pb.h"
+
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <muduo/base/Timestamp.h>
+
+namespace {
+// EWMA 的衰减时间常数：距离上一个样本越久，旧值权重越低
+const double kDecayUs = 10.0 * 1000 * 1000;
+// 尚无延迟样本时每个在途请求的代价（微秒）
+const double kPenaltyUs = 1000.0 * 1000;
+// 服务端负载上报的有效期，超过后按没有上报处理（服务端可能已不再回包）
+const int64_t kServerLoadTtlUs = 1000 * 1000;
+// CPU 利用率的上限，避免满载时代价除以 0
+const double kMaxCpuUtilization = 0.95;
+// 连续失败多少次视为不健康
+const int kUnhealthyFailures = 3;
+}
+
+EndpointStats::EndpointStats()
+        : EndpointStats(std::string()) {}
+
+EndpointStats::EndpointStats(const std::string& hostPort)
+        : hostPort_(hostPort),
+          detector_(nullptr),
+          inflight_(0),
+          ewmaUs_(0),
+          successes_(0),
+          failures_(0),
+          consecutiveFailures_(0),
+          consecutiveTimeouts_(0),
+          lastSampleUs_(0),
+          serverInflight_(0),
+          serverQueueUs_(0),
+          serverCpu_(0),
+          serverLoadAtUs_(0),
+          ejectedUntilUs_(0),
+          ejections_(0),
+          probeAtUs_(0),
+          restoredAtUs_(0) {}
+
+void EndpointStats::onFinish(int64_t latencyUs, bool ok, bool timedOut) {
+    inflight_.fetch_sub(1, std::memory_order_relaxed);
+    if (ok) {
+        successes_.fetch_add(1, std::memory_order_relaxed);
+        consecutiveFailures_.store(0, std::memory_order_relaxed);
+    } else {
+        failures_.fetch_add(1, std::memory_order_relaxed);
+        consecutiveFailures_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (timedOut) {
+        consecutiveTimeouts_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        consecutiveTimeouts_.store(0, std::memory_order_relaxed);
+    }
+    if (latencyUs < 0) latencyUs = 0;
+
+    int64_t now = muduo::Timestamp::now().microSecondsSinceEpoch();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int64_t ewma = ewmaUs_.load(std::memory_order_relaxed);
+        if (ewma == 0 || latencyUs > ewma) {
+            // peak：变慢时立即跟上，变快时按时间衰减慢慢回落
+            ewma = latencyUs;
+        } else {
+            double w = std::exp(-static_cast<double>(now - lastSampleUs_) / kDecayUs);
+            ewma = static_cast<int64_t>(ewma * w + latencyUs * (1 - w));
+        }
+        lastSampleUs_ = now;
+        ewmaUs_.store(ewma, std::memory_order_relaxed);
+    }
+    if (detector_) {
+        detector_->onResult(this, ok);
+    }
+}
+
+bool EndpointStats::healthy() const {
+    return !ejected() && consecutiveFailures() < kUnhealthyFailures;
+}
+
+void EndpointStats::onServerLoad(int inflight, int64_t queueDelayUs, int cpuPermille) {
+    serverInflight_.store(inflight, std::memory_order_relaxed);
+    serverQueueUs_.store(queueDelayUs, std::memory_order_relaxed);
+    serverCpu_.store(cpuPermille, std::memory_order_relaxed);
+    serverLoadAtUs_.store(muduo::Timestamp::now().microSecondsSinceEpoch(), std::memory_order_release);
+}
+
+bool EndpointStats::hasServerLoad() const {
+    int64_t at = serverLoadAtUs_.load(std::memory_order_acquire);
+    return at != 0 && muduo::Timestamp::now().microSecondsSinceEpoch() - at < kServerLoadTtlUs;
+}
+
+int EndpointStats::load() const {
+    int n = inflight();
+    if (hasServerLoad()) {
+        n = std::max(n, serverInflight());
+    }
+    return n;
+}
+
+double EndpointStats::cost() const {
+    int n = inflight();
+    int64_t ewma = ewmaLatencyUs();
+    if (ewma == 0 && n != 0) {
+        return kPenaltyUs + n;
+    }
+    if (!hasServerLoad()) {
+        return static_cast<double>(ewma) * (n + 1);
+    }
+    // 服务端的排队时间还没体现在延迟 EWMA 里时先加上；CPU 越忙，新请求的预期耗时按 1/(1-u) 放大
+    double u = std::min(serverCpuPermille() / 1000.0, kMaxCpuUtilization);
+    n = std::max(n, serverInflight());
+    return static_cast<double>(ewma + serverQueueDelayUs()) * (n + 1) / (1 - u);
+}
+
+namespace {
+// 解析 "ip:port" / "[v6]:port"，填好 hostPort 和 addr
+bool parseAddress(const std::string& address, Endpoint* out) {
+    std::string ip;
+    size_t colon;
+    bool ipv6 = !address.empty() && address[0] == '[';
+    if (ipv6) {
+        size_t close = address.find(']');
+        if (close == std::string::npos || close + 1 >= address.size() || address[close + 1] != ':') {
+            return false;
+        }
+        ip = address.substr(1, close - 1);
+        colon = close + 1;
+    } else {
+        colon = address.rfind(':');
+        if (colon == std::string::npos) return false;
+        ip = address.substr(0, colon);
+    }
+    char* portEnd = nullptr;
+    long port = std::strtol(address.c_str() + colon + 1, &portEnd, 10);
+    if (portEnd == address.c_str() + colon + 1 || *portEnd != '\0' || port <= 0 || port > 65535) {
+        return false;
+    }
+    unsigned char buf[sizeof(struct in6_addr)];
+    if (::inet_pton(ipv6 ? AF_INET6 : AF_INET, ip.c_str(), buf) != 1) {
+        return false;
+    }
+    out->hostPort = address;
+    out->addr     = muduo::net::InetAddress(ip, static_cast<uint16_t>(port), ipv6);
+    return true;
+}
+
+bool parseMeta(const std::string& data, Endpoint* out) {
+    Krpc::EndpointMeta meta;
+    if (!meta.ParseFromString(data) || meta.meta_version() == 0) {
+        return false;
+    }
+    const std::string& host = meta.host();
+    std::string address = host.find(':') != std::string::npos
+                        ? "[" + host + "]:" + std::to_string(meta.port())
+                        : host + ":" + std::to_string(meta.port());
+    if (!parseAddress(address, out)) {
+        return false;
+    }
+    out->weight          = meta.weight() > 0 ? static_cast<int>(meta.weight()) : 1;
+    out->zone            = meta.zone();
+    out->rack            = meta.rack();
+    out->version         = meta.build_version();
+    out->maxConcurrency  = static_cast<int>(meta.max_concurrency());
+    out->protocolVersion = static_cast<int>(meta.protocol_version());
+    out->startTimeMs     = meta.start_time_ms();
+    return true;
+}
+} // namespace
+
+bool Endpoint::parse(const std::string& data, Endpoint* out) {
+    out->weight = 1;
+    out->zone.clear();
+    out->rack.clear();
+    out->version.clear();
+    out->maxConcurrency  = 0;
+    out->protocolVersion = 0;
+    out->startTimeMs     = 0;
+    if (isMeta(data)) {
+        if (!parseMeta(data, out)) return false;
+        out->data = data;
+        return true;
+    }
+
+    size_t end = data.find(';');
+    if (!parseAddress(data.substr(0, end), out)) {
+        return false;
+    }
+    out->data = data;
+
+    while (end != std::string::npos) {
+        size_t begin = end + 1;
+        end = data.find(';', begin);
+        std::string attr = data.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+        size_t eq = attr.find('=');
+        if (eq == std::string::npos) continue;
+        std::string key = attr.substr(0, eq);
+        std::string value = attr.substr(eq + 1);
+        if (key == "weight") {
+            int w = std::atoi(value.c_str());
+            out->weight = w > 0 ? w : 1;
+        } else if (key == "zone") {
+            out->zone = value;
+        } else if (key == "rack") {
+            out->rack = value;
+        } else if (key == "version") {
+            out->version = value;
+        } else if (key == "max_concurrency") {
+            int c = std::atoi(value.c_str());
+            out->maxConcurrency = c > 0 ? c : 0;
+        }
+    }
+    return true;
+}
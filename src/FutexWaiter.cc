@@ -0,0 +1,58 @@
+#include "FutexWaiter.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#include <cstdint>
+#include <climits>
+
+namespace {
+
+int futex(std::atomic<int>* addr, int op, int val, const struct timespec* timeout) {
+    return static_cast<int>(::syscall(SYS_futex, reinterpret_cast<int*>(addr), op, val, timeout, nullptr, 0));
+}
+
+int64_t monotonicNs() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+} // namespace
+
+void FutexWaiter::wake() {
+    // 只有等待者已经进入睡眠时才需要系统调用
+    if (state_.exchange(kWoken, std::memory_order_acq_rel) == kSleeping) {
+        futex(&state_, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr);
+    }
+}
+
+bool FutexWaiter::waitFor(double seconds) {
+    const bool bounded = seconds > 0;
+    const int64_t deadline = bounded ? monotonicNs() + static_cast<int64_t>(seconds * 1e9) : 0;
+    while (true) {
+        int state = state_.load(std::memory_order_acquire);
+        if (state == kWoken) {
+            return true;
+        }
+        if (state == kIdle &&
+            !state_.compare_exchange_strong(state, kSleeping, std::memory_order_acq_rel)) {
+            continue;   // 期间被 wake 了，重新检查
+        }
+
+        struct timespec rel;
+        struct timespec* timeout = nullptr;
+        if (bounded) {
+            int64_t left = deadline - monotonicNs();
+            if (left <= 0) {
+                return state_.load(std::memory_order_acquire) == kWoken;
+            }
+            rel.tv_sec  = static_cast<time_t>(left / 1000000000);
+            rel.tv_nsec = static_cast<long>(left % 1000000000);
+            timeout = &rel;
+        }
+        // 值已不是 kSleeping 时立即返回 EAGAIN；EINTR / 虚假唤醒都回到循环开头重新检查
+        futex(&state_, FUTEX_WAIT_PRIVATE, kSleeping, timeout);
+    }
+}
@@ -0,0 +1,336 @@
+#include "LoadBalancer.h"
+#include "Logger.h"
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+
+namespace {
+
+const int kMaxSchedule = 4096;          // 加权轮询调度序列的最大长度
+const int kVirtualNodes = 100;          // 哈希环上每单位权重的虚节点数
+const int kMaxRingWeight = 100;
+const uint64_t kTableSize = 65537;      // Maglev 查找表长度，素数且远大于实例数
+const uint32_t kEmpty = 0xffffffffu;
+
+std::mt19937& rng() {
+    static thread_local std::mt19937 gen{std::random_device{}()};
+    return gen;
+}
+
+size_t randomIndex(size_t n) {
+    std::uniform_int_distribution<size_t> dist(0, n - 1);
+    return dist(rng());
+}
+
+// 随机取两个不同的下标
+void pickTwo(size_t n, size_t* a, size_t* b) {
+    *a = randomIndex(n);
+    *b = randomIndex(n - 1);
+    if (*b >= *a) ++*b;
+}
+
+class RandomBalancer : public LoadBalancer {
+public:
+    size_t pick(const EndpointList& endpoints, const PickContext&) override {
+        return randomIndex(endpoints.size());
+    }
+};
+
+// 平滑加权轮询：rebuild 时按 nginx 的 smooth WRR 预先展开一轮调度序列，
+// pick 只是原子递增取序列中的下一项，可以并发调用
+class WeightedRoundRobinBalancer : public LoadBalancer {
+public:
+    WeightedRoundRobinBalancer() : next_(0) {}
+
+    void rebuild(const EndpointList& endpoints) override {
+        std::vector<uint32_t> schedule;
+        std::vector<int> weights(endpoints.size());
+        int total = 0;
+        for (size_t i = 0; i < endpoints.size(); ++i) {
+            weights[i] = endpoints[i].weight > 0 ? endpoints[i].weight : 1;
+            total += weights[i];
+        }
+        // 权重总和过大时按比例缩小，避免序列过长
+        if (total > kMaxSchedule) {
+            int64_t original = total;
+            total = 0;
+            for (size_t i = 0; i < weights.size(); ++i) {
+                weights[i] = std::max(1, static_cast<int>(static_cast<int64_t>(weights[i]) * kMaxSchedule / original));
+                total += weights[i];
+            }
+        }
+        std::vector<int> current(endpoints.size(), 0);
+        for (int round = 0; round < total; ++round) {
+            size_t best = 0;
+            for (size_t i = 0; i < current.size(); ++i) {
+                current[i] += weights[i];
+                if (current[i] > current[best]) best = i;
+            }
+            current[best] -= total;
+            schedule.push_back(static_cast<uint32_t>(best));
+        }
+        schedule_.swap(schedule);
+    }
+
+    size_t pick(const EndpointList& endpoints, const PickContext&) override {
+        uint64_t n = next_.fetch_add(1, std::memory_order_relaxed);
+        if (schedule_.empty()) {
+            return n % endpoints.size();
+        }
+        size_t idx = schedule_[n % schedule_.size()];
+        return idx < endpoints.size() ? idx : n % endpoints.size();
+    }
+
+private:
+    std::vector<uint32_t>   schedule_;
+    std::atomic<uint64_t>   next_;
+};
+
+// power of two choices：随机取两个，选在途请求更少的那个（含服务端上报的在途数）
+class P2CBalancer : public LoadBalancer {
+public:
+    size_t pick(const EndpointList& endpoints, const PickContext&) override {
+        size_t n = endpoints.size();
+        if (n == 1) return 0;
+        size_t a, b;
+        pickTwo(n, &a, &b);
+        int la = endpoints[a].stats->load();
+        int lb = endpoints[b].stats->load();
+        if (la != lb) return la < lb ? a : b;
+        return endpoints[a].stats->ewmaLatencyUs() <= endpoints[b].stats->ewmaLatencyUs() ? a : b;
+    }
+};
+
+// 随机取两个，选 peak-EWMA 代价（延迟 *（在途 + 1））更小的那个
+class PeakEwmaBalancer : public LoadBalancer {
+public:
+    size_t pick(const EndpointList& endpoints, const PickContext&) override {
+        size_t n = endpoints.size();
+        if (n == 1) return 0;
+        size_t a, b;
+        pickTwo(n, &a, &b);
+        return endpoints[a].stats->cost() <= endpoints[b].stats->cost() ? a : b;
+    }
+};
+
+const double kDefaultLoadFactor = 1.25;
+
+// 有界负载（consistent hashing with bounded loads）：任一实例的在途请求数
+// 不超过 ceil(factor * (总在途 + 1) / 实例数)，超出时沿哈希顺序顺延到下一个实例，
+// 热点 key 溢出到邻居，其余 key 的归属不变
+class BoundedLoad {
+public:
+    explicit BoundedLoad(double factor) : factor_(factor) {}
+
+    bool enabled() const { return factor_ > 0; }
+    int capacity(const EndpointList& endpoints) const {
+        int64_t total = 1;
+        for (size_t i = 0; i < endpoints.size(); ++i) {
+            total += endpoints[i].stats->inflight();
+        }
+        return static_cast<int>(std::ceil(factor_ * total / endpoints.size()));
+    }
+
+private:
+    double factor_;
+};
+
+// ketama 风格的哈希环：每个实例按权重放 kVirtualNodes * weight 个虚节点，
+// 实例增减只影响它相邻区间的 key
+class RingHashBalancer : public LoadBalancer {
+public:
+    explicit RingHashBalancer(double loadFactor) : bounded_(loadFactor) {}
+
+    void rebuild(const EndpointList& endpoints) override {
+        std::vector<std::pair<uint64_t, uint32_t>> ring;
+        for (size_t i = 0; i < endpoints.size(); ++i) {
+            int weight = std::min(std::max(endpoints[i].weight, 1), kMaxRingWeight);
+            int vnodes = kVirtualNodes * weight;
+            for (int v = 0; v < vnodes; ++v) {
+                std::string vnode = endpoints[i].hostPort + "#" + std::to_string(v);
+                ring.push_back(std::make_pair(LoadBalancer::hash(vnode), static_cast<uint32_t>(i)));
+            }
+        }
+        std::sort(ring.begin(), ring.end());
+        ring_.swap(ring);
+    }
+
+    size_t pick(const EndpointList& endpoints, const PickContext& ctx) override {
+        if (ring_.empty()) return 0;
+        uint64_t h = ctx.hasHashKey ? ctx.hashKey : rng()();
+        auto it = std::lower_bound(ring_.begin(), ring_.end(), std::make_pair(h, static_cast<uint32_t>(0)));
+        size_t pos = it == ring_.end() ? 0 : it - ring_.begin();
+        size_t first = ring_[pos].second;
+        if (!bounded_.enabled() || endpoints.size() == 1) return first;
+
+        int cap = bounded_.capacity(endpoints);
+        for (size_t step = 0; step < ring_.size(); ++step) {
+            size_t idx = ring_[(pos + step) % ring_.size()].second;
+            if (endpoints[idx].stats->inflight() < cap) return idx;
+        }
+        return first;
+    }
+
+private:
+    std::vector<std::pair<uint64_t, uint32_t>>  ring_;
+    BoundedLoad                                 bounded_;
+};
+
+// Maglev 一致性哈希：预先填好一张长度为素数的查找表，pick 只做一次取模查表；
+// 各实例占表项数与权重成正比，实例增减时大部分表项不变
+class MaglevBalancer : public LoadBalancer {
+public:
+    explicit MaglevBalancer(double loadFactor) : bounded_(loadFactor) {}
+
+    void rebuild(const EndpointList& endpoints) override {
+        std::vector<uint32_t> table(kTableSize, kEmpty);
+        size_t n = endpoints.size();
+        if (n == 0) {
+            table_.swap(table);
+            return;
+        }
+        std::vector<uint64_t> offset(n), skip(n), next(n, 0);
+        std::vector<double> weight(n), credit(n, 0);
+        double maxWeight = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const std::string& name = endpoints[i].hostPort;
+            offset[i] = LoadBalancer::hash(name) % kTableSize;
+            skip[i]   = LoadBalancer::hash(name + "#skip") % (kTableSize - 1) + 1;
+            weight[i] = std::max(endpoints[i].weight, 1);
+            maxWeight = std::max(maxWeight, weight[i]);
+        }
+        uint64_t filled = 0;
+        while (filled < kTableSize) {
+            for (size_t i = 0; i < n && filled < kTableSize; ++i) {
+                // 加权：每轮累积 weight/maxWeight 的份额，满 1 才占一个表项
+                credit[i] += weight[i] / maxWeight;
+                if (credit[i] < 1) continue;
+                credit[i] -= 1;
+                uint64_t slot;
+                do {
+                    slot = (offset[i] + next[i] * skip[i]) % kTableSize;
+                    ++next[i];
+                } while (table[slot] != kEmpty);
+                table[slot] = static_cast<uint32_t>(i);
+                ++filled;
+            }
+        }
+        table_.swap(table);
+    }
+
+    size_t pick(const EndpointList& endpoints, const PickContext& ctx) override {
+        if (table_.empty() || table_[0] == kEmpty) return 0;
+        uint64_t h = ctx.hasHashKey ? ctx.hashKey : rng()();
+        size_t pos = h % kTableSize;
+        size_t first = table_[pos];
+        if (!bounded_.enabled() || endpoints.size() == 1) return first;
+
+        int cap = bounded_.capacity(endpoints);
+        // 顺延查表：相邻表项属于哪个实例近似随机，溢出的请求会分散到多个实例
+        for (size_t step = 0; step < kTableSize; ++step) {
+            size_t idx = table_[(pos + step) % kTableSize];
+            if (endpoints[idx].stats->inflight() < cap) return idx;
+        }
+        return first;
+    }
+
+private:
+    std::vector<uint32_t>  table_;
+    BoundedLoad            bounded_;
+};
+
+} // namespace
+
+uint64_t LoadBalancer::hash(const char* data, size_t len) {
+    // FNV-1a，再用 murmur3 的 fmix64 打散低位
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+PickContext PickContext::withHash(uint64_t hash) {
+    PickContext ctx;
+    ctx.hasHashKey = true;
+    ctx.hashKey = hash;
+    return ctx;
+}
+
+PickContext PickContext::withKey(const std::string& key) {
+    return withHash(LoadBalancer::hash(key));
+}
+
+PickContext PickContext::fromField(const google::protobuf::Message& request, const std::string& field) {
+    using google::protobuf::FieldDescriptor;
+    const FieldDescriptor* fd = request.GetDescriptor()->FindFieldByName(field);
+    if (fd == nullptr || fd->is_repeated()) {
+        return PickContext();
+    }
+    const google::protobuf::Reflection* refl = request.GetReflection();
+    switch (fd->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_STRING:
+        return withKey(refl->GetString(request, fd));
+    case FieldDescriptor::CPPTYPE_INT32:
+        return withKey(std::to_string(refl->GetInt32(request, fd)));
+    case FieldDescriptor::CPPTYPE_INT64:
+        return withKey(std::to_string(refl->GetInt64(request, fd)));
+    case FieldDescriptor::CPPTYPE_UINT32:
+        return withKey(std::to_string(refl->GetUInt32(request, fd)));
+    case FieldDescriptor::CPPTYPE_UINT64:
+        return withKey(std::to_string(refl->GetUInt64(request, fd)));
+    default:
+        return PickContext();
+    }
+}
+
+std::shared_ptr<LoadBalancer> LoadBalancer::create(const std::string& spec) {
+    std::string policy = spec;
+    double loadFactor = kDefaultLoadFactor;
+    size_t colon = spec.find(':');
+    if (colon != std::string::npos) {
+        policy = spec.substr(0, colon);
+        // 只接受 0（不限制）或大于 1 的系数：不大于 1 时上限贴着平均值，key 频繁顺延，
+        // 一致性哈希的亲和性就没有了；写错时按默认值处理而不是整个策略失效
+        const char* begin = spec.c_str() + colon + 1;
+        char* end = nullptr;
+        double factor = std::strtod(begin, &end);
+        if (end != begin && *end == '\0' && std::isfinite(factor) && (factor == 0 || factor > 1)) {
+            loadFactor = factor;
+        } else {
+            LOG(WARNING) << "invalid load factor in balancer policy \"" << spec
+                         << "\", using default " << kDefaultLoadFactor;
+        }
+    }
+    if (policy == "ring_hash") {
+        return std::make_shared<RingHashBalancer>(loadFactor);
+    } else if (policy == "maglev") {
+        return std::make_shared<MaglevBalancer>(loadFactor);
+    }
+    if (colon != std::string::npos) {
+        return std::shared_ptr<LoadBalancer>();
+    }
+
+    if (policy.empty() || policy == "random") {
+        return std::make_shared<RandomBalancer>();
+    } else if (policy == "round_robin") {
+        return std::make_shared<WeightedRoundRobinBalancer>();
+    } else if (policy == "p2c") {
+        return std::make_shared<P2CBalancer>();
+    } else if (policy == "ewma") {
+        return std::make_shared<PeakEwmaBalancer>();
+    }
+    return std::shared_ptr<LoadBalancer>();
+}
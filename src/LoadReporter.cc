@@ -0,0 +1,69 @@
+#include "LoadReporter.h"
+#include "rpc.pb.h"
+
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+
+#include <muduo/base/Timestamp.h>
+
+namespace {
+const int64_t kCpuSampleIntervalUs = 100 * 1000;
+// 排队时间 EWMA 中新样本的权重为 1/8
+const int64_t kQueueDelayDecay = 8;
+
+int64_t processCpuUs() {
+    struct rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL
+         + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+}
+
+LoadReporter::LoadReporter()
+        : inflight_(0),
+          queueDelayUs_(0),
+          cpuPermille_(0),
+          nextSampleUs_(0),
+          lastWallUs_(muduo::Timestamp::now().microSecondsSinceEpoch()),
+          lastCpuUs_(processCpuUs()),
+          cpus_(std::max(1L, ::sysconf(_SC_NPROCESSORS_ONLN))) {}
+
+void LoadReporter::onRequest(int64_t queueDelayUs) {
+    inflight_.fetch_add(1, std::memory_order_relaxed);
+    if (queueDelayUs < 0) queueDelayUs = 0;
+    // 多个 IO 线程并发更新，丢掉个别样本无所谓，不用 CAS 循环
+    int64_t old = queueDelayUs_.load(std::memory_order_relaxed);
+    queueDelayUs_.store(old + (queueDelayUs - old) / kQueueDelayDecay, std::memory_order_relaxed);
+}
+
+void LoadReporter::fill(Krpc::ServerLoad* load) {
+    int64_t now = muduo::Timestamp::now().microSecondsSinceEpoch();
+    if (now >= nextSampleUs_.load(std::memory_order_relaxed)) {
+        sampleCpu(now);
+    }
+    load->set_inflight(static_cast<uint32_t>(std::max(0, inflight())));
+    load->set_queue_delay_us(static_cast<uint32_t>(std::min<int64_t>(queueDelayUs(), UINT32_MAX)));
+    load->set_cpu_permille(static_cast<uint32_t>(cpuPermille()));
+}
+
+void LoadReporter::sampleCpu(int64_t nowUs) {
+    // 只需要一个线程采样，其他线程继续用上一次的值
+    std::unique_lock<std::mutex> lock(sampleMutex_, std::try_to_lock);
+    if (!lock.owns_lock() || nowUs < nextSampleUs_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    int64_t cpu = processCpuUs();
+    int64_t wall = nowUs - lastWallUs_;
+    if (wall > 0) {
+        int64_t permille = (cpu - lastCpuUs_) * 1000 / (wall * cpus_);
+        cpuPermille_.store(static_cast<int>(std::min<int64_t>(std::max<int64_t>(permille, 0), 1000)),
+                           std::memory_order_relaxed);
+    }
+    lastWallUs_ = nowUs;
+    lastCpuUs_  = cpu;
+    nextSampleUs_.store(nowUs + kCpuSampleIntervalUs, std::memory_order_relaxed);
+}
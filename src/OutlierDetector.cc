@@ -0,0 +1,166 @@
+#include "OutlierDetector.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace {
+// 半开状态下探测请求迟迟没有结果（例如被选中后没有真正发出）时，过这么久再放行下一个
+const int64_t kProbeTimeoutUs = 1000 * 1000;
+// 少于这么多个有延迟样本的实例时不做延迟异常检测，中位数没有意义
+const size_t kMinLatencyHosts = 3;
+
+int64_t toUs(double seconds) {
+    return static_cast<int64_t>(seconds * 1000 * 1000);
+}
+}
+
+OutlierDetector::Options::Options()
+        : consecutiveErrors(5),
+          consecutiveTimeouts(3),
+          latencyFactor(3.0),
+          minLatency(0.005),
+          interval(1.0),
+          baseEjection(10.0),
+          maxEjection(300.0),
+          maxEjectionPercent(50) {}
+
+OutlierDetector::OutlierDetector() {
+    setOptions(Options());
+}
+
+void OutlierDetector::setOptions(const Options& options) {
+    consecutiveErrors_.store(options.consecutiveErrors, std::memory_order_relaxed);
+    consecutiveTimeouts_.store(options.consecutiveTimeouts, std::memory_order_relaxed);
+    latencyFactor_.store(options.latencyFactor, std::memory_order_relaxed);
+    minLatencyUs_.store(toUs(options.minLatency), std::memory_order_relaxed);
+    intervalUs_.store(std::max<int64_t>(toUs(options.interval), 1000), std::memory_order_relaxed);
+    baseEjectionUs_.store(std::max<int64_t>(toUs(options.baseEjection), 1000), std::memory_order_relaxed);
+    maxEjectionUs_.store(std::max(toUs(options.maxEjection), toUs(options.baseEjection)), std::memory_order_relaxed);
+    maxEjectionPercent_.store(std::min(std::max(options.maxEjectionPercent, 0), 100), std::memory_order_relaxed);
+}
+
+OutlierDetector::Options OutlierDetector::options() const {
+    Options options;
+    options.consecutiveErrors   = consecutiveErrors_.load(std::memory_order_relaxed);
+    options.consecutiveTimeouts = consecutiveTimeouts_.load(std::memory_order_relaxed);
+    options.latencyFactor       = latencyFactor_.load(std::memory_order_relaxed);
+    options.minLatency          = minLatencyUs_.load(std::memory_order_relaxed) / 1e6;
+    options.interval            = intervalUs_.load(std::memory_order_relaxed) / 1e6;
+    options.baseEjection        = baseEjectionUs_.load(std::memory_order_relaxed) / 1e6;
+    options.maxEjection         = maxEjectionUs_.load(std::memory_order_relaxed) / 1e6;
+    options.maxEjectionPercent  = maxEjectionPercent_.load(std::memory_order_relaxed);
+    return options;
+}
+
+int64_t OutlierDetector::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void OutlierDetector::onResult(EndpointStats* stats, bool ok) {
+    int64_t until = stats->ejectedUntilUs_.load(std::memory_order_acquire);
+    if (until != 0) {
+        int64_t now = nowUs();
+        if (now < until) {
+            return;     // 摘除前发出的请求迟到的结果
+        }
+        // 半开状态下的结果：成功则恢复，失败则以更长的时长再次摘除
+        if (!ok) {
+            eject(stats, now, until, "probe failed");
+        } else if (stats->ejectedUntilUs_.compare_exchange_strong(until, 0, std::memory_order_acq_rel)) {
+            stats->restoredAtUs_.store(now, std::memory_order_relaxed);
+            LOG(INFO) << "outlier " << stats->hostPort() << " recovered after " << stats->ejections() << " ejections";
+        }
+        return;
+    }
+    if (ok) {
+        return;
+    }
+    int errors   = consecutiveErrors_.load(std::memory_order_relaxed);
+    int timeouts = consecutiveTimeouts_.load(std::memory_order_relaxed);
+    if (errors > 0 && stats->consecutiveFailures() >= errors) {
+        eject(stats, nowUs(), 0, "consecutive errors");
+    } else if (timeouts > 0 && stats->consecutiveTimeouts() >= timeouts) {
+        eject(stats, nowUs(), 0, "consecutive timeouts");
+    }
+}
+
+bool OutlierDetector::admit(EndpointStats* stats, int64_t nowUs) {
+    int64_t until = stats->ejectedUntilUs_.load(std::memory_order_acquire);
+    if (until == 0) {
+        return true;
+    }
+    if (nowUs < until) {
+        return false;
+    }
+    int64_t probe = stats->probeAtUs_.load(std::memory_order_relaxed);
+    if (probe != 0 && nowUs - probe < kProbeTimeoutUs) {
+        return false;
+    }
+    return stats->probeAtUs_.compare_exchange_strong(probe, nowUs, std::memory_order_relaxed);
+}
+
+bool OutlierDetector::overEjectionLimit(const EndpointList& endpoints) const {
+    size_t ejected = 0;
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        if (endpoints[i].stats->ejected()) ++ejected;
+    }
+    return ejected * 100 > static_cast<size_t>(maxEjectionPercent_.load(std::memory_order_relaxed)) * endpoints.size();
+}
+
+void OutlierDetector::sweep(const EndpointList& endpoints) {
+    double factor = latencyFactor_.load(std::memory_order_relaxed);
+    if (factor <= 0 || endpoints.size() < kMinLatencyHosts) {
+        return;
+    }
+    std::vector<int64_t> latencies;
+    size_t ejected = 0;
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        const EndpointStats& stats = *endpoints[i].stats;
+        if (stats.ejected()) {
+            ++ejected;
+        } else if (stats.successes() > 0 && stats.ewmaLatencyUs() > 0) {
+            latencies.push_back(stats.ewmaLatencyUs());
+        }
+    }
+    if (latencies.size() < kMinLatencyHosts) {
+        return;
+    }
+    std::nth_element(latencies.begin(), latencies.begin() + latencies.size() / 2, latencies.end());
+    int64_t median = latencies[latencies.size() / 2];
+    int64_t threshold = std::max(static_cast<int64_t>(median * factor), minLatencyUs_.load(std::memory_order_relaxed));
+    size_t limit = static_cast<size_t>(maxEjectionPercent_.load(std::memory_order_relaxed)) * endpoints.size();
+    int64_t now = nowUs();
+    for (size_t i = 0; i < endpoints.size() && (ejected + 1) * 100 <= limit; ++i) {
+        EndpointStats* stats = endpoints[i].stats.get();
+        if (!stats->ejected() && stats->ewmaLatencyUs() > threshold && eject(stats, now, 0, "latency outlier")) {
+            ++ejected;
+        }
+    }
+}
+
+bool OutlierDetector::eject(EndpointStats* stats, int64_t nowUs, int64_t expectedUntilUs, const char* reason) {
+    int64_t base = baseEjectionUs_.load(std::memory_order_relaxed);
+    int64_t max  = maxEjectionUs_.load(std::memory_order_relaxed);
+    // 恢复后稳定运行超过 max 的实例，摘除时长从 base 重新开始
+    int count = stats->ejections_.load(std::memory_order_relaxed);
+    int64_t restoredAt = stats->restoredAtUs_.load(std::memory_order_relaxed);
+    if (expectedUntilUs == 0 && restoredAt != 0 && nowUs - restoredAt > max) {
+        count = 0;
+    }
+    int64_t duration = base;
+    for (int i = 0; i < count && duration < max; ++i) {
+        duration *= 2;
+    }
+    duration = std::min(duration, max);
+    // 多个线程可能同时判定同一个实例，只有一个能摘除成功
+    if (!stats->ejectedUntilUs_.compare_exchange_strong(expectedUntilUs, nowUs + duration, std::memory_order_acq_rel)) {
+        return false;
+    }
+    stats->ejections_.store(count + 1, std::memory_order_relaxed);
+    stats->probeAtUs_.store(0, std::memory_order_relaxed);
+    LOG(WARNING) << "ejecting outlier " << stats->hostPort() << " for " << duration / 1e6 << "s: " << reason;
+    return true;
+}
@@ -1,15 +1,31 @@
 // RPCChannel.cpp
 #include "RPCChannel.h"
 #include "ServiceDiscovery.h"
+#include "FutexWaiter.h"
+#include "RpcController.h"
 #include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
-RPCChannel::RPCChannel(const std::shared_ptr<muduo::net::TcpConnection>& conn): prototype_(&Krpc::RpcHeader::default_instance()), conn_(conn)
+namespace {
+const double kDefaultCallTimeout = 5.0;
+
+// 同步调用的 done：只负责唤醒阻塞在 Call() 里的线程，生命周期属于调用方栈
+class WakeClosure : public ::google::protobuf::Closure {
+public:
+    void Run() override { waiter.wake(); }
+    FutexWaiter waiter;
+};
+}
+
+RPCChannel::RPCChannel(const std::shared_ptr<muduo::net::TcpConnection>& conn)
+        : conn_(conn), services_(nullptr), loadReporter_(nullptr),
+          prototype_(&Krpc::RpcHeader::default_instance()), callTimeout_(kDefaultCallTimeout)
 {
 }
-RPCChannel::RPCChannel(): prototype_(&Krpc::RpcHeader::default_instance())
+RPCChannel::RPCChannel(): services_(nullptr), loadReporter_(nullptr),
+          prototype_(&Krpc::RpcHeader::default_instance()), callTimeout_(kDefaultCallTimeout)
 {
 }
 
@@ -18,11 +34,71 @@ void RPCChannel::CallMethod(const ::google::protobuf::MethodDescriptor* method,
                             const ::google::protobuf::Message* request,
                             ::google::protobuf::Message* response,
                             ::google::protobuf::Closure* done) {
+    if (done == nullptr) {
+        Call(method, *request, response, callTimeout_, controller);
+        return;
+    }
+    startCall(method, controller, request, response, done, false);
+}
+
+int64_t RPCChannel::CallAsync(const ::google::protobuf::MethodDescriptor* method,
+                              ::google::protobuf::RpcController* controller,
+                              const ::google::protobuf::Message* request,
+                              ::google::protobuf::Message* response,
+                              ::google::protobuf::Closure* done) {
+    return startCall(method, controller, request, response, done, false);
+}
+
+bool RPCChannel::Call(const ::google::protobuf::MethodDescriptor* method,
+                      const ::google::protobuf::Message& request,
+                      ::google::protobuf::Message* response,
+                      double timeoutSeconds,
+                      ::google::protobuf::RpcController* controller) {
+    bool inIoThread = false;
+    {
+        MutexLockGuard lock(mutex_);
+        inIoThread = conn_ && conn_->getLoop()->isInLoopThread();
+    }
+    // 响应要由本 channel 的 IO 线程投递，在该线程上阻塞等待必然死锁
+    if (inIoThread) {
+        failCall(controller, nullptr, "blocking Call() on the channel's own IO thread", Krpc::INTERNAL);
+        return false;
+    }
+
+    // 连接断开等失败会通过 controller 告知，调用方没给 controller 时用一个局部的
+    RpcController localController;
+    if (controller == nullptr) {
+        controller = &localController;
+    }
+
+    WakeClosure done;
+    int64_t id = startCall(method, controller, &request, response, &done, true);
+    if (id == 0) {
+        return false;
+    }
+    if (done.waiter.waitFor(timeoutSeconds)) {
+        return !controller->Failed();
+    }
+    if (cancelCall(id)) {
+        failCall(controller, nullptr, "rpc call timed out", Krpc::DEADLINE_EXCEEDED);
+        return false;
+    }
+    // 超时的同时响应已被 IO 线程取走，正在写入 response，等它执行完 done
+    done.waiter.wait();
+    return !controller->Failed();
+}
+
+int64_t RPCChannel::startCall(const ::google::protobuf::MethodDescriptor* method,
+                              ::google::protobuf::RpcController* controller,
+                              const ::google::protobuf::Message* request,
+                              ::google::protobuf::Message* response,
+                              ::google::protobuf::Closure* done,
+                              bool borrowed) {
     // 1. 序列化请求体（payload）
     std::string payload;
     if (!request->SerializeToString(&payload)) {
-        controller->SetFailed("Failed to serialize request.");
-        return;
+        failCall(controller, done, "Failed to serialize request.", Krpc::INTERNAL);
+        return 0;
     }
 
     // 2. 构造 RPCHeader
@@ -36,29 +112,87 @@ void RPCChannel::CallMethod(const ::google::protobuf::MethodDescriptor* method,
 
     std::string headerStr;
     if (!header.SerializeToString(&headerStr)) {
-        controller->SetFailed("serialize rpc header error");
-        return;
+        failCall(controller, done, "serialize rpc header error", Krpc::INTERNAL);
+        return 0;
     }
 
     // 4. 注册 callback，等待响应
+    TcpConnectionPtr conn;
     {
         MutexLockGuard lock(mutex_);
-        outstandings_[id] = OutstandingCall{response, done};
+        conn = conn_;
+        if (conn) {
+            outstandings_[id] = OutstandingCall{response, controller, done, borrowed};
+        }
+    }
+    if (!conn) {
+        failCall(controller, done, "No active connection.", Krpc::UNAVAILABLE);
+        return 0;
     }
 
     // 5. 发送 packet 到服务器（可选加长度头部）
-    if (conn_) {
-        // 发送带长度前缀的消息，便于服务端 framing（如果你希望有长度前缀）
-        uint32_t len = static_cast<uint32_t>(headerStr.size()+sizeof(len));
-        // 2) 转成网络字节序（big-endian）
-        uint32_t netLen = htonl(len);
+    // 发送带长度前缀的消息，便于服务端 framing（如果你希望有长度前缀）
+    uint32_t len = static_cast<uint32_t>(headerStr.size()+sizeof(len));
+    // 2) 转成网络字节序（big-endian）
+    uint32_t netLen = htonl(len);
+
+    std::string sendBuf;
+    sendBuf.append(reinterpret_cast<const char*>(&netLen), sizeof(netLen));  // 4 字节长度
+    sendBuf += headerStr;
+    conn->send(sendBuf);  // 非 IO 线程调用时 muduo 会转交到连接所在 loop 发送
+    return id;
+}
+
+void RPCChannel::failOutstandings(const std::string& reason) {
+    std::map<int64_t, OutstandingCall> calls;
+    {
+        MutexLockGuard lock(mutex_);
+        calls.swap(outstandings_);
+    }
+    if (!calls.empty()) {
+        LOG(WARNING) << "failing " << calls.size() << " outstanding rpc calls: " << reason;
+    }
+    // 与正常回包一致：执行 done 后 response 的所有权交还给调用方
+    for (auto& it : calls) {
+        RpcController::Fail(it.second.controller, reason, Krpc::UNAVAILABLE);
+        if (it.second.done) {
+            it.second.done->Run();
+        }
+    }
+}
+
+bool RPCChannel::cancelCall(int64_t id) {
+    MutexLockGuard lock(mutex_);
+    return outstandings_.erase(id) > 0;
+}
+
+bool RPCChannel::cancel(int64_t id, const std::string& reason) {
+    OutstandingCall call;
+    {
+        MutexLockGuard lock(mutex_);
+        auto it = outstandings_.find(id);
+        if (it == outstandings_.end()) {
+            return false;
+        }
+        call = it->second;
+        outstandings_.erase(it);
+    }
+    RpcController::Fail(call.controller, reason, Krpc::CANCELLED);
+    if (call.done) {
+        call.done->Run();
+    }
+    return true;
+}
 
-        std::string sendBuf;
-        sendBuf.append(reinterpret_cast<const char*>(&netLen), sizeof(netLen));  // 4 字节长度
-        sendBuf += headerStr;
-        conn_->send(sendBuf);  // 假设 conn_->send 支持 string 发送
-    } else {
-        controller->SetFailed("No active connection.");
+// 本地失败（未发出请求）时也要执行 done，否则等待该调用的 future/协程永远不会被唤醒
+void RPCChannel::failCall(::google::protobuf::RpcController* controller,
+                          ::google::protobuf::Closure* done,
+                          const std::string& reason,
+                          Krpc::StatusCode code) {
+    LOG(ERROR) << "rpc call failed: " << reason;
+    RpcController::Fail(controller, reason, code);
+    if (done) {
+        done->Run();
     }
 }
 
@@ -69,6 +203,10 @@ void RPCChannel::onRPCMessage(const TcpConnectionPtr& conn, const RpcMessagePtr&
     if (message.type() == Krpc::RESPONSE) {
         // 6) 处理 RESPONSE 消息
         uint64_t id = message.id();
+        // 先更新 endpoint 的负载（已超时/取消的调用的响应也算），done 里发起的下一次选取就能用上
+        if (loadCallback_ && message.has_load()) {
+            loadCallback_(message.load());
+        }
         OutstandingCall call;
         {
             MutexLockGuard lock(mutex_);
@@ -80,8 +218,10 @@ void RPCChannel::onRPCMessage(const TcpConnectionPtr& conn, const RpcMessagePtr&
             call = it->second;
             outstandings_.erase(it);
         }
-        // 7) 将 payload 反序列化到用户传入的 response 对象
-        if (call.response) {
+        // 7) 服务端返回错误时不解析 payload；否则反序列化到用户传入的 response 对象
+        if (message.status() != Krpc::OK) {
+            RpcController::Fail(call.controller, message.error_text(), message.status());
+        } else if (call.response) {
             if (!call.response->ParseFromString(message.payload())) {
                 LOG(ERROR) << "failed to parse response payload, id=" << id;
             }
@@ -101,6 +241,7 @@ void RPCChannel::onRPCMessage(const TcpConnectionPtr& conn, const RpcMessagePtr&
         auto sit = services_->find(svcName);
         if (sit == services_->end()) {
             LOG(ERROR) << "No service named " << svcName;
+            sendError(conn, callId, Krpc::UNIMPLEMENTED, "no service named " + svcName);
             return;
         }
         ServiceInfo service_info =  sit->second;
@@ -111,22 +252,32 @@ void RPCChannel::onRPCMessage(const TcpConnectionPtr& conn, const RpcMessagePtr&
         const ::google::protobuf::MethodDescriptor* md = sdsc->FindMethodByName(mthdName);
         if (!md) {
             LOG(ERROR) << "No method " << mthdName << " in service " << svcName;
+            sendError(conn, callId, Krpc::UNIMPLEMENTED, "no method " + mthdName + " in service " + svcName);
             return;
         }
 
-        // 4) 根据 method 原型，New 出 request/response 对象
-        std::unique_ptr<::google::protobuf::Message> req(
-                service->GetRequestPrototype(md).New());
-        ::google::protobuf::Message* rsp(service->GetResponsePrototype(md).New());  //由CallMethod用uniqueptr接管
+        // 4) 根据 method 原型，New 出 request/response 对象，由 ServerCall 接管到 done 为止
+        ServerCall* call = new ServerCall;
+        call->request.reset(service->GetRequestPrototype(md).New());
+        call->response.reset(service->GetResponsePrototype(md).New());
+        call->id = callId;
+        call->conn = conn;
+        call->loadReporter = loadReporter_;
 
         // 5) 反序列化 payload 到 req
-        if (!req->ParseFromString(message.payload())) {
+        if (!call->request->ParseFromString(message.payload())) {
             LOG(ERROR) << "Failed to parse request payload for call " << callId;
+            delete call;
+            sendError(conn, callId, Krpc::INVALID_ARGUMENT, "failed to parse request payload");
             return;
         }
 
         // 6) 异步调用：执行 service 方法后由用户done->run()后填充 rsp并发送
-        service->CallMethod(md, /* controller= */ nullptr,req.get(), rsp, NewCallback(this, &RPCChannel::doneCallback, rsp, callId));
+        if (loadReporter_) {
+            loadReporter_->onRequest(Timestamp::now().microSecondsSinceEpoch() - receive_time.microSecondsSinceEpoch());
+        }
+        service->CallMethod(md, &call->controller, call->request.get(), call->response.get(),
+                            ::google::protobuf::NewCallback(&RPCChannel::doneCallback, call));
 
     }
 }
@@ -169,8 +320,23 @@ void RPCChannel::onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp
 //}
 
 
-void RPCChannel::doneCallback(::google::protobuf::Message* response, uint64_t id){
-    std::unique_ptr<google::protobuf::Message> d(response);     //接管response
+void RPCChannel::doneCallback(ServerCall* call){
+    std::unique_ptr<ServerCall> d(call);     //接管 request/response
+    ::google::protobuf::Message* response = call->response.get();
+    uint64_t id = call->id;
+    if (call->loadReporter) {
+        call->loadReporter->onResponse();
+    }
+    TcpConnectionPtr conn = call->conn.lock();
+    if (!conn || !conn->connected()) {
+        // 客户端已断开（异步 handler 完成得晚），回包无处可发
+        return;
+    }
+    if (call->controller.Failed()) {
+        // handler 报告失败：不带 payload，状态码和错误信息交给客户端的 controller
+        sendError(conn, id, call->controller.Status(), call->controller.ErrorText());
+        return;
+    }
     // 7) 将 rsp 序列化，并构造 RESPONSE header
     std::string rspPayload;
     if (!response->SerializeToString(&rspPayload)) {
@@ -181,10 +347,26 @@ void RPCChannel::doneCallback(::google::protobuf::Message* response, uint64_t id
     respHdr.set_type(Krpc::RESPONSE);
     respHdr.set_id(id);
     respHdr.set_payload(rspPayload);
+    if (call->loadReporter) {
+        call->loadReporter->fill(respHdr.mutable_load());
+    }
+    sendResponse(conn, respHdr);
+}
 
+// 请求无法交给 service 处理时直接回错误，客户端不必等到超时
+void RPCChannel::sendError(const TcpConnectionPtr& conn, uint64_t id, Krpc::StatusCode code, const std::string& text) {
+    Krpc::RpcHeader respHdr;
+    respHdr.set_type(Krpc::RESPONSE);
+    respHdr.set_id(id);
+    respHdr.set_status(code);
+    respHdr.set_error_text(text);
+    sendResponse(conn, respHdr);
+}
+
+void RPCChannel::sendResponse(const TcpConnectionPtr& conn, const Krpc::RpcHeader& respHdr) {
     std::string raw;
     if (!respHdr.SerializeToString(&raw)){
-        LOG(ERROR) << "Failed to serialize response for call " << id;
+        LOG(ERROR) << "Failed to serialize response for call " << respHdr.id();
         return;
     }
     uint32_t len = static_cast<uint32_t>(raw.size()) + sizeof(len);
@@ -194,7 +376,7 @@ void RPCChannel::doneCallback(::google::protobuf::Message* response, uint64_t id
     std::string sendBuf;
     sendBuf.append(reinterpret_cast<const char*>(&netLen), sizeof(netLen));
     sendBuf += raw;
-    conn_->send(sendBuf);
+    conn->send(sendBuf);
 }
 
 
@@ -203,6 +385,7 @@ RPCChannel::~RPCChannel() {
     for (const auto& outstanding : outstandings_)
     {
         OutstandingCall out = outstanding.second;
+        if (out.borrowed) continue;
         delete out.response;
         delete out.done;
     }
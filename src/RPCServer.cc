@@ -1,11 +1,45 @@
 #include "RPCServer.h"
 #include "rpc.pb.h"
 #include "Logger.h"
+#include "Application.h"
 #include <csignal>
 #include "muduo/net/EventLoop.h"
+#include <algorithm>
+#include <cstdlib>
 // === Add global server pointer in one cpp file ===
 RpcServer* _my_server = nullptr;
 
+namespace {
+// 注册失败后的重试间隔（秒），每次翻倍
+const double kRegisterMinBackoff = 0.2;
+const double kRegisterMaxBackoff = 10.0;
+// 注册数据的编码版本，以及 RpcHeader 帧格式版本，帧格式不兼容地变化时递增
+const uint32_t kMetaVersion     = 1;
+const uint32_t kProtocolVersion = 1;
+
+uint32_t configUint(const std::string& key) {
+    int value = std::atoi(Application::Instance().GetConfig(key).c_str());
+    return value > 0 ? static_cast<uint32_t>(value) : 0;
+}
+
+// 实例元数据：地址、协议版本和启动时间由框架填写，权重、可用区、机架、最大并发和构建版本来自配置文件
+Krpc::EndpointMeta endpointMetaFromConfig(const std::string& ip, int port) {
+    Application& app = Application::Instance();
+    Krpc::EndpointMeta meta;
+    meta.set_meta_version(kMetaVersion);
+    meta.set_host(ip);
+    meta.set_port(static_cast<uint32_t>(port));
+    meta.set_weight(configUint("weight"));
+    meta.set_zone(app.GetConfig("zone"));
+    meta.set_rack(app.GetConfig("rack"));
+    meta.set_max_concurrency(configUint("max_concurrency"));
+    meta.set_protocol_version(kProtocolVersion);
+    meta.set_build_version(app.GetConfig("build_version"));
+    meta.set_start_time_ms(muduo::Timestamp::now().microSecondsSinceEpoch() / 1000);
+    return meta;
+}
+}
+
 
 // 注册服务对象及其方法，以便服务端能够处理客户端的RPC请求
 void RpcServer::NotifyService(google::protobuf::Service *service) {
@@ -82,43 +116,65 @@ void RpcServer::Run(const std::string& server_ip, int server_port, const std::st
 //    }
 //GPT重构版本，支持多server注册相同服务，负载均衡 begin
 
-    ZkClient zkclient;
-    zkclient.Start(zook_ip, zook_port);
+    // 会话由成员 zkclient_ 持有，Cleanup 时删除实例节点并关闭。
+    // 只发起连接不阻塞启动，注册请求在连上后发出，失败按退避重试，不会让进程退出
+    bool connected = zkclient_.Connect(zook_ip, zook_port);
 
-// 1) for each service, make sure the persistent service node exists
+    // 每个 service 下只注册一个临时节点 /service/instances/<ip:port>，数据是序列化的 EndpointMeta，
+    // 其中列出本 server 提供的方法，客户端在本地按方法展开。
+    // ZooKeeper 上的临时节点数和客户端的 watch 数不再随方法数成倍增长
+    const std::string instName = server_ip + ":" + std::to_string(server_port);
+    const Krpc::EndpointMeta baseMeta = endpointMetaFromConfig(server_ip, server_port);
     for (auto &sp : service_map) {
-        const std::string service  = "/" + sp.first;
-        zkclient.Create(service.c_str(), nullptr, 0, 0);
-
-        // 2) for each method, make sure the persistent method node exists
+        // 1) service 和 instances 都是永久节点，父节点在前
+        const std::string service = "/" + sp.first;
+        const std::string instancesPath = service + "/instances";
+        registry_nodes_.push_back(ZkClient::Node{service, std::string(), 0});
+        registry_nodes_.push_back(ZkClient::Node{instancesPath, std::string(), 0});
+
+        // 2) 本 server 的临时实例节点
+        Krpc::EndpointMeta meta = baseMeta;
+        std::string methods;
         for (auto &mp : sp.second.method_map) {
-            const std::string methodPath = service + "/" + mp.first;
-            zkclient.Create(methodPath.c_str(), nullptr, 0, 0);
-
-            // 3) now register *this* server instance as an ephemeral child:
-            //    Option A: use server_ip:server_port in the name so it's unique
-            std::string instName = server_ip + ":" + std::to_string(server_port);
-            std::string instancePath = methodPath + "/" + instName;
-            LOG(INFO)<<"writing server_ip"<<instName<<" into "<<methodPath;
-            char buf[128];
-            sprintf(buf, "%s:%d", server_ip.c_str(), server_port);
-            zkclient.Create(instancePath.c_str(), buf, strlen(buf), ZOO_EPHEMERAL);
-
-            instance_paths_.push_back(instancePath);     //  record instance paths
-            //    Option B: let ZooKeeper append a sequence number:
-            //std::string instPrefix = methodPath + "/server-";
-            //zkclient.Create(instPrefix.c_str(),
-            //                buf, strlen(buf),
-            //                ZOO_EPHEMERAL | ZOO_SEQUENCE);
+            meta.add_methods(mp.first);
+            if (!methods.empty()) methods += ",";
+            methods += mp.first;
         }
-    }
+        std::string data;
+        meta.SerializeToString(&data);
+        const std::string instancePath = instancesPath + "/" + instName;
+        LOG(INFO) << "registering " << instancePath << " methods:" << methods;
+        registry_nodes_.push_back(ZkClient::Node{instancePath, data, ZOO_EPHEMERAL});
 
+        instance_paths_.push_back(instancePath);     //  record instance paths
+    }
     //GPT重构版本，支持多server注册相同服务，负载均衡 end
     // RPC服务端准备启动，打印信息
     LOG(INFO) << "RpcServer start service at server_ip:" << server_ip << " server_port:" << server_port;
 
-    // 启动网络服务
+    // 启动网络服务。Run 在 event_loop 的线程上执行，start 返回时已经在监听，
+    // 之后再注册，客户端发现实例时连接一定能建立
     server_->start();
+
+    // 所有节点一次提交：持久节点流水线创建，临时节点一个 zoo_multi
+    if (!connected) {
+        LOG(ERROR) << "zookeeper_init error, serving without registration";
+    } else if (!warmup_) {
+        Register();
+    } else {
+        // 预热可能要调用本服务自己或其他 RPC，不能阻塞 event_loop；完成后回到 event_loop 上注册
+        warmup_thread_ = std::thread([this]() {
+            bool ready = warmup_();
+            event_loop.queueInLoop([this, ready]() {
+                if (ready) {
+                    LOG(INFO) << "warm-up finished, registering to ZooKeeper";
+                    Register();
+                } else {
+                    LOG(ERROR) << "warm-up failed, serving without registration";
+                }
+            });
+        });
+    }
     event_loop.loop();  // 进入事件循环
 }
 
@@ -132,6 +188,7 @@ void RpcServer::OnConnection(const muduo::net::TcpConnectionPtr &conn) {
         std::shared_ptr<RPCChannel> krpcChannel_ptr = std::make_shared<RPCChannel>(conn);     //注意这里一定要传进去个conn我草曹操
         conn->setContext(krpcChannel_ptr);
         krpcChannel_ptr->setServices(&service_map);
+        krpcChannel_ptr->setLoadReporter(&load_reporter_);
         conn->setMessageCallback(std::bind(&RPCChannel::onMessage, krpcChannel_ptr.get(), std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
         pending_requests_.fetch_add(1);
     }
@@ -147,12 +204,34 @@ void RpcServer::OnConnection(const muduo::net::TcpConnectionPtr &conn) {
 }
 
 
+void RpcServer::Register() {
+    if (unregistered_.load()) {
+        return;
+    }
+    zkclient_.CreateBatchAsync(registry_nodes_, [this](int rc) {
+        // 在 ZooKeeper 的 completion 线程上执行，重试交给 event_loop 的定时器
+        if (rc == ZOK) {
+            LOG(INFO) << "registered " << instance_paths_.size() << " instance nodes to ZooKeeper";
+            register_backoff_ = kRegisterMinBackoff;
+            return;
+        }
+        if (rc == ZCLOSING || unregistered_.load()) {
+            return;
+        }
+        double delay = register_backoff_;
+        register_backoff_ = std::min(register_backoff_ * 2, kRegisterMaxBackoff);
+        LOG(WARNING) << "register to ZooKeeper failed: " << zerror(rc) << ", retry in " << delay << "s";
+        event_loop.runAfter(delay, std::bind(&RpcServer::Register, this));
+    });
+}
+
 void RpcServer::Cleanup() {
     LOG(INFO) << "Unregistering services from ZooKeeper...";
-    for (const auto &path : instance_paths_) {
-        LOG(INFO) <<"deleting service method:"<<path;
-//        sleep(10);
-        zkclient_.Delete(path.c_str());
+    unregistered_.store(true);
+    // 所有实例节点在一个 zoo_multi 中删除，客户端的 watcher 立刻触发
+    if (!instance_paths_.empty()) {
+        zkclient_.DeleteBatch(instance_paths_);
+        instance_paths_.clear();
     }
 //    不需要在下线时再显式调用 zoo_delete() 来清理临时节点。关闭会话就足够了！！！
     zkclient_.Close(); // closes handle and deletes ephemerals
@@ -164,6 +243,10 @@ void RpcServer::Cleanup() {
 RpcServer::~RpcServer() {
     // After loop quits, perform cleanup
     Cleanup();
+    // 预热线程持有 this，等它结束；它投递的注册任务不会再执行
+    if (warmup_thread_.joinable()) {
+        warmup_thread_.join();
+    }
     LOG(INFO) << "~RpcServer()";
 //    event_loop.quit();  // 退出事件循环
 }
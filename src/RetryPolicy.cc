@@ -0,0 +1,146 @@
+#include "RetryPolicy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+namespace {
+int64_t steadyNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double randomUnit() {
+    static thread_local std::mt19937 rng{ std::random_device{}() };
+    return std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+}
+}
+
+RetryPolicy::RetryPolicy()
+        : maxAttempts(3),
+          initialBackoff(0.01),
+          maxBackoff(1.0),
+          backoffMultiplier(2.0),
+          jitter(0.2),
+          idempotent(false) {
+    retryableCodes.push_back(Krpc::UNAVAILABLE);
+    retryableCodes.push_back(Krpc::DEADLINE_EXCEEDED);
+}
+
+bool RetryPolicy::retryable(Krpc::StatusCode code) const {
+    return std::find(retryableCodes.begin(), retryableCodes.end(), code) != retryableCodes.end();
+}
+
+double RetryPolicy::backoff(int retry) const {
+    double delay = initialBackoff;
+    for (int i = 1; i < retry && delay < maxBackoff; ++i) {
+        delay *= backoffMultiplier;
+    }
+    delay = std::min(delay, maxBackoff);
+    // 抖动让同时失败的大量调用错开重试时间，不会在同一时刻一起打到下一个实例上
+    double j = std::min(std::max(jitter, 0.0), 1.0);
+    return std::max(delay * (1 - j + 2 * j * randomUnit()), 0.0);
+}
+
+HedgingPolicy::HedgingPolicy()
+        : maxAttempts(2),
+          delay(0),
+          percentile(95),
+          initialDelay(0.05),
+          timeout(5.0),
+          readOnly(false) {}
+
+LatencyHistogram::LatencyHistogram()
+        : samples_(0),
+          quantileUs_(0),
+          percentile_(95) {
+    for (int i = 0; i < kBuckets; ++i) {
+        counts_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+int LatencyHistogram::bucketOf(int64_t latencyUs) {
+    if (latencyUs < kSubBuckets) {
+        return latencyUs < 0 ? 0 : static_cast<int>(latencyUs);
+    }
+    int log2 = 63 - __builtin_clzll(static_cast<unsigned long long>(latencyUs));
+    // 最高位之后的两位决定区间内的子区间
+    int sub = static_cast<int>((latencyUs >> (log2 - 2)) & (kSubBuckets - 1));
+    return std::min((log2 - 1) * kSubBuckets + sub, kBuckets - 1);
+}
+
+int64_t LatencyHistogram::bucketUpperUs(int bucket) {
+    if (bucket < kSubBuckets) {
+        return bucket + 1;
+    }
+    int log2 = bucket / kSubBuckets + 1;
+    int sub = bucket % kSubBuckets;
+    return (static_cast<int64_t>(kSubBuckets + sub + 1)) << (log2 - 2);
+}
+
+void LatencyHistogram::record(int64_t latencyUs) {
+    counts_[bucketOf(latencyUs)].fetch_add(1, std::memory_order_relaxed);
+    if (samples_.fetch_add(1, std::memory_order_relaxed) % kRecomputeEvery == kRecomputeEvery - 1) {
+        recompute();
+    }
+}
+
+// 由第 kRecomputeEvery 个样本的记录线程执行，期间并发的记录可能少算或多算几个，不影响分位数
+void LatencyHistogram::recompute() {
+    uint32_t counts[kBuckets];
+    uint64_t total = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        counts[i] = counts_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+        counts_[i].fetch_sub(counts[i] / 2, std::memory_order_relaxed);
+    }
+    uint64_t rank = static_cast<uint64_t>(total * percentile_.load(std::memory_order_relaxed) / 100);
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += counts[i];
+        if (seen > rank) {
+            quantileUs_.store(bucketUpperUs(i), std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+RetryBudget::RetryBudget(double ratio, double minPerSecond, double maxTokens)
+        : deposit_(static_cast<int64_t>(std::max(ratio, 0.0) * kScale)),
+          perSecond_(static_cast<int64_t>(std::max(minPerSecond, 0.0) * kScale)),
+          max_(static_cast<int64_t>(std::max(maxTokens, 1.0) * kScale)),
+          tokens_(max_),
+          lastRefillUs_(steadyNowUs()) {}
+
+void RetryBudget::onRequest() {
+    int64_t old = tokens_.load(std::memory_order_relaxed);
+    while (old < max_ &&
+           !tokens_.compare_exchange_weak(old, std::min(old + deposit_, max_), std::memory_order_relaxed)) {
+    }
+}
+
+bool RetryBudget::tryRetry() {
+    refill();
+    int64_t old = tokens_.load(std::memory_order_relaxed);
+    while (old >= kScale) {
+        if (tokens_.compare_exchange_weak(old, old - kScale, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 按距上次补充的时间补充 minPerSecond，只在重试时才需要，不放在每个请求的路径上
+void RetryBudget::refill() {
+    if (perSecond_ == 0) return;
+    int64_t now = steadyNowUs();
+    int64_t last = lastRefillUs_.load(std::memory_order_relaxed);
+    int64_t add = (now - last) * perSecond_ / (1000 * 1000);
+    if (add <= 0 || !lastRefillUs_.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+        return;
+    }
+    int64_t old = tokens_.load(std::memory_order_relaxed);
+    while (old < max_ &&
+           !tokens_.compare_exchange_weak(old, std::min(old + add, max_), std::memory_order_relaxed)) {
+    }
+}
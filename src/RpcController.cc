@@ -1,15 +1,22 @@
 #include "RpcController.h"
+#include "LoadBalancer.h"
 
 // 构造函数，初始化控制器状态
 RpcController::RpcController() {
     m_failed = false;  // 初始状态为未失败
     m_errText = "";    // 错误信息初始为空
+    m_status = Krpc::OK;
+    m_hasHashKey = false;
+    m_hashKey = 0;
 }
 
 // 重置控制器状态，将失败标志和错误信息清空
 void RpcController::Reset() {
     m_failed = false;  // 重置失败标志
     m_errText = "";    // 清空错误信息
+    m_status = Krpc::OK;
+    m_hasHashKey = false;
+    m_hashKey = 0;
 }
 
 // 判断当前RPC调用是否失败
@@ -24,8 +31,64 @@ std::string RpcController::ErrorText() const {
 
 // 设置RPC调用失败，并记录失败原因
 void RpcController::SetFailed(const std::string &reason) {
+    SetFailed(reason, Krpc::UNKNOWN);
+}
+
+void RpcController::SetFailed(const std::string &reason, Krpc::StatusCode code) {
     m_failed = true;   // 设置失败标志
     m_errText = reason; // 记录失败原因
+    m_status = code;
+}
+
+Krpc::StatusCode RpcController::Status() const {
+    return m_status;
+}
+
+// 标记调用因超时失败，错误信息由 SetFailed 设置
+void RpcController::SetTimedOut() {
+    m_failed = true;
+    m_status = Krpc::DEADLINE_EXCEEDED;
+}
+
+bool RpcController::TimedOut() const {
+    return m_status == Krpc::DEADLINE_EXCEEDED;
+}
+
+void RpcController::Fail(google::protobuf::RpcController* controller, const std::string &reason, Krpc::StatusCode code) {
+    if (controller == nullptr) {
+        return;
+    }
+    if (RpcController* rpcController = dynamic_cast<RpcController*>(controller)) {
+        rpcController->SetFailed(reason, code);
+    } else {
+        controller->SetFailed(reason);
+    }
+}
+
+Krpc::StatusCode RpcController::StatusOf(const google::protobuf::RpcController* controller) {
+    if (controller == nullptr || !controller->Failed()) {
+        return Krpc::OK;
+    }
+    const RpcController* rpcController = dynamic_cast<const RpcController*>(controller);
+    return rpcController ? rpcController->Status() : Krpc::UNKNOWN;
+}
+
+// 设置一致性哈希的 key，字符串 key 按 LoadBalancer::hash 计算
+void RpcController::SetHashKey(const std::string &key) {
+    SetHashKey(LoadBalancer::hash(key));
+}
+
+void RpcController::SetHashKey(uint64_t hash) {
+    m_hasHashKey = true;
+    m_hashKey = hash;
+}
+
+bool RpcController::HasHashKey() const {
+    return m_hasHashKey;
+}
+
+uint64_t RpcController::HashKey() const {
+    return m_hashKey;
 }
 
 // 以下功能未实现，是RPC服务端提供的取消功能
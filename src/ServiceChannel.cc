@@ -0,0 +1,440 @@
+#include "ServiceChannel.h"
+#include "ChannelPool.h"
+#include "ClientRuntime.h"
+#include "Logger.h"
+#include "FutexWaiter.h"
+#include "RpcController.h"
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <muduo/base/Timestamp.h>
+
+#include <chrono>
+#include <thread>
+
+namespace {
+PickContext pickContext(const ::google::protobuf::RpcController* controller) {
+    const RpcController* rpcController = dynamic_cast<const RpcController*>(controller);
+    if (rpcController != nullptr && rpcController->HasHashKey()) {
+        return PickContext::withHash(rpcController->HashKey());
+    }
+    return PickContext();
+}
+
+// 重试前清掉上一次的失败和 response，保留调用方设置的哈希 key
+void resetForRetry(::google::protobuf::RpcController* controller, ::google::protobuf::Message* response) {
+    RpcController* rpcController = dynamic_cast<RpcController*>(controller);
+    if (rpcController != nullptr && rpcController->HasHashKey()) {
+        uint64_t hash = rpcController->HashKey();
+        rpcController->Reset();
+        rpcController->SetHashKey(hash);
+    } else {
+        controller->Reset();
+    }
+    response->Clear();
+}
+
+// 同步调用走对冲时的 done：唤醒阻塞在 CallMethod 里的调用线程
+class WakeClosure : public ::google::protobuf::Closure {
+public:
+    void Run() override { waiter.wake(); }
+    FutexWaiter waiter;
+};
+
+int64_t nowUs() {
+    return muduo::Timestamp::now().microSecondsSinceEpoch();
+}
+
+// 同步对冲调用在 HedgingPolicy.timeout 之外多等的时间（秒），正常情况下由超时定时器结束调用
+const double kHedgeWaitMargin = 1.0;
+}
+
+// 异步调用的状态，作为每次尝试的 done；最后一次尝试结束后执行用户 done 并删除自己
+class ServiceChannel::AsyncCall : public ::google::protobuf::Closure {
+public:
+    AsyncCall(const MethodStatePtr& state,
+              const std::shared_ptr<RetryBudget>& budget,
+              const ::google::protobuf::MethodDescriptor* method,
+              ::google::protobuf::RpcController* controller,
+              const ::google::protobuf::Message* request,
+              ::google::protobuf::Message* response,
+              ::google::protobuf::Closure* done)
+            : state_(state), budget_(budget), method_(method),
+              controller_(controller ? controller : &localController_),
+              request_(request), response_(response), done_(done), attempts_(0) {}
+
+    void attempt() {
+        ++attempts_;
+        ClientChannelPtr channel = ServiceChannel::pickChannel(*state_, attempts_, controller_, response_, &tried_);
+        if (!channel) {
+            finish();
+            return;
+        }
+        channel->CallMethod(method_, controller_, request_, response_, this);
+    }
+
+    void Run() override {
+        if (!controller_->Failed() || !ServiceChannel::shouldRetry(*state_, budget_.get(), controller_, attempts_)) {
+            finish();
+            return;
+        }
+        ClientRuntime::instance().nextLoop()->runAfter(state_->policy.backoff(attempts_),
+                                                        std::bind(&AsyncCall::attempt, this));
+    }
+
+private:
+    void finish() {
+        done_->Run();
+        delete this;
+    }
+
+    MethodStatePtr                                 state_;
+    std::shared_ptr<RetryBudget>                   budget_;
+    const ::google::protobuf::MethodDescriptor*    method_;
+    RpcController                                  localController_;
+    ::google::protobuf::RpcController*             controller_;
+    const ::google::protobuf::Message*             request_;
+    ::google::protobuf::Message*                   response_;
+    ::google::protobuf::Closure*                   done_;
+    int                                            attempts_;
+    std::vector<std::string>                       tried_;
+};
+
+// 对冲调用：每一份请求有自己的 controller 和 response，先成功的一份（或全部失败时最后一份）
+// 把结果交给调用方，其余在途的从 outstanding 表中取消。由在途的各份请求和定时器回调共同持有，
+// 最后一份请求结束后释放
+class ServiceChannel::HedgedCall : public std::enable_shared_from_this<ServiceChannel::HedgedCall> {
+public:
+    HedgedCall(const MethodStatePtr& state,
+               const std::shared_ptr<RetryBudget>& budget,
+               const ::google::protobuf::MethodDescriptor* method,
+               ::google::protobuf::RpcController* controller,
+               const ::google::protobuf::Message* request,
+               ::google::protobuf::Message* response,
+               ::google::protobuf::Closure* done)
+            : state_(state), budget_(budget), method_(method), ctx_(pickContext(controller)),
+              controller_(controller), request_(request), response_(response), done_(done),
+              loop_(ClientRuntime::instance().nextLoop()), startUs_(nowUs()), finished_(false), inflight_(0) {
+        attempts_.reserve(state_->hedging.maxAttempts);
+    }
+
+    void start() {
+        if (!launch(request_)) {
+            RpcController::Fail(controller_, "no available endpoint for " + state_->name, Krpc::UNAVAILABLE);
+            done_->Run();
+            return;
+        }
+        std::weak_ptr<HedgedCall> weak(shared_from_this());
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (finished_) return;
+        timeoutTimer_ = loop_->runAfter(state_->hedging.timeout, [weak]() {
+            if (std::shared_ptr<HedgedCall> call = weak.lock()) call->onTimeout();
+        });
+        scheduleHedgeLocked();
+    }
+
+    // 以 DEADLINE_EXCEEDED 结束调用，取消在途的各份；已经结束时什么也不做
+    void onTimeout() {
+        std::vector<Attempt*> losers;
+        muduo::net::TimerId hedgeTimer;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (finished_) return;
+            finished_ = true;
+            collectLosersLocked(nullptr, &losers);
+            hedgeTimer = hedgeTimer_;
+        }
+        loop_->cancel(hedgeTimer);
+        cancel(losers);
+        RpcController::Fail(controller_, "rpc call timed out", Krpc::DEADLINE_EXCEEDED);
+        done_->Run();
+    }
+
+private:
+    struct Attempt : public ::google::protobuf::Closure {
+        std::shared_ptr<HedgedCall>                    call;      // 在途期间保持调用存活，结束时释放
+        RpcController                                  controller;
+        std::unique_ptr<::google::protobuf::Message>   response;
+        ClientChannelPtr                               channel;
+        int64_t                                        id;        // 0 表示不能取消（排队等连接或本地失败）
+        bool                                           completed;
+
+        void Run() override {
+            std::shared_ptr<HedgedCall> self;
+            self.swap(call);
+            self->onAttemptDone(this);
+        }
+    };
+
+    // 向一个还没试过的实例发出一份，没有可选实例时返回 false
+    bool launch(const ::google::protobuf::Message* request) {
+        const Endpoint* ep = ServiceDiscovery::instance().pickEndpointExcept(state_->key, ctx_, tried_);
+        if (ep == nullptr) {
+            return false;
+        }
+        tried_.push_back(ep->hostPort);
+        std::unique_ptr<Attempt> attempt(new Attempt);
+        if (ctx_.hasHashKey) attempt->controller.SetHashKey(ctx_.hashKey);
+        attempt->response.reset(response_->New());
+        attempt->channel = ChannelPool::instance().getChannel(*ep);
+        attempt->id = 0;
+        attempt->completed = false;
+        attempt->call = shared_from_this();
+        Attempt* raw = attempt.get();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            attempts_.push_back(std::move(attempt));
+            ++inflight_;
+        }
+        int64_t id = raw->channel->CallAsync(method_, &raw->controller, request, raw->response.get(), raw);
+        std::lock_guard<std::mutex> lock(mutex_);
+        raw->id = id;
+        return true;
+    }
+
+    // 调用方需持有 mutex_
+    void scheduleHedgeLocked() {
+        if (static_cast<int>(attempts_.size()) >= state_->hedging.maxAttempts) {
+            return;
+        }
+        double delay = state_->hedging.delay;
+        if (delay <= 0) {
+            int64_t quantile = state_->latency->quantileUs();
+            delay = quantile > 0 ? quantile / 1e6 : state_->hedging.initialDelay;
+        }
+        std::weak_ptr<HedgedCall> weak(shared_from_this());
+        hedgeTimer_ = loop_->runAfter(delay, [weak]() {
+            if (std::shared_ptr<HedgedCall> call = weak.lock()) call->onHedgeTimer();
+        });
+    }
+
+    void onHedgeTimer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (finished_) return;
+            // 后续各份使用请求的拷贝：先到的结果交给调用方后，调用方随时可能释放 request
+            if (!requestCopy_) {
+                requestCopy_.reset(request_->New());
+                requestCopy_->CopyFrom(*request_);
+            }
+        }
+        // 预算用完或没有其他实例时不再对冲，等已发出的结果
+        if (!budget_->tryRetry() || !launch(requestCopy_.get())) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!finished_) scheduleHedgeLocked();
+    }
+
+    void onAttemptDone(Attempt* attempt) {
+        bool ok = !attempt->controller.Failed();
+        std::vector<Attempt*> losers;
+        muduo::net::TimerId hedgeTimer, timeoutTimer;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            attempt->completed = true;
+            --inflight_;
+            // 已经有结果了（被取消的落选者也走到这里），或者失败了但还有其他份在途
+            if (finished_ || (!ok && inflight_ > 0)) {
+                return;
+            }
+            finished_ = true;
+            collectLosersLocked(attempt, &losers);
+            hedgeTimer = hedgeTimer_;
+            timeoutTimer = timeoutTimer_;
+        }
+        loop_->cancel(hedgeTimer);
+        loop_->cancel(timeoutTimer);
+        cancel(losers);
+        if (ok) {
+            // 从整个调用开始计时：只记胜出那份自己的耗时会偏小（慢的那份总被取消），对冲延迟越压越低
+            state_->latency->record(nowUs() - startUs_);
+            response_->GetReflection()->Swap(response_, attempt->response.get());
+        } else {
+            RpcController::Fail(controller_, attempt->controller.ErrorText(), attempt->controller.Status());
+        }
+        done_->Run();
+    }
+
+    // 调用方需持有 mutex_
+    void collectLosersLocked(Attempt* winner, std::vector<Attempt*>* losers) {
+        for (size_t i = 0; i < attempts_.size(); ++i) {
+            Attempt* a = attempts_[i].get();
+            if (a != winner && !a->completed && a->id != 0) {
+                losers->push_back(a);
+            }
+        }
+    }
+
+    // 锁外执行：cancel 会同步执行落选者的 done，回到 onAttemptDone
+    void cancel(const std::vector<Attempt*>& losers) {
+        for (size_t i = 0; i < losers.size(); ++i) {
+            losers[i]->channel->cancel(losers[i]->id);
+        }
+    }
+
+    MethodStatePtr                                 state_;
+    std::shared_ptr<RetryBudget>                   budget_;
+    const ::google::protobuf::MethodDescriptor*    method_;
+    PickContext                                    ctx_;
+    ::google::protobuf::RpcController*             controller_;
+    const ::google::protobuf::Message*             request_;
+    ::google::protobuf::Message*                   response_;
+    ::google::protobuf::Closure*                   done_;
+    muduo::net::EventLoop*                         loop_;
+    int64_t                                        startUs_;
+    std::vector<std::string>                       tried_;      // 只在 start 和依次触发的对冲定时器中访问
+
+    std::mutex                                     mutex_;
+    std::vector<std::unique_ptr<Attempt>>          attempts_;
+    std::unique_ptr<::google::protobuf::Message>   requestCopy_;
+    bool                                           finished_;
+    int                                            inflight_;
+    muduo::net::TimerId                            hedgeTimer_;
+    muduo::net::TimerId                            timeoutTimer_;
+};
+
+ServiceChannel::ServiceChannel(const std::string& service)
+        : service_(service),
+          budget_(std::make_shared<RetryBudget>()),
+          hedgeBudget_(std::make_shared<RetryBudget>()) {
+    defaultPolicy_.maxAttempts = 1;
+}
+
+void ServiceChannel::setDefaultRetryPolicy(const RetryPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    defaultPolicy_ = policy;
+    states_.clear();
+}
+
+void ServiceChannel::setRetryPolicy(const std::string& method, const RetryPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policies_[method] = policy;
+    states_.clear();
+}
+
+void ServiceChannel::setHedgingPolicy(const std::string& method, const HedgingPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hedgingPolicies_[method] = policy;
+    states_.clear();
+}
+
+ServiceChannel::MethodStatePtr ServiceChannel::methodState(const ::google::protobuf::MethodDescriptor* method) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = states_.find(method);
+        if (it != states_.end()) {
+            return it->second;
+        }
+    }
+    // 第一次 resolve 会同步访问 ZooKeeper，不在锁内做
+    ServiceKey key = ServiceDiscovery::instance().resolve(service_, method->name());
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto pit = policies_.find(method->name());
+    std::shared_ptr<MethodState> state = std::make_shared<MethodState>();
+    state->key = key;
+    state->name = service_ + "/" + method->name();
+    state->policy = pit != policies_.end() ? pit->second : defaultPolicy_;
+    state->idempotent = state->policy.idempotent ||
+            method->options().idempotency_level() != ::google::protobuf::MethodOptions::IDEMPOTENCY_UNKNOWN;
+    auto hit = hedgingPolicies_.find(method->name());
+    if (hit != hedgingPolicies_.end()) {
+        state->hedging = hit->second;
+    }
+    state->hedged = hit != hedgingPolicies_.end() && state->hedging.maxAttempts > 1 &&
+            (state->hedging.readOnly ||
+             method->options().idempotency_level() == ::google::protobuf::MethodOptions::NO_SIDE_EFFECTS);
+    std::shared_ptr<LatencyHistogram>& latency = latencies_[method];
+    if (!latency) {
+        latency = std::make_shared<LatencyHistogram>();
+    }
+    latency->setPercentile(state->hedging.percentile);
+    state->latency = latency;
+    states_[method] = state;
+    return state;
+}
+
+ClientChannelPtr ServiceChannel::pickChannel(const MethodState& state, int attempt,
+                                             ::google::protobuf::RpcController* controller,
+                                             ::google::protobuf::Message* response,
+                                             std::vector<std::string>* tried) {
+    const Endpoint* ep = ServiceDiscovery::instance().pickEndpointExcept(state.key, pickContext(controller), *tried);
+    if (ep == nullptr) {
+        // 重试时找不到没试过的实例：保留上一次的失败
+        if (attempt == 1) {
+            RpcController::Fail(controller, "no available endpoint for " + state.name, Krpc::UNAVAILABLE);
+        }
+        return ClientChannelPtr();
+    }
+    if (attempt > 1) {
+        LOG(WARNING) << "retrying " << state.name << " on " << ep->hostPort << " (attempt " << attempt
+                     << "/" << state.policy.maxAttempts << ") after: " << controller->ErrorText();
+        resetForRetry(controller, response);
+    }
+    // 只有可能重试的调用才需要记录试过的实例
+    if (state.idempotent && attempt < state.policy.maxAttempts) {
+        tried->push_back(ep->hostPort);
+    }
+    return ChannelPool::instance().getChannel(*ep);
+}
+
+bool ServiceChannel::shouldRetry(const MethodState& state, RetryBudget* budget,
+                                 const ::google::protobuf::RpcController* controller, int attempts) {
+    return state.idempotent
+        && attempts < state.policy.maxAttempts
+        && state.policy.retryable(RpcController::StatusOf(controller))
+        && budget->tryRetry();
+}
+
+void ServiceChannel::CallMethod(const ::google::protobuf::MethodDescriptor* method,
+                                ::google::protobuf::RpcController* controller,
+                                const ::google::protobuf::Message* request,
+                                ::google::protobuf::Message* response,
+                                ::google::protobuf::Closure* done) {
+    MethodStatePtr state = methodState(method);
+    if (state->hedged) {
+        hedgeBudget_->onRequest();
+        if (done != nullptr) {
+            std::make_shared<HedgedCall>(state, hedgeBudget_, method, controller, request, response, done)->start();
+            return;
+        }
+        // 同步调用：结果由 IO 线程投递，在 IO 线程上阻塞等待必然死锁
+        if (ClientRuntime::instance().inLoopThread()) {
+            RpcController::Fail(controller, "blocking hedged call on a client IO thread", Krpc::INTERNAL);
+            return;
+        }
+        // 等待整个对冲调用结束。超时定时器所在的 loop 被阻塞时由调用线程自己结束调用；
+        // 结束流程已经在别的线程上开始时，等它执行完 done，之后不再访问 controller 和 response
+        WakeClosure wake;
+        std::shared_ptr<HedgedCall> call =
+                std::make_shared<HedgedCall>(state, hedgeBudget_, method, controller, request, response, &wake);
+        call->start();
+        if (!wake.waiter.waitFor(state->hedging.timeout + kHedgeWaitMargin)) {
+            call->onTimeout();
+            wake.waiter.wait();
+        }
+        return;
+    }
+    budget_->onRequest();
+    if (done != nullptr) {
+        (new AsyncCall(state, budget_, method, controller, request, response, done))->attempt();
+        return;
+    }
+    // 同步调用：在调用线程上重试，退避期间阻塞当前线程
+    RpcController localController;
+    if (controller == nullptr) {
+        controller = &localController;
+    }
+    std::vector<std::string> tried;
+    for (int attempts = 1; ; ++attempts) {
+        ClientChannelPtr channel = pickChannel(*state, attempts, controller, response, &tried);
+        if (!channel) {
+            return;
+        }
+        channel->CallMethod(method, controller, request, response, nullptr);
+        if (!controller->Failed() || !shouldRetry(*state, budget_.get(), controller, attempts)) {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(state->policy.backoff(attempts)));
+    }
+}
@@ -2,6 +2,80 @@
 // Created by orange on 4/30/25.
 //
 #include "ServiceDiscovery.h"
+#include "Application.h"
+#include "FutexWaiter.h"
+#include "DiscoverySnapshot.h"
+#include "rpc.pb.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <set>
+#include <sstream>
+
+namespace {
+// 首次订阅等待 ZooKeeper 返回的最长时间（秒）
+const double kSubscribeTimeout = 5.0;
+// 新布局下 service 节点下的实例目录名，以及实例数据中列出方法的属性名
+const char kInstancesNode[] = "instances";
+const char kMethodsAttr[]   = "methods=";
+// 慢启动实例的最小流量比例，以及被拒绝后最多重选几次
+const double kSlowStartMinFactor  = 0.1;
+const int    kSlowStartMaxRepicks = 3;
+// 选中被摘除的实例时最多重选几次，之后顺序查找
+const int    kOutlierMaxRepicks = 2;
+// pickEndpointExcept 按原策略重选的次数，之后顺序查找
+const int    kExceptMaxRepicks = 3;
+// 当前线程正在执行成员变化回调：回调中 resolve 新的 key 时不等待首次拉取
+thread_local bool tls_notifying = false;
+
+// 配置文件中的非负小数，缺省或无法解析时返回 fallback
+double configDouble(const std::string& key, double fallback) {
+    std::string text = Application::Instance().GetConfig(key);
+    if (text.empty()) return fallback;
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || *end != '\0' || !(value >= 0)) {
+        LOG(WARNING) << "ignore invalid config " << key << "=" << text;
+        return fallback;
+    }
+    return value;
+}
+
+// 从实例数据中取出方法列表，其余部分作为单个方法下的实例数据：
+// protobuf 编码时清空 EndpointMeta::methods 后重新序列化，文本格式时去掉 "methods=Login,Register" 属性
+void splitMethods(const std::string& raw, std::string* data, std::vector<std::string>* methods) {
+    data->clear();
+    methods->clear();
+    if (Endpoint::isMeta(raw)) {
+        Krpc::EndpointMeta meta;
+        if (!meta.ParseFromString(raw)) {
+            return;
+        }
+        methods->assign(meta.methods().begin(), meta.methods().end());
+        meta.clear_methods();
+        meta.SerializeToString(data);
+        return;
+    }
+    size_t begin = 0;
+    while (begin <= raw.size()) {
+        size_t end = raw.find(';', begin);
+        if (end == std::string::npos) end = raw.size();
+        std::string attr = raw.substr(begin, end - begin);
+        if (attr.compare(0, sizeof(kMethodsAttr) - 1, kMethodsAttr) == 0) {
+            std::stringstream ss(attr.substr(sizeof(kMethodsAttr) - 1));
+            std::string name;
+            while (std::getline(ss, name, ',')) {
+                if (!name.empty()) methods->push_back(name);
+            }
+        } else if (!attr.empty()) {
+            if (!data->empty()) data->push_back(';');
+            data->append(attr);
+        }
+        begin = end + 1;
+    }
+}
+}
 
 // 简单的 split 工具函数：按单一字符分割
 static std::vector<std::string> split(const std::string& s, char delim) {
@@ -81,49 +155,468 @@ ServiceDiscovery &ServiceDiscovery::instance() {
 
 // ServiceDiscovery.cpp
 void ServiceDiscovery::init(const std::string& host, const std::string& port) {
-    zkClient_.Start(host, port);
+    init(host, port, std::vector<std::string>());
+}
 
-    // 列出根目录下所有 service
+// 只建立连接，不再遍历整棵树：各 service/method 在第一次 resolve / pickHost 时才拉取并注册 watcher。
+// prefetch 中的项（"service/method"、"service" 或 "*"）在这里预先订阅，所有方法的拉取并发进行
+void ServiceDiscovery::init(const std::string& host, const std::string& port,
+                            const std::vector<std::string>& prefetch) {
+    // 本进程所在的可用区与 server 注册时使用同一个配置项；在载入快照前设好，快照中的服务直接按可用区分组
+    std::string zone = Application::Instance().GetConfig("zone");
+    if (!zone.empty()) {
+        setLocalZone(zone);
+    }
+    setZoneSpillover(configDouble("zone_min_healthy", zoneMinHealthy_.load(std::memory_order_relaxed)),
+                     configDouble("zone_max_utilization", zoneMaxUtilization_.load(std::memory_order_relaxed)));
+    startWorkers();
+    size_t loaded = loadSnapshot();
+    zkClient_.SetConnectedCallback(std::bind(&ServiceDiscovery::onZkConnected, this));
+    bool connected = false;
+    if (zkClient_.Connect(host, port)) {
+        // 有快照时不等 ZooKeeper，先用快照中的列表提供服务，连上后由 onZkConnected 刷新
+        connected = loaded > 0 ? zkClient_.IsConnected() : zkClient_.WaitConnected(connectTimeout_);
+    }
+    if (connected) {
+        LOG(INFO) << "zookeeper_init success";
+    } else {
+        LOG(WARNING) << "zookeeper " << host << ":" << port << " not connected yet, serving "
+                     << loaded << " methods from local snapshot";
+    }
 
-    auto sv = zkClient_.GetChildren("/");
+    std::vector<MethodName> methods;
+    std::vector<std::string> instanceServices;
+    for (size_t i = 0; i < prefetch.size(); ++i) {
+        const std::string& item = prefetch[i];
+        size_t slash = item.find('/');
+        if (slash != std::string::npos) {
+            methods.push_back(MethodName(item.substr(0, slash), item.substr(slash + 1)));
+            continue;
+        }
+        if (!connected) {
+            // 展开整个 service 需要同步读 ZooKeeper，未连上时跳过，其下的方法在 resolve 时再订阅
+            continue;
+        }
+        std::vector<std::string> services;
+        if (item == "*") {
+            services = zkClient_.GetChildren("/");
+        } else {
+            services.push_back(item);
+        }
+        for (size_t j = 0; j < services.size(); ++j) {
+            if (services[j] == "zookeeper") continue;
+            std::vector<std::string> names = zkClient_.GetChildren(("/" + services[j]).c_str());
+            for (size_t k = 0; k < names.size(); ++k) {
+                if (names[k] == kInstancesNode) {
+                    // 新布局：方法只出现在实例数据里，拉取实例后再展开
+                    instanceServices.push_back(services[j]);
+                } else {
+                    methods.push_back(MethodName(services[j], names[k]));
+                }
+            }
+        }
+    }
+    if (!instanceServices.empty()) {
+        std::shared_ptr<FutexWaiter> fetched = std::make_shared<FutexWaiter>();
+        std::shared_ptr<std::atomic<size_t>> remaining =
+                std::make_shared<std::atomic<size_t>>(instanceServices.size());
+        for (size_t i = 0; i < instanceServices.size(); ++i) {
+            fetchServiceAsync(instanceServices[i], [fetched, remaining]() {
+                if (remaining->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    fetched->wake();
+                }
+            });
+        }
+        fetched->waitFor(kSubscribeTimeout);
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        for (size_t i = 0; i < instanceServices.size(); ++i) {
+            auto it = instances_.find(instanceServices[i]);
+            if (it == instances_.end()) continue;
+            std::set<std::string> names;
+            for (size_t j = 0; j < it->second.instances.size(); ++j) {
+                const std::vector<std::string>& served = it->second.instances[j].methods;
+                names.insert(served.begin(), served.end());
+            }
+            for (auto name = names.begin(); name != names.end(); ++name) {
+                methods.push_back(MethodName(instanceServices[i], *name));
+            }
+        }
+    }
+    for (size_t i = 0; i < methods.size(); ++i) {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        keyIdLocked(methods[i].first + "/" + methods[i].second);
+    }
+    subscribe(methods);
+}
 
-    for (int i = 0; i < sv.size(); ++i) {
-        std::string service = sv[i];
-        if (service == "zookeeper") continue;
+// 一次 subscribe 发起的首次拉取，登记在 subscribing_ 中，同一 key 的其他 resolve 等它完成
+struct ServiceDiscovery::Subscription {
+    std::vector<std::string>  keys;
+    FutexWaiter               fetched;
+    std::atomic<size_t>       remaining;
+    std::atomic<bool>         finished;
 
-        std::string servicePath = "/" + service;
+    Subscription() : remaining(0), finished(false) {}
+};
 
-        auto mv = zkClient_.GetChildren(servicePath.c_str());
+void ServiceDiscovery::subscribe(const std::vector<MethodName>& methods) {
+    // 只有第一个订阅某 key 的线程去拉取，同一 key 并发 resolve 的线程等它完成；
+    // 不持有任何锁等待，不同 key 的首次拉取互不影响
+    std::shared_ptr<Subscription> mine = std::make_shared<Subscription>();
+    std::vector<std::shared_ptr<Subscription>> others;
+    std::vector<MethodName> todo;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        for (size_t i = 0; i < methods.size(); ++i) {
+            std::string key = methods[i].first + "/" + methods[i].second;
+            if (subscribed_.count(key)) continue;
+            auto it = subscribing_.find(key);
+            if (it != subscribing_.end()) {
+                if (std::find(others.begin(), others.end(), it->second) == others.end()) {
+                    others.push_back(it->second);
+                }
+                continue;
+            }
+            subscribing_[key] = mine;
+            mine->keys.push_back(key);
+            todo.push_back(methods[i]);
+            // 先登记 watcher 关注的 key，首次拉取期间到达的事件不会丢
+            watched_.insert(key);
+        }
+    }
 
-        for (int j = 0; j < mv.size(); ++j) {
-            std::string method = mv[j];
-            std::string methodPath = servicePath + "/" + method;
+    if (!todo.empty()) {
+        startSubscription(mine, todo);
+    }
+    // 成员变化回调运行在 watcher / completion 线程上，拉取结果正要由这些线程写入，在这里等待只会等到超时：
+    // 不等，拉取完成后自行登记为已订阅
+    if (tls_notifying) {
+        return;
+    }
+    if (!todo.empty()) {
+        waitSubscription(mine);
+    }
+    for (size_t i = 0; i < others.size(); ++i) {
+        waitSubscription(others[i]);
+    }
+}
 
-            // 同时对节点数据和子节点都注册 watcher
-            struct String_vector av;
-            zkClient_.GetChildrenW(methodPath.c_str(),zkWatcher, this, &av);
+void ServiceDiscovery::startSubscription(const std::shared_ptr<Subscription>& sub, const std::vector<MethodName>& todo) {
+    LOG(INFO) << "subscribing " << todo.size() << " methods";
+    // 每个方法都拉一次方法节点：滚动升级期间还没升级的 server 仍按旧布局注册，两种布局的实例合并使用。
+    // 布局未知的 service 再拉一次 instances，已拉到 instances 的在方法节点返回后本地展开合并
+    std::set<std::string> unknown;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        for (size_t i = 0; i < todo.size(); ++i) {
+            const std::string& service = todo[i].first;
+            legacyMethods_[service + "/" + todo[i].second];
+            if (!instances_.count(service) && !legacyServices_.count(service)) {
+                unknown.insert(service);
+            }
+        }
+    }
 
-            std::vector<std::string> hosts;
-            if (av.count == 0) {
-                char buf[128];
-                int len = sizeof(buf);
-                zkClient_.GetDataW(methodPath.c_str(), zkWatcher, this, buf, &len);
-                hosts.emplace_back(buf, len);
-            } else {
-                for (int k = 0; k < av.count; ++k) {
-                    std::string instPath = methodPath + "/" + av.data[k];
-                    char buf[128];
-                    int len = sizeof(buf);
-                    zkClient_.GetDataW(instPath.c_str(), zkWatcher, this, buf, &len);
-                    hosts.emplace_back(buf, len);
+    sub->remaining.store(todo.size() + unknown.size());
+    std::function<void()> done = [this, sub]() {
+        if (sub->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            finishSubscription(sub);
+        }
+    };
+    for (size_t i = 0; i < todo.size(); ++i) {
+        fetchMethodAsync(todo[i].first, todo[i].second, done);
+    }
+    for (auto it = unknown.begin(); it != unknown.end(); ++it) {
+        fetchServiceAsync(*it, done);
+    }
+}
+
+void ServiceDiscovery::waitSubscription(const std::shared_ptr<Subscription>& sub) {
+    if (!sub->fetched.waitFor(kSubscribeTimeout)) {
+        LOG(WARNING) << "subscribe timed out, " << sub->remaining.load() << " fetches still pending";
+        // 超时也视为已订阅，之后的 resolve 不再等待，拉取返回或 watcher 触发时再更新
+        finishSubscription(sub);
+    }
+}
+
+void ServiceDiscovery::finishSubscription(const std::shared_ptr<Subscription>& sub) {
+    if (sub->finished.exchange(true)) return;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        for (size_t i = 0; i < sub->keys.size(); ++i) {
+            subscribed_.insert(sub->keys[i]);
+            auto it = subscribing_.find(sub->keys[i]);
+            if (it != subscribing_.end() && it->second == sub) {
+                subscribing_.erase(it);
+            }
+        }
+    }
+    sub->fetched.wake();
+}
+
+// 一次方法节点拉取：子节点列表返回后，所有实例的 GetData 一次性发出，最后一个返回时写入缓存
+struct ServiceDiscovery::MethodFetch {
+    std::string                 service;
+    std::string                 key;
+    std::string                 path;
+    uint64_t                    seq;
+    bool                        failed;
+    bool                        instances;   // 拉取的是 /service/instances
+    std::vector<std::string>    hosts;
+    std::atomic<size_t>         remaining;
+    std::function<void()>       done;
+
+    MethodFetch() : seq(0), failed(false), instances(false), remaining(0) {}
+};
+
+void ServiceDiscovery::fetchMethodAsync(const std::string& service, const std::string& method,
+                                        std::function<void()> done) {
+    std::shared_ptr<MethodFetch> fetch = std::make_shared<MethodFetch>();
+    fetch->service = service;
+    fetch->key     = service + "/" + method;
+    fetch->path    = "/" + service + "/" + method;
+    fetch->done    = std::move(done);
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        fetch->seq = ++nextFetchSeq_;
+    }
+
+    zkClient_.AsyncGetChildrenW(fetch->path.c_str(), zkWatcher, this,
+            [this, fetch](int rc, const std::vector<std::string>& children) {
+        if (rc == ZNONODE) {
+            // 方法节点还不存在：注册 exists watcher，创建后由事件触发重新拉取
+            zkClient_.AsyncExistsW(fetch->path.c_str(), zkWatcher, this,
+                                   [this, fetch](int) { finishFetch(fetch); });
+            return;
+        }
+        if (rc != ZOK) {
+            LOG(ERROR) << "fetch " << fetch->path << " failed: code=" << rc;
+            fetch->failed = true;
+            finishFetch(fetch);
+            return;
+        }
+        // 兼容旧的注册方式：没有实例子节点时，实例地址直接写在方法节点上
+        std::vector<std::string> paths;
+        if (children.empty()) {
+            paths.push_back(fetch->path);
+        } else {
+            for (size_t i = 0; i < children.size(); ++i) {
+                paths.push_back(fetch->path + "/" + children[i]);
+            }
+        }
+        fetchDataAsync(fetch, paths);
+    });
+}
+
+void ServiceDiscovery::fetchServiceAsync(const std::string& service, std::function<void()> done) {
+    std::shared_ptr<MethodFetch> fetch = std::make_shared<MethodFetch>();
+    fetch->service   = service;
+    fetch->key       = service + "/" + kInstancesNode;
+    fetch->path      = "/" + fetch->key;
+    fetch->instances = true;
+    fetch->done      = std::move(done);
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        fetch->seq = ++nextFetchSeq_;
+    }
+
+    zkClient_.AsyncGetChildrenW(fetch->path.c_str(), zkWatcher, this,
+            [this, fetch](int rc, const std::vector<std::string>& children) {
+        if (rc == ZNONODE) {
+            // 还没有 server 按新布局注册：监听 instances 节点的创建，同时按旧布局逐个方法拉取
+            zkClient_.AsyncExistsW(fetch->path.c_str(), zkWatcher, this, [this, fetch](int rc) {
+                if (rc == ZOK) {
+                    // 两次读取之间节点刚被创建，重新拉一次
+                    fetchServiceAsync(fetch->service, fetch->done);
+                } else {
+                    fallbackToMethods(fetch);
                 }
+            });
+            return;
+        }
+        if (rc != ZOK) {
+            LOG(ERROR) << "fetch " << fetch->path << " failed: code=" << rc;
+            fetch->failed = true;
+            finishFetch(fetch);
+            return;
+        }
+        if (children.empty()) {
+            finishFetch(fetch);
+            return;
+        }
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < children.size(); ++i) {
+            paths.push_back(fetch->path + "/" + children[i]);
+        }
+        fetchDataAsync(fetch, paths);
+    });
+}
+
+void ServiceDiscovery::fetchDataAsync(const std::shared_ptr<MethodFetch>& fetch,
+                                      const std::vector<std::string>& paths) {
+    fetch->hosts.resize(paths.size());
+    fetch->remaining.store(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        zkClient_.AsyncGetDataW(paths[i].c_str(), zkWatcher, this,
+                [this, fetch, i](int rc, const std::string& data) {
+            // ZNONODE：实例在两次读取之间下线，跳过即可，子节点 watcher 会再触发一次
+            if (rc == ZOK) {
+                fetch->hosts[i] = data;
+            }
+            if (fetch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                finishFetch(fetch);
+            }
+        });
+    }
+}
+
+// 在 completion 线程上调用：该 service 没有（或不再有）instances 节点，只剩旧布局。
+// 已拉到过方法节点的 key 去掉新布局的实例后重新发布；不再拉取方法节点的 key 重新拉取
+void ServiceDiscovery::fallbackToMethods(const std::shared_ptr<MethodFetch>& fetch) {
+    std::vector<std::string> methods;
+    std::vector<std::pair<std::string, std::vector<std::string>>> updates;
+    uint64_t seq = 0;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        legacyServices_.insert(fetch->service);
+        bool hadInstances = instances_.erase(fetch->service) > 0;
+        unsynced_.erase(fetch->key);
+        std::string prefix = fetch->service + "/";
+        for (auto it = watched_.begin(); it != watched_.end(); ++it) {
+            if (it->compare(0, prefix.size(), prefix) != 0) continue;
+            auto legacy = legacyMethods_.find(*it);
+            if (legacy == legacyMethods_.end()) {
+                methods.push_back(it->substr(prefix.size()));
+            } else if (hadInstances && legacy->second.seq != 0) {
+                updates.push_back(std::make_pair(*it, mergedHostsLocked(fetch->service, *it)));
+            }
+            // seq 为 0：首次拉取还在进行，返回后自行发布
+        }
+        if (!updates.empty()) seq = ++nextFetchSeq_;
+    }
+    for (size_t i = 0; i < updates.size(); ++i) {
+        updateHosts(fetch->service, updates[i].first, updates[i].second, seq);
+    }
+    std::function<void()> done = fetch->done;
+    if (methods.empty()) {
+        if (done) done();
+        return;
+    }
+    std::shared_ptr<std::atomic<size_t>> remaining = std::make_shared<std::atomic<size_t>>(methods.size());
+    for (size_t i = 0; i < methods.size(); ++i) {
+        fetchMethodAsync(fetch->service, methods[i], [remaining, done]() {
+            if (remaining->fetch_sub(1, std::memory_order_acq_rel) == 1 && done) {
+                done();
             }
+        });
+    }
+}
+
+// 在 watcher 线程上调用：记下 service 的全部实例，再按方法展开更新已订阅的 key。
+// 展开用的序号在锁内分配，与 subscribe 中的本地展开按读取 instances_ 的先后排序
+void ServiceDiscovery::applyInstances(const std::shared_ptr<MethodFetch>& fetch) {
+    std::vector<InstanceInfo> parsed;
+    parsed.reserve(fetch->hosts.size());
+    for (size_t i = 0; i < fetch->hosts.size(); ++i) {
+        if (fetch->hosts[i].empty()) continue;
+        InstanceInfo info;
+        splitMethods(fetch->hosts[i], &info.data, &info.methods);
+        parsed.push_back(std::move(info));
+    }
+
+    std::vector<std::pair<std::string, std::vector<std::string>>> updates;
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        ServiceInstances& service = instances_[fetch->service];
+        if (fetch->seq <= service.seq) {
+            return;
+        }
+        service.seq = fetch->seq;
+        service.instances.swap(parsed);
+        legacyServices_.erase(fetch->service);
+        unsynced_.erase(fetch->key);
+        std::string prefix = fetch->service + "/";
+        for (auto it = watched_.begin(); it != watched_.end(); ++it) {
+            if (it->compare(0, prefix.size(), prefix) == 0) {
+                updates.push_back(std::make_pair(*it, mergedHostsLocked(fetch->service, *it)));
+            }
+        }
+        seq = ++nextFetchSeq_;
+    }
+    for (size_t i = 0; i < updates.size(); ++i) {
+        updateHosts(fetch->service, updates[i].first, updates[i].second, seq);
+    }
+}
+
+// 在 watcher 线程上调用：记下旧布局方法节点下的实例，与新布局展开的实例合并后更新
+void ServiceDiscovery::applyMethodHosts(const std::shared_ptr<MethodFetch>& fetch) {
+    std::vector<std::string> hosts;
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        LegacyMethod& legacy = legacyMethods_[fetch->key];
+        if (fetch->seq <= legacy.seq) {
+            return;
+        }
+        legacy.seq = fetch->seq;
+        legacy.hosts.clear();
+        for (size_t i = 0; i < fetch->hosts.size(); ++i) {
+            if (!fetch->hosts[i].empty()) legacy.hosts.push_back(fetch->hosts[i]);
+        }
+        hosts = mergedHostsLocked(fetch->service, fetch->key);
+        seq = ++nextFetchSeq_;
+    }
+    updateHosts(fetch->service, fetch->key, hosts, seq);
+}
+
+// 调用方需持有 cache_mutex_。新布局展开的实例加上旧布局方法节点下的实例（重复的由 parseHosts 去掉）；
+// 旧布局下已经没有实例、且 service 有 instances 节点时，不再主动拉取该方法节点
+std::vector<std::string> ServiceDiscovery::mergedHostsLocked(const std::string& service, const std::string& key) {
+    std::vector<std::string> hosts;
+    auto it = instances_.find(service);
+    if (it != instances_.end()) {
+        hosts = methodHosts(it->second, key.substr(service.size() + 1));
+    }
+    auto legacy = legacyMethods_.find(key);
+    if (legacy != legacyMethods_.end()) {
+        if (legacy->second.hosts.empty() && legacy->second.seq != 0 && it != instances_.end()) {
+            legacyMethods_.erase(legacy);
+        } else {
+            hosts.insert(hosts.end(), legacy->second.hosts.begin(), legacy->second.hosts.end());
+        }
+    }
+    return hosts;
+}
 
-            std::lock_guard<std::mutex> lk(cache_mutex_);
-            cache_[service + "/" + method] = std::move(hosts);
-            deallocate_String_vector(&av);
+std::vector<std::string> ServiceDiscovery::methodHosts(const ServiceInstances& service, const std::string& method) {
+    std::vector<std::string> hosts;
+    for (size_t i = 0; i < service.instances.size(); ++i) {
+        const InstanceInfo& info = service.instances[i];
+        if (std::find(info.methods.begin(), info.methods.end(), method) != info.methods.end()) {
+            hosts.push_back(info.data);
         }
     }
+    return hosts;
+}
+
+// 在 ZooKeeper completion 线程上调用：解析、diff、重建负载均衡器和通知监听者都交给 watcher 线程，
+// 不阻塞其他请求的 completion
+void ServiceDiscovery::finishFetch(const std::shared_ptr<MethodFetch>& fetch) {
+    runInShard(fetch->key, [this, fetch]() {
+        if (fetch->failed) {
+            // 多半是连接断开，继续用旧列表，重新连上后再拉
+            std::lock_guard<std::mutex> lock(cache_mutex_);
+            unsynced_.insert(fetch->key);
+        } else if (fetch->instances) {
+            applyInstances(fetch);
+        } else {
+            applyMethodHosts(fetch);
+        }
+        if (fetch->done) {
+            fetch->done();
+        }
+    });
 }
 
 std::string ServiceDiscovery::QueryServiceHost(ZkClient* zkclient,
@@ -154,28 +647,526 @@ std::string ServiceDiscovery::QueryServiceHost(ZkClient* zkclient,
 
 
 std::string ServiceDiscovery::pickHost(const std::string& service, const std::string& method) {
-    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return pickHost(service, method, PickContext());
+}
+
+std::string ServiceDiscovery::pickHost(const std::string& service, const std::string& method,
+                                       const RpcController& controller) {
+    return pickHost(service, method,
+                    controller.HasHashKey() ? PickContext::withHash(controller.HashKey()) : PickContext());
+}
+
+std::string ServiceDiscovery::pickHost(const std::string& service, const std::string& method,
+                                       const PickContext& ctx) {
+    return pickEndpoint(resolve(service, method), ctx).hostPort;
+}
+
+ServiceKey ServiceDiscovery::resolve(const std::string& service, const std::string& method) {
     std::string key = service + "/" + method;
-    auto it = cache_.find(key);
-    if (it == cache_.end() || it->second.empty()) {
-        throw std::runtime_error("No hosts found for key: " + key);
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        id = keyIdLocked(key);
+        if (subscribed_.count(key)) {
+            return ServiceKey(id);
+        }
+    }
+    subscribe(std::vector<MethodName>(1, MethodName(service, method)));
+    return ServiceKey(id);
+}
+
+const ServiceDiscovery::SnapshotPtr& ServiceDiscovery::currentSnapshot() {
+    // 进程内只有一个 ServiceDiscovery 实例，线程本地缓存不需要区分实例
+    static thread_local uint64_t    cachedVersion = 0;
+    static thread_local SnapshotPtr cached;
+    uint64_t v = version_.load(std::memory_order_acquire);
+    if (v != cachedVersion) {
+        // 先读版本再读快照：读到的快照至少和 v 一样新，最坏只是下次多加载一次
+        cached = std::atomic_load(&snapshot_);
+        cachedVersion = v;
+    }
+    return cached;
+}
+
+const Endpoint& ServiceDiscovery::pickEndpoint(const ServiceKey& key, const PickContext& ctx) {
+    const Snapshot& snap = *currentSnapshot();
+    const ServiceEntry* entry = key.id_ < snap.entries.size() ? snap.entries[key.id_].get() : nullptr;
+    if (entry == nullptr || entry->endpoints.empty()) {
+        throw std::runtime_error("No hosts found for key: " + (entry ? entry->key : std::string("unknown")));
+    }
+    return pickFrom(*entry, ctx);
+}
+
+// entry 的实例列表不能为空
+const Endpoint& ServiceDiscovery::pickFrom(const ServiceEntry& entry, const PickContext& ctx) {
+    const EndpointList* endpoints = &entry.endpoints;
+    LoadBalancer* balancer = entry.balancer.get();
+    if (!entry.localEndpoints.empty() && !shouldSpill(entry.localEndpoints)) {
+        endpoints = &entry.localEndpoints;
+        balancer  = entry.localBalancer.get();
+    }
+    size_t idx = balancer->pick(*endpoints, ctx);
+    int64_t window = slowStartWindowUs_.load(std::memory_order_relaxed);
+    if (window > 0 && entry.newestSlowStartUs != 0 && !ctx.hasHashKey) {
+        idx = slowStartPick(*endpoints, balancer, ctx, idx, window);
+    }
+    if ((*endpoints)[idx].stats->ejected()) {
+        idx = outlierPick(*endpoints, balancer, ctx, idx);
+    }
+    return (*endpoints)[idx];
+}
+
+const Endpoint* ServiceDiscovery::pickEndpointExcept(const ServiceKey& key, const PickContext& ctx,
+                                                     const std::vector<std::string>& excluded) {
+    // 整个函数只用这一份快照：重选不能再走 pickEndpoint，否则快照更新时线程本地缓存被替换，
+    // entry 随旧快照一起释放。线程本地缓存也持有它，返回的指针在本线程下一次选取前有效
+    SnapshotPtr snap = currentSnapshot();
+    const ServiceEntry* entry = key.id_ < snap->entries.size() ? snap->entries[key.id_].get() : nullptr;
+    if (entry == nullptr || entry->endpoints.empty()) {
+        return nullptr;
+    }
+    auto isExcluded = [&excluded](const Endpoint& ep) {
+        return std::find(excluded.begin(), excluded.end(), ep.hostPort) != excluded.end();
+    };
+    for (int i = 0; i < kExceptMaxRepicks; ++i) {
+        const Endpoint& ep = pickFrom(*entry, ctx);
+        if (!isExcluded(ep)) {
+            return &ep;
+        }
+        if (ctx.hasHashKey) break;      // 带哈希 key 重选结果不变
+    }
+    // 在全部实例（不限本可用区）上顺序查找，优先未被摘除的
+    const Endpoint* fallback = nullptr;
+    size_t start = static_cast<size_t>(tls_rng()) % entry->endpoints.size();
+    for (size_t i = 0; i < entry->endpoints.size(); ++i) {
+        const Endpoint& ep = entry->endpoints[(start + i) % entry->endpoints.size()];
+        if (isExcluded(ep)) continue;
+        if (!ep.stats->ejected()) return &ep;
+        if (fallback == nullptr) fallback = &ep;
+    }
+    return fallback;
+}
+
+size_t ServiceDiscovery::outlierPick(const EndpointList& endpoints, LoadBalancer* balancer,
+                                     const PickContext& ctx, size_t idx) {
+    // 只在选中被摘除的实例时才走到这里，遍历整个列表的开销只落在少数调用上
+    if (outlier_.overEjectionLimit(endpoints)) {
+        return idx;
+    }
+    int64_t now = OutlierDetector::nowUs();
+    for (int i = 0; i < kOutlierMaxRepicks && !ctx.hasHashKey; ++i) {
+        if (outlier_.admit(endpoints[idx].stats.get(), now)) {
+            return idx;
+        }
+        idx = balancer->pick(endpoints, ctx);
+    }
+    // 重选仍落在被摘除的实例上（或带哈希 key，重选结果不变）：顺序找下一个可用的
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        size_t j = (idx + i) % endpoints.size();
+        if (outlier_.admit(endpoints[j].stats.get(), now)) {
+            return j;
+        }
     }
+    return idx;
+}
+
+void ServiceDiscovery::setOutlierDetection(const OutlierDetector::Options& options) {
+    outlier_.setOptions(options);
+    outlierCv_.notify_one();
+}
 
+void ServiceDiscovery::runOutlierSweeps() {
+    std::unique_lock<std::mutex> lk(outlierMutex_);
+    while (!outlierStop_) {
+        outlierCv_.wait_for(lk, std::chrono::microseconds(outlier_.intervalUs()));
+        if (outlierStop_) break;
+        lk.unlock();
+        SnapshotPtr snap = std::atomic_load(&snapshot_);
+        for (size_t i = 0; i < snap->entries.size(); ++i) {
+            if (snap->entries[i]) {
+                outlier_.sweep(snap->entries[i]->endpoints);
+            }
+        }
+        lk.lock();
+    }
+}
 
-    const auto& hosts = it->second;
+size_t ServiceDiscovery::slowStartPick(const EndpointList& endpoints, LoadBalancer* balancer,
+                                       const PickContext& ctx, size_t idx, int64_t windowUs) {
+    int64_t now = steadyNowUs();
+    // 拒绝采样：预热中的实例以 max(已过时间 / 窗口, 10%) 的概率被接受，相当于按这个比例缩小它的份额；
+    // 重选次数有限，全部被拒绝时使用最后一次的结果
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    for (int i = 0; i < kSlowStartMaxRepicks; ++i) {
+        const Endpoint& ep = endpoints[idx];
+        if (ep.slowStartUs == 0 || now - ep.slowStartUs >= windowUs) {
+            break;
+        }
+        double factor = std::max(static_cast<double>(now - ep.slowStartUs) / windowUs, kSlowStartMinFactor);
+        if (dist(tls_rng) < factor) {
+            break;
+        }
+        idx = balancer->pick(endpoints, ctx);
+    }
+    return idx;
+}
 
-    // 分布在 [0, hosts.size()-1]
-    std::uniform_int_distribution<std::size_t> dist(0, hosts.size() - 1);
-    // 随机选择一个实例,这种方法不太能在多线程真正随机
-//    std::srand(static_cast<unsigned>(std::time(nullptr)));
-//    int idx = std::rand() % hosts.size();
-    std::size_t idx = dist(tls_rng);
-    return hosts[idx];
+void ServiceDiscovery::setSlowStartWindow(double seconds) {
+    slowStartWindowUs_.store(seconds > 0 ? static_cast<int64_t>(seconds * 1000 * 1000) : 0,
+                             std::memory_order_relaxed);
+}
+
+bool ServiceDiscovery::shouldSpill(const EndpointList& local) const {
+    size_t healthy = 0;
+    double utilization = 0;
+    for (size_t i = 0; i < local.size(); ++i) {
+        const EndpointStats& stats = *local[i].stats;
+        if (!stats.healthy()) continue;
+        ++healthy;
+        if (local[i].maxConcurrency > 0) {
+            utilization += static_cast<double>(stats.load()) / local[i].maxConcurrency;
+        } else if (stats.hasServerLoad()) {
+            utilization += stats.serverCpuPermille() / 1000.0;
+        }
+    }
+    if (healthy == 0 || healthy < zoneMinHealthy_.load(std::memory_order_relaxed) * local.size()) {
+        return true;
+    }
+    return utilization / healthy > zoneMaxUtilization_.load(std::memory_order_relaxed);
+}
+
+bool ServiceDiscovery::setBalancer(const std::string& service, const std::string& policy) {
+    if (!LoadBalancer::create(policy)) {
+        LOG(ERROR) << "unknown load balancing policy: " << policy;
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    policies_[service] = policy;
+    rebuildEntriesLocked([&service](const ServiceEntry& entry) { return entry.service == service; });
+    return true;
+}
+
+bool ServiceDiscovery::setDefaultBalancer(const std::string& policy) {
+    if (!LoadBalancer::create(policy)) {
+        LOG(ERROR) << "unknown load balancing policy: " << policy;
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    defaultPolicy_ = policy;
+    rebuildEntriesLocked([this](const ServiceEntry& entry) {
+        return policies_.find(entry.service) == policies_.end();
+    });
+    return true;
+}
+
+void ServiceDiscovery::setLocalZone(const std::string& zone) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (zone == localZone_) return;
+    localZone_ = zone;
+    rebuildEntriesLocked([](const ServiceEntry&) { return true; });
+}
+
+void ServiceDiscovery::setZoneSpillover(double minHealthyFraction, double maxUtilization) {
+    zoneMinHealthy_.store(minHealthyFraction, std::memory_order_relaxed);
+    zoneMaxUtilization_.store(maxUtilization, std::memory_order_relaxed);
+}
+
+void ServiceDiscovery::rebuildEntriesLocked(const std::function<bool(const ServiceEntry&)>& match) {
+    // 已发布的 balancer 可能正被读端使用，为受影响的 entry 生成新 entry
+    std::vector<std::pair<uint32_t, ServiceEntryPtr>> changes;
+    const Snapshot& snap = *snapshot_;
+    for (size_t i = 0; i < snap.entries.size(); ++i) {
+        const ServiceEntryPtr& entry = snap.entries[i];
+        if (entry && match(*entry)) {
+            changes.push_back(std::make_pair(static_cast<uint32_t>(i),
+                                             makeEntryLocked(entry->key, entry->service, entry->endpoints)));
+        }
+    }
+    publishLocked(changes);
+}
+
+LoadBalancerPtr ServiceDiscovery::newBalancer(const std::string& service) {
+    auto it = policies_.find(service);
+    LoadBalancerPtr balancer = LoadBalancer::create(it != policies_.end() ? it->second : defaultPolicy_);
+    return balancer ? balancer : LoadBalancer::create("random");
+}
+
+EndpointStatsPtr ServiceDiscovery::endpointStats(const std::string& hostPort) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    EndpointStatsPtr& stats = stats_[hostPort];
+    if (!stats) {
+        stats = std::make_shared<EndpointStats>(hostPort);
+        stats->setDetector(&outlier_);
+    }
+    return stats;
+}
+
+EndpointList ServiceDiscovery::parseHosts(const std::string& key, const std::vector<std::string>& hosts) {
+    EndpointList endpoints;
+    endpoints.reserve(hosts.size());
+    std::unordered_set<std::string> seen;
+    for (size_t i = 0; i < hosts.size(); ++i) {
+        if (hosts[i].empty()) continue;
+        Endpoint ep;
+        if (!Endpoint::parse(hosts[i], &ep)) {
+            LOG(WARNING) << "ignoring malformed instance data under " << key << ": " << hosts[i];
+            continue;
+        }
+        if (!seen.insert(ep.hostPort).second) continue;
+        ep.stats = endpointStats(ep.hostPort);
+        endpoints.push_back(ep);
+    }
+    return endpoints;
+}
+
+void ServiceDiscovery::updateHosts(const std::string& service, const std::string& key,
+                                   const std::vector<std::string>& hosts, uint64_t seq) {
+    EndpointList endpoints = parseHosts(key, hosts);
+
+    MembershipChange change;
+    std::vector<MembershipListener> listeners;
+    {
+        std::lock_guard<std::mutex> lk(cache_mutex_);
+        // 同一个 key 的多次拉取可能交错完成，只接受比已应用的更新的结果
+        uint64_t& applied = appliedSeqs_[key];
+        if (seq <= applied) {
+            return;
+        }
+        applied = seq;
+        unsynced_.erase(key);
+        uint32_t id = keyIdLocked(key);
+        const ServiceEntry* prev = id < snapshot_->entries.size() ? snapshot_->entries[id].get() : nullptr;
+
+        change.key = key;
+        diffEndpoints(prev ? prev->endpoints : EndpointList(), endpoints, &change);
+        if (prev != nullptr && change.added.empty() && change.removed.empty() && change.updated.empty()) {
+            // 成员和属性都没变：不重建负载均衡器，也不发布新快照
+            return;
+        }
+        for (size_t i = 0; i < change.added.size(); ++i) {
+            ++endpointRefs_[change.added[i].hostPort];
+        }
+        for (size_t i = 0; i < change.removed.size(); ++i) {
+            auto it = endpointRefs_.find(change.removed[i].hostPort);
+            if (it != endpointRefs_.end() && --it->second <= 0) {
+                endpointRefs_.erase(it);
+                change.gone.push_back(change.removed[i].hostPort);
+            }
+        }
+        std::vector<std::pair<uint32_t, ServiceEntryPtr>> changes;
+        changes.push_back(std::make_pair(id, makeEntryLocked(key, service, endpoints)));
+        publishLocked(changes);
+        for (auto it = listeners_.begin(); it != listeners_.end(); ++it) {
+            listeners.push_back(it->second);
+        }
+    }
+    if (!change.added.empty() || !change.removed.empty() || !change.updated.empty()) {
+        LOG(INFO) << key << ": +" << change.added.size() << " -" << change.removed.size()
+                  << " ~" << change.updated.size() << " endpoints";
+    }
+    // 锁外通知，监听者可以回调 ServiceDiscovery 的其他接口
+    tls_notifying = true;
+    for (size_t i = 0; i < listeners.size(); ++i) {
+        listeners[i](change);
+    }
+    tls_notifying = false;
+    persistSnapshot();
+}
+
+void ServiceDiscovery::setSnapshotPath(const std::string& path) {
+    snapshotPath_ = path;
+}
+
+void ServiceDiscovery::setConnectTimeout(double seconds) {
+    connectTimeout_ = seconds;
+}
+
+size_t ServiceDiscovery::loadSnapshot() {
+    std::vector<DiscoverySnapshot::Entry> saved;
+    if (snapshotPath_.empty() || !DiscoverySnapshot::load(snapshotPath_, &saved)) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    std::vector<std::pair<uint32_t, ServiceEntryPtr>> changes;
+    for (size_t i = 0; i < saved.size(); ++i) {
+        const std::string& key = saved[i].key;
+        size_t slash = key.find('/');
+        if (slash == std::string::npos || subscribed_.count(key)) continue;
+        EndpointList endpoints = parseHosts(key, saved[i].hosts);
+        for (size_t j = 0; j < endpoints.size(); ++j) {
+            ++endpointRefs_[endpoints[j].hostPort];
+        }
+        changes.push_back(std::make_pair(keyIdLocked(key), makeEntryLocked(key, key.substr(0, slash), endpoints)));
+        // 视为已订阅，resolve 不再同步拉取；ZooKeeper 连上后刷新
+        subscribed_.insert(key);
+        watched_.insert(key);
+        unsynced_.insert(key);
+    }
+    publishLocked(changes);
+    LOG(INFO) << "loaded " << changes.size() << " methods from discovery snapshot " << snapshotPath_;
+    return changes.size();
+}
+
+// 在 watcher 线程上调用。多个线程同时更新时串行写文件，后写的发现版本已经写过就直接返回
+void ServiceDiscovery::persistSnapshot() {
+    if (snapshotPath_.empty()) return;
+    std::lock_guard<std::mutex> lock(persist_mutex_);
+    // 先读版本再读快照：写入的内容至少和该版本一样新
+    uint64_t v = version_.load(std::memory_order_acquire);
+    if (v == persistedVersion_) return;
+    SnapshotPtr snap = std::atomic_load(&snapshot_);
+    std::vector<DiscoverySnapshot::Entry> saved;
+    saved.reserve(snap->entries.size());
+    for (size_t i = 0; i < snap->entries.size(); ++i) {
+        const ServiceEntryPtr& entry = snap->entries[i];
+        if (!entry) continue;
+        DiscoverySnapshot::Entry e;
+        e.key = entry->key;
+        e.hosts.reserve(entry->endpoints.size());
+        for (size_t j = 0; j < entry->endpoints.size(); ++j) {
+            e.hosts.push_back(entry->endpoints[j].data);
+        }
+        saved.push_back(std::move(e));
+    }
+    if (DiscoverySnapshot::save(snapshotPath_, saved)) {
+        persistedVersion_ = v;
+    }
+}
+
+// 在 ZooKeeper 的 watcher 线程上调用，只把刷新交给各方法所属的 watcher 线程
+void ServiceDiscovery::onZkConnected() {
+    std::set<std::string> paths;
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        count = unsynced_.size();
+        for (auto it = unsynced_.begin(); it != unsynced_.end(); ++it) {
+            const std::string& key = *it;
+            size_t slash = key.find('/');
+            if (slash == std::string::npos) continue;
+            std::string service = key.substr(0, slash);
+            if (key.compare(slash + 1, std::string::npos, kInstancesNode) == 0) {
+                paths.insert("/" + key);
+                continue;
+            }
+            // 方法级的 key（如来自本地快照）：两种布局都可能有实例，分别刷新
+            if (legacyMethods_.count(key) || !instances_.count(service)) {
+                paths.insert("/" + key);
+            }
+            if (!legacyServices_.count(service)) {
+                paths.insert("/" + service + "/" + kInstancesNode);
+            }
+        }
+    }
+    if (count > 0) {
+        LOG(INFO) << "zookeeper connected, refreshing " << count << " unsynced methods";
+    }
+    for (auto it = paths.begin(); it != paths.end(); ++it) {
+        enqueueEvent(*it, ZOO_SESSION_EVENT);
+    }
+}
+
+// 按 hostPort 比较新旧列表；新旧都有且属性不变的实例沿用旧对象
+void ServiceDiscovery::diffEndpoints(const EndpointList& before, EndpointList& after, MembershipChange* change) {
+    std::unordered_map<std::string, const Endpoint*> old;
+    for (size_t i = 0; i < before.size(); ++i) {
+        old[before[i].hostPort] = &before[i];
+    }
+    // 首次拉到的实例没有可比较的对象，不做慢启动；之后新出现的、或启动时间变了（重启过）的实例从现在开始预热
+    int64_t now = before.empty() ? 0 : steadyNowUs();
+    for (size_t i = 0; i < after.size(); ++i) {
+        auto it = old.find(after[i].hostPort);
+        if (it == old.end()) {
+            after[i].slowStartUs = now;
+            change->added.push_back(after[i]);
+            continue;
+        }
+        const Endpoint& prev = *it->second;
+        if (!prev.sameAttributes(after[i])) {
+            after[i].slowStartUs = prev.startTimeMs != after[i].startTimeMs ? now : prev.slowStartUs;
+            change->updated.push_back(after[i]);
+        } else {
+            after[i] = prev;
+        }
+        old.erase(it);
+    }
+    for (size_t i = 0; i < before.size(); ++i) {
+        if (old.count(before[i].hostPort)) {
+            change->removed.push_back(before[i]);
+        }
+    }
+}
+
+int ServiceDiscovery::addMembershipListener(MembershipListener listener) {
+    std::lock_guard<std::mutex> lk(cache_mutex_);
+    int id = ++nextListenerId_;
+    listeners_[id] = std::move(listener);
+    return id;
+}
+
+void ServiceDiscovery::removeMembershipListener(int id) {
+    std::lock_guard<std::mutex> lk(cache_mutex_);
+    listeners_.erase(id);
+}
+
+uint32_t ServiceDiscovery::keyIdLocked(const std::string& key) {
+    auto it = keyIds_.find(key);
+    if (it != keyIds_.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(keyIds_.size());
+    keyIds_[key] = id;
+    return id;
+}
+
+ServiceDiscovery::ServiceEntryPtr ServiceDiscovery::makeEntryLocked(const std::string& key,
+                                                                    const std::string& service,
+                                                                    const EndpointList& endpoints) {
+    std::shared_ptr<ServiceEntry> entry = std::make_shared<ServiceEntry>();
+    entry->key       = key;
+    entry->service   = service;
+    entry->endpoints = endpoints;
+    entry->balancer  = newBalancer(service);
+    entry->balancer->rebuild(entry->endpoints);
+    entry->newestSlowStartUs = 0;
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        entry->newestSlowStartUs = std::max(entry->newestSlowStartUs, endpoints[i].slowStartUs);
+    }
+    if (!localZone_.empty()) {
+        for (size_t i = 0; i < endpoints.size(); ++i) {
+            if (endpoints[i].zone == localZone_) {
+                entry->localEndpoints.push_back(endpoints[i]);
+            }
+        }
+        // 全部在本地时与整体列表相同，不需要第二个 balancer
+        if (entry->localEndpoints.size() == endpoints.size()) {
+            entry->localEndpoints.clear();
+        } else if (!entry->localEndpoints.empty()) {
+            entry->localBalancer = newBalancer(service);
+            entry->localBalancer->rebuild(entry->localEndpoints);
+        }
+    }
+    return entry;
+}
+
+void ServiceDiscovery::publishLocked(const std::vector<std::pair<uint32_t, ServiceEntryPtr>>& changes) {
+    if (changes.empty()) return;
+    // 只复制 entry 指针，未变化的 entry 与旧快照共享
+    std::shared_ptr<Snapshot> next = std::make_shared<Snapshot>(*snapshot_);
+    if (next->entries.size() < keyIds_.size()) {
+        next->entries.resize(keyIds_.size());
+    }
+    for (size_t i = 0; i < changes.size(); ++i) {
+        next->entries[changes[i].first] = changes[i].second;
+    }
+    std::atomic_store(&snapshot_, SnapshotPtr(next));
+    version_.fetch_add(1, std::memory_order_release);
 }
 
 
 void ServiceDiscovery::zkWatcher(zhandle_t* zh, int type,int state,const char* path, void* ctx) {
-    if (type == ZOO_CHILD_EVENT || type == ZOO_CHANGED_EVENT) {
+    if (type == ZOO_CHILD_EVENT || type == ZOO_CHANGED_EVENT ||
+        type == ZOO_CREATED_EVENT || type == ZOO_DELETED_EVENT) {
         LOG(INFO)<<"some server service/method is up/down";
         auto* self = static_cast<ServiceDiscovery*>(ctx);
 //        self->handleEvent(path, type);
@@ -184,70 +1175,178 @@ void ServiceDiscovery::zkWatcher(zhandle_t* zh, int type,int state,const char* p
 }
 
 
-void ServiceDiscovery::handleEvent(const std::string& path, int type) {
-    // path 类似 "/UserService/Login" 或 "/UserService/Login/instance123"
-    // 解析出 service/method
-    LOG(INFO)<<"handling event:"<<path<<"\ttype:"<<type;
+// 合并窗口到期后刷新：新布局重新拉取整个 service 的 instances，旧布局重新拉取方法节点，
+// 完成时记录从第一个事件到发布的延迟
+void ServiceDiscovery::handleEvent(const PendingRefresh& refresh) {
+    std::string key = refresh.service + "/" + refresh.method;
+    bool instances = (refresh.method == kInstancesNode);
+    if (!instances) {
+        std::lock_guard<std::mutex> lk(cache_mutex_);
+        if (!watched_.count(key)) return;
+    }
+    LOG(INFO) << "refreshing " << key << " after " << refresh.events << " watch events";
+    refreshCount_.fetch_add(1, std::memory_order_relaxed);
+    int64_t firstEventUs = refresh.firstEventUs;
+    std::function<void()> done = [this, firstEventUs]() {
+        int64_t lag = steadyNowUs() - firstEventUs;
+        lastLagUs_.store(lag, std::memory_order_relaxed);
+        int64_t max = maxLagUs_.load(std::memory_order_relaxed);
+        while (lag > max && !maxLagUs_.compare_exchange_weak(max, lag, std::memory_order_relaxed)) {
+        }
+    };
+    if (instances) {
+        fetchServiceAsync(refresh.service, done);
+    } else {
+        fetchMethodAsync(refresh.service, refresh.method, done);
+    }
+}
+
+void ServiceDiscovery::enqueueEvent(const std::string& path, int type) {
+    // path 类似 "/UserService/instances/10.0.0.5:8000"，旧布局下是 "/UserService/Login" 或 "/UserService/Login/instance123"
+    // 无论哪一级变化都归到所属的 service/instances（旧布局为 service/method）上，两种布局各自刷新
     auto parts = split(path, '/');  // 自行实现 split
     if (parts.size() < 2) {
-        LOG(INFO)<<"DEBUG: handleEvent():"<<parts[0]<<'\t'<<parts[1]<<"\tparts size samller than 2";
+        LOG(INFO) << "ignoring watch event on " << path << " type:" << type;
         return;
     }
-    std::string service = parts[0];
-    std::string method  = parts[1];
-    std::string key     = service + "/" + method;
-
-    // 重新拉一次子节点和数据（同 init 逻辑），更新 cache_
-    std::vector<std::string> newHosts;
-    struct String_vector av;
-    zkClient_.GetChildrenW(path.c_str(), zkWatcher, this, &av);
-    LOG(INFO)<<"DEBUG: handleEvent()";
-    if (av.count == 0) {
-        char buf[128]; int len = sizeof(buf);
-        zkClient_.GetDataW(path.c_str(), zkWatcher, this, buf, &len);
-        newHosts.emplace_back(buf, len);
-    } else {
-        for (int i = 0; i < av.count; ++i) {
-            std::string instPath = path + "/" + av.data[i];
-            char buf[128]; int len = sizeof(buf);
-            zkClient_.GetDataW(instPath.c_str(), zkWatcher, this, buf, &len);
-            newHosts.emplace_back(buf, len);
+    eventCount_.fetch_add(1, std::memory_order_relaxed);
+    std::string method = parts[1];
+    std::string key = parts[0] + "/" + method;
+    WatchShard* shard = shardFor(key);
+    if (shard == nullptr) return;
+    int64_t now = steadyNowUs();
+    {
+        std::lock_guard<std::mutex> lk(shard->mutex);
+        auto it = shard->pending.find(key);
+        if (it != shard->pending.end()) {
+            // 窗口内已有待刷新的同一方法，合并
+            ++it->second.events;
+            coalescedCount_.fetch_add(1, std::memory_order_relaxed);
+            return;
         }
+        PendingRefresh& refresh = shard->pending[key];
+        refresh.service      = parts[0];
+        refresh.method       = method;
+        refresh.firstEventUs = now;
+        refresh.dueUs        = now + debounceUs_.load(std::memory_order_relaxed);
+        refresh.events       = 1;
+        shard->dueOrder.push(key);
     }
+    shard->cv.notify_one();
+}
 
-    deallocate_String_vector(&av);
-    {
-        std::lock_guard<std::mutex> lk(cache_mutex_);
-        cache_[key] = std::move(newHosts);
+void ServiceDiscovery::processEvents(WatchShard* shard) {
+    while (true) {
+        PendingRefresh refresh;
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lk(shard->mutex);
+            shard->cv.wait(lk, [&]{ return shard->stop || !shard->tasks.empty() || !shard->dueOrder.empty(); });
+            if (shard->stop) return;
+            if (!shard->tasks.empty()) {
+                task = std::move(shard->tasks.front());
+                shard->tasks.pop();
+            } else {
+                // 窗口固定，入队顺序就是到期顺序，只需等队首到期
+                auto it = shard->pending.find(shard->dueOrder.front());
+                int64_t wait = it->second.dueUs - steadyNowUs();
+                if (wait > 0) {
+                    shard->cv.wait_for(lk, std::chrono::microseconds(wait));
+                    continue;
+                }
+                refresh = it->second;
+                shard->pending.erase(it);
+                shard->dueOrder.pop();
+            }
+        }
+        if (task) {
+            task();
+        } else {
+            handleEvent(refresh);
+        }
     }
 }
 
+void ServiceDiscovery::setWatchWorkers(int n) {
+    if (workersStarted_.load()) {
+        LOG(WARNING) << "setWatchWorkers must be called before init, ignored";
+        return;
+    }
+    workerCount_ = n;
+}
 
-
-void ServiceDiscovery::enqueueEvent(const std::string& path, int type) {
-    {
-        std::lock_guard<std::mutex> lk(queueMtx_);
-        events_.push(ZkEvent{path, type});
+void ServiceDiscovery::startWorkers() {
+    if (workersStarted_.load()) return;
+    int n = workerCount_;
+    if (n <= 0) {
+        n = std::min(4, static_cast<int>(std::thread::hardware_concurrency()));
+        if (n <= 0) n = 1;
+    }
+    for (int i = 0; i < n; ++i) {
+        shards_.push_back(std::unique_ptr<WatchShard>(new WatchShard));
+    }
+    for (int i = 0; i < n; ++i) {
+        WatchShard* shard = shards_[i].get();
+        shard->thread = std::thread(&ServiceDiscovery::processEvents, this, shard);
     }
-    queueCv_.notify_one();
+    outlierThread_ = std::thread(&ServiceDiscovery::runOutlierSweeps, this);
+    workersStarted_.store(true);
 }
 
-void ServiceDiscovery::processEvents() {
-    while (true) {
-        ZkEvent ev;
+// 先清掉 workersStarted_：之后迟到的事件直接丢弃、任务在调用线程上执行，不再投递给正在退出的线程
+void ServiceDiscovery::stopWorkers() {
+    if (!workersStarted_.exchange(false)) return;
+    for (size_t i = 0; i < shards_.size(); ++i) {
         {
-            std::unique_lock<std::mutex> lk(queueMtx_);
-            queueCv_.wait(lk, [&]{ return stop_ || !events_.empty(); });
-            if (stop_ && events_.empty()) return;
-            ev = std::move(events_.front());
-            events_.pop();
+            std::lock_guard<std::mutex> lk(shards_[i]->mutex);
+            shards_[i]->stop = true;
         }
-        LOG(INFO)<<"Debug: processEvents()";
-        // 真正去做同步 ZK 调用和 cache 更新
-        handleEvent(ev.path, ev.type);
+        shards_[i]->cv.notify_one();
+    }
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        shards_[i]->thread.join();
     }
+    {
+        std::lock_guard<std::mutex> lk(outlierMutex_);
+        outlierStop_ = true;
+    }
+    outlierCv_.notify_one();
+    outlierThread_.join();
 }
 
+ServiceDiscovery::WatchShard* ServiceDiscovery::shardFor(const std::string& key) {
+    if (!workersStarted_.load(std::memory_order_acquire)) return nullptr;
+    return shards_[LoadBalancer::hash(key) % shards_.size()].get();
+}
 
+void ServiceDiscovery::runInShard(const std::string& key, std::function<void()> task) {
+    WatchShard* shard = shardFor(key);
+    if (shard == nullptr) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(shard->mutex);
+        shard->tasks.push(std::move(task));
+    }
+    shard->cv.notify_one();
+}
 
+void ServiceDiscovery::setWatchDebounce(double seconds) {
+    debounceUs_.store(seconds > 0 ? static_cast<int64_t>(seconds * 1000 * 1000) : 0);
+}
+
+ServiceDiscovery::WatchStats ServiceDiscovery::watchStats() const {
+    WatchStats stats;
+    stats.events    = eventCount_.load(std::memory_order_relaxed);
+    stats.coalesced = coalescedCount_.load(std::memory_order_relaxed);
+    stats.refreshes = refreshCount_.load(std::memory_order_relaxed);
+    stats.lastLagUs = lastLagUs_.load(std::memory_order_relaxed);
+    stats.maxLagUs  = maxLagUs_.load(std::memory_order_relaxed);
+    return stats;
+}
 
+int64_t ServiceDiscovery::steadyNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
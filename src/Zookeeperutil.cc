@@ -2,24 +2,162 @@
 #include <mutex>
 #include "Logger.h"
 #include <condition_variable>
+#include <memory>
+#include <chrono>
+#include <atomic>
 
-std::mutex cv_mutex;        // 全局锁，用于保护共享变量的线程安全
-std::condition_variable cv; // 条件变量，用于线程间通信
-bool is_connected = false;  // 标记ZooKeeper客户端是否连接成功
+namespace {
+// 异步请求的上下文，作为 completion 的 data 传给 C API，在 completion 中释放
+struct ChildrenCall { ZkClient::ChildrenCallback cb; };
+struct DataCall { ZkClient::DataCallback cb; };
+struct ExistsCall { ZkClient::ExistsCallback cb; };
 
-// 全局的watcher观察器，用于接收ZooKeeper服务器的通知
-void global_watcher(zhandle_t *zh, int type, int status, const char *path, void *watcherCtx) {
-    if (type == ZOO_SESSION_EVENT) {  // 回调消息类型和会话相关的事件
-        if (status == ZOO_CONNECTED_STATE) {  // ZooKeeper客户端和服务器连接成功
-            std::lock_guard<std::mutex> lock(cv_mutex);  // 加锁保护
-            is_connected = true;  // 标记连接成功
+void childrenCompletion(int rc, const struct String_vector* strings, const struct Stat*, const void* data) {
+    std::unique_ptr<ChildrenCall> call(static_cast<ChildrenCall*>(const_cast<void*>(data)));
+    std::vector<std::string> children;
+    if (rc == ZOK && strings != nullptr) {
+        children.reserve(strings->count);
+        for (int i = 0; i < strings->count; ++i) {
+            children.emplace_back(strings->data[i]);
         }
     }
-    cv.notify_all();  // 通知所有等待的线程
+    call->cb(rc, children);
+}
+
+void dataCompletion(int rc, const char* value, int value_len, const struct Stat*, const void* data) {
+    std::unique_ptr<DataCall> call(static_cast<DataCall*>(const_cast<void*>(data)));
+    std::string result;
+    if (rc == ZOK && value != nullptr && value_len > 0) {
+        result.assign(value, value_len);
+    }
+    call->cb(rc, result);
+}
+
+void existsCompletion(int rc, const struct Stat*, const void* data) {
+    std::unique_ptr<ExistsCall> call(static_cast<ExistsCall*>(const_cast<void*>(data)));
+    call->cb(rc);
+}
+
+// 一次批量注册：先并发创建持久节点、检查临时节点是否遗留，全部返回后提交 zoo_multi
+struct CreateBatch {
+    CreateBatch() : remaining(0), error(ZOK) {}
+    zhandle_t*                      zh;
+    std::vector<ZkClient::Node>     nodes;
+    std::vector<char>               stale;      // 临时节点已存在（上一个会话遗留），按下标并发写入
+    std::atomic<size_t>             remaining;
+    std::atomic<int>                error;      // 第一个错误码
+    ZkClient::BatchCallback         cb;
+    // zoo_amulti 的参数在 completion 之前必须保持有效
+    std::vector<zoo_op_t>           ops;
+    std::vector<zoo_op_result_t>    results;
+    std::vector<std::vector<char>>  pathBufs;
+};
+typedef std::shared_ptr<CreateBatch> CreateBatchPtr;
+struct BatchStep {
+    CreateBatchPtr batch;
+    size_t         index;
+};
+
+void recordError(const CreateBatchPtr& batch, int rc) {
+    int expected = ZOK;
+    batch->error.compare_exchange_strong(expected, rc);
+}
+
+void multiCompletion(int rc, const void* data) {
+    std::unique_ptr<CreateBatchPtr> holder(static_cast<CreateBatchPtr*>(const_cast<void*>(data)));
+    const CreateBatchPtr& batch = *holder;
+    if (rc != ZOK) {
+        // 事务整体回滚，第一个真正失败的操作之后的结果都是 ZRUNTIMEINCONSISTENCY
+        for (size_t i = 0; i < batch->results.size(); ++i) {
+            int err = batch->results[i].err;
+            if (err != ZOK && err != ZRUNTIMEINCONSISTENCY) {
+                LOG(ERROR) << "zoo_multi op " << i << " failed: " << zerror(err);
+                break;
+            }
+        }
+    }
+    batch->cb(rc);
+}
+
+void submitMulti(const CreateBatchPtr& batch) {
+    if (batch->error.load() != ZOK) {
+        batch->cb(batch->error.load());
+        return;
+    }
+    for (size_t i = 0; i < batch->nodes.size(); ++i) {
+        const ZkClient::Node& node = batch->nodes[i];
+        if (node.flags == 0) continue;
+        if (batch->stale[i]) {
+            zoo_op_t del;
+            zoo_delete_op_init(&del, node.path.c_str(), -1);
+            batch->ops.push_back(del);
+        }
+        batch->pathBufs.push_back(std::vector<char>(node.path.size() + 16));
+        std::vector<char>& buf = batch->pathBufs.back();
+        zoo_op_t create;
+        zoo_create_op_init(&create, node.path.c_str(), node.data.data(), static_cast<int>(node.data.size()),
+                           &ZOO_OPEN_ACL_UNSAFE, node.flags, buf.data(), static_cast<int>(buf.size()));
+        batch->ops.push_back(create);
+    }
+    if (batch->ops.empty()) {
+        batch->cb(ZOK);
+        return;
+    }
+    batch->results.resize(batch->ops.size());
+    CreateBatchPtr* holder = new CreateBatchPtr(batch);
+    int rc = zoo_amulti(batch->zh, static_cast<int>(batch->ops.size()), batch->ops.data(),
+                        batch->results.data(), multiCompletion, holder);
+    if (rc != ZOK) {
+        delete holder;
+        batch->cb(rc);
+    }
+}
+
+void stepDone(const CreateBatchPtr& batch) {
+    if (batch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        submitMulti(batch);
+    }
+}
+
+void persistentCompletion(int rc, const char*, const void* data) {
+    std::unique_ptr<BatchStep> step(static_cast<BatchStep*>(const_cast<void*>(data)));
+    if (rc != ZOK && rc != ZNODEEXISTS) {
+        LOG(ERROR) << "create " << step->batch->nodes[step->index].path << " failed: " << zerror(rc);
+        recordError(step->batch, rc);
+    }
+    stepDone(step->batch);
+}
+
+void staleCompletion(int rc, const struct Stat*, const void* data) {
+    std::unique_ptr<BatchStep> step(static_cast<BatchStep*>(const_cast<void*>(data)));
+    if (rc == ZOK) {
+        step->batch->stale[step->index] = 1;
+    } else if (rc != ZNONODE) {
+        recordError(step->batch, rc);
+    }
+    stepDone(step->batch);
+}
+} // namespace
+
+// 全局的watcher观察器，用于接收ZooKeeper服务器的通知，watcherCtx 是 zookeeper_init 时传入的 ZkClient
+void global_watcher(zhandle_t *zh, int type, int status, const char *path, void *watcherCtx) {
+    ZkClient* client = static_cast<ZkClient*>(watcherCtx);
+    if (client == nullptr || type != ZOO_SESSION_EVENT) {  // 只关心会话相关的事件
+        return;
+    }
+    bool connected = (status == ZOO_CONNECTED_STATE);  // ZooKeeper客户端和服务器连接成功
+    {
+        std::lock_guard<std::mutex> lock(client->m_mutex);  // 加锁保护
+        client->m_connected = connected;
+    }
+    client->m_cv.notify_all();  // 通知所有等待的线程
+    if (connected && client->m_connectedCb) {
+        client->m_connectedCb();
+    }
 }
 
 // 构造函数，初始化ZooKeeper客户端句柄为空
-ZkClient::ZkClient() : m_zhandle(nullptr) {}
+ZkClient::ZkClient() : m_zhandle(nullptr), m_connected(false) {}
 
 // 析构函数，关闭ZooKeeper连接
 ZkClient::~ZkClient() {
@@ -28,8 +166,17 @@ ZkClient::~ZkClient() {
     }
 }
 
-// 启动ZooKeeper客户端，连接ZooKeeper服务器
-void ZkClient::Start(const std::string& host, const std::string& port) {
+// 启动ZooKeeper客户端，连接ZooKeeper服务器并等待连接成功
+bool ZkClient::Start(const std::string& host, const std::string& port) {
+    if (!Connect(host, port)) {
+        return false;
+    }
+    WaitConnected(0);
+    LOG(INFO) << "zookeeper_init success";  // 记录日志，表示连接成功
+    return true;
+}
+
+bool ZkClient::Connect(const std::string& host, const std::string& port) {
     // 从配置文件中读取ZooKeeper服务器的IP和端口
 //    std::string host = KrpcApplication::GetInstance().GetConfig().Load("zookeeperip");
 //    std::string port = KrpcApplication::GetInstance().GetConfig().Load("zookeeperport");
@@ -50,20 +197,30 @@ void ZkClient::Start(const std::string& host, const std::string& port) {
     zoo_set_debug_level(ZOO_LOG_LEVEL_ERROR);
 
     // 使用zookeeper_init初始化一个ZooKeeper客户端对象，异步建立与服务器的连接
-    m_zhandle = zookeeper_init(connstr.c_str(), global_watcher, 6000, nullptr, nullptr, 0);
+    m_zhandle = zookeeper_init(connstr.c_str(), global_watcher, 6000, nullptr, this, 0);
     if (nullptr == m_zhandle) {  // 初始化失败
         LOG(ERROR) << "zookeeper_init error";
-        exit(EXIT_FAILURE);  // 退出程序
+        return false;
     }
+    return true;
+}
 
-    // 等待连接成功
-    std::unique_lock<std::mutex> lock(cv_mutex);
-    cv.wait(lock, [] { return is_connected; });  // 阻塞等待，直到连接成功
-    LOG(INFO) << "zookeeper_init success";  // 记录日志，表示连接成功
+bool ZkClient::WaitConnected(double seconds) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (seconds <= 0) {
+        m_cv.wait(lock, [this] { return m_connected; });  // 阻塞等待，直到连接成功
+        return true;
+    }
+    return m_cv.wait_for(lock, std::chrono::duration<double>(seconds), [this] { return m_connected; });
+}
+
+bool ZkClient::IsConnected() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_connected;
 }
 
 // 创建ZooKeeper节点
-void ZkClient::Create(const char *path, const char *data, int datalen, int state) {
+bool ZkClient::Create(const char *path, const char *data, int datalen, int state) {
     char path_buffer[128];  // 用于存储创建的节点路径
     int bufferlen = sizeof(path_buffer);
 
@@ -74,11 +231,12 @@ void ZkClient::Create(const char *path, const char *data, int datalen, int state
         flag = zoo_create(m_zhandle, path, data, datalen, &ZOO_OPEN_ACL_UNSAFE, state, path_buffer, bufferlen);
         if (flag == ZOK) {  // 创建成功
             LOG(INFO) << "znode create success... path:" << path;
-        } else {  // 创建失败
-            LOG(ERROR) << "znode create failed... path:" << path;
-            exit(EXIT_FAILURE);  // 退出程序
+        } else {  // 创建失败，由调用方决定如何处理
+            LOG(ERROR) << "znode create failed... path:" << path << " " << zerror(flag);
+            return false;
         }
     }
+    return flag == ZOK;
 }
 
 // 获取ZooKeeper节点的数据
@@ -128,8 +286,100 @@ int ZkClient::GetDataW(const char* path,
     // ZOO_CHANGED_EVENT 会触发 watcher
     return zoo_wget(m_zhandle, path, watcher, watcherCtx, buffer, bufferlen, nullptr);
 }
+int ZkClient::ExistsW(const char* path,
+                      watcher_fn watcher,
+                      void* watcherCtx) {
+    // ZOO_CREATED_EVENT / ZOO_DELETED_EVENT 会触发 watcher
+    return zoo_wexists(m_zhandle, path, watcher, watcherCtx, nullptr);
+}
+
+void ZkClient::AsyncGetChildrenW(const char* path, watcher_fn watcher, void* watcherCtx, ChildrenCallback cb) {
+    ChildrenCall* call = new ChildrenCall{std::move(cb)};
+    int rc = zoo_awget_children2(m_zhandle, path, watcher, watcherCtx, childrenCompletion, call);
+    if (rc != ZOK) {
+        std::unique_ptr<ChildrenCall> guard(call);
+        guard->cb(rc, std::vector<std::string>());
+    }
+}
 
+void ZkClient::AsyncGetDataW(const char* path, watcher_fn watcher, void* watcherCtx, DataCallback cb) {
+    DataCall* call = new DataCall{std::move(cb)};
+    int rc = zoo_awget(m_zhandle, path, watcher, watcherCtx, dataCompletion, call);
+    if (rc != ZOK) {
+        std::unique_ptr<DataCall> guard(call);
+        guard->cb(rc, std::string());
+    }
+}
 
+void ZkClient::AsyncExistsW(const char* path, watcher_fn watcher, void* watcherCtx, ExistsCallback cb) {
+    ExistsCall* call = new ExistsCall{std::move(cb)};
+    int rc = zoo_awexists(m_zhandle, path, watcher, watcherCtx, existsCompletion, call);
+    if (rc != ZOK) {
+        std::unique_ptr<ExistsCall> guard(call);
+        guard->cb(rc);
+    }
+}
+
+
+void ZkClient::CreateBatchAsync(const std::vector<Node>& nodes, BatchCallback cb) {
+    CreateBatchPtr batch = std::make_shared<CreateBatch>();
+    batch->zh    = m_zhandle;
+    batch->nodes = nodes;
+    batch->stale.assign(nodes.size(), 0);
+    batch->cb    = std::move(cb);
+    // 多占一个计数，全部发送完再释放，避免发送途中就提交 multi
+    batch->remaining.store(nodes.size() + 1);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        BatchStep* step = new BatchStep{batch, i};
+        const Node& node = batch->nodes[i];
+        int rc;
+        if (node.flags == 0) {
+            rc = zoo_acreate(m_zhandle, node.path.c_str(), node.data.data(), static_cast<int>(node.data.size()),
+                             &ZOO_OPEN_ACL_UNSAFE, 0, persistentCompletion, step);
+        } else {
+            rc = zoo_awexists(m_zhandle, node.path.c_str(), nullptr, nullptr, staleCompletion, step);
+        }
+        if (rc != ZOK) {
+            delete step;
+            recordError(batch, rc);
+            stepDone(batch);
+        }
+    }
+    stepDone(batch);
+}
+
+int ZkClient::DeleteBatch(const std::vector<std::string>& paths) {
+    if (m_zhandle == nullptr) {
+        return ZINVALIDSTATE;
+    }
+    std::vector<std::string> todo(paths);
+    while (!todo.empty()) {
+        std::vector<zoo_op_t> ops(todo.size());
+        std::vector<zoo_op_result_t> results(todo.size());
+        for (size_t i = 0; i < todo.size(); ++i) {
+            zoo_delete_op_init(&ops[i], todo[i].c_str(), -1);
+        }
+        int rc = zoo_multi(m_zhandle, static_cast<int>(ops.size()), ops.data(), results.data());
+        if (rc == ZOK) {
+            LOG(INFO) << "deleted " << todo.size() << " znodes";
+            return ZOK;
+        }
+        // 事务整体回滚：去掉已经不存在的节点后重试，其他错误直接返回
+        size_t missing = todo.size();
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (results[i].err == ZNONODE) {
+                missing = i;
+                break;
+            }
+        }
+        if (rc != ZNONODE || missing == todo.size()) {
+            LOG(ERROR) << "zoo_multi delete failed: " << zerror(rc);
+            return rc;
+        }
+        todo.erase(todo.begin() + missing);
+    }
+    return ZOK;
+}
 
 // === Modifications in zookeeperutil.cpp ===
 void ZkClient::Delete(const char* path) {
@@ -0,0 +1,87 @@
+// ChannelPool.h
+#ifndef _CHANNELPOOL_H_
+#define _CHANNELPOOL_H_
+
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/TimerId.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ClientChannel.h"
+#include "Endpoint.h"
+
+// 按 ip:port 共享的连接池：同一进程内所有 Stub / 服务访问同一 endpoint 时复用同一组多路复用连接，
+// 而不是每个 Stub 各自一条 TcpClient。连接在第一次 getChannel 时懒创建（建立前的调用先排队），
+// 长时间没有外部引用的 endpoint 会被定时回收。连接都挂在 ClientRuntime 的 IO 线程上；
+// 构造时先初始化 ClientRuntime，保证进程退出时本对象先析构，析构时 IO 线程仍在运行。
+class ChannelPool {
+public:
+    static ChannelPool& instance();
+
+    // 每个 endpoint 的连接数，>1 时按轮询分摊调用，提高单 endpoint 吞吐；只影响之后新建的 endpoint
+    void setConnectionsPerEndpoint(int n);
+    // 空闲回收时间（秒），<= 0 表示不回收
+    void setIdleTimeout(double seconds);
+    // 服务发现报告 endpoint 下线后保留连接的时间（秒）：期间重新上线（如 ZK 会话抖动）直接复用原连接，
+    // 已发出的调用也不会因为连接被立即关闭而失败
+    void setRetireGrace(double seconds);
+    // 为每个 endpoint 创建一个自适应的 ConcurrencyLimiter，由该 endpoint 的所有连接共用，
+    // 在服务端开始排队之前由客户端自行限流；只影响之后新建的 endpoint，默认不限制
+    void setConcurrencyLimit(const ConcurrencyLimiter::Options& options);
+
+    // 取一条到 endpoint 的共享 channel；hostPort 形如 "127.0.0.1:8000"。
+    // 地址非法时返回一条不连接的 channel，其上的调用都以 INVALID_ARGUMENT 失败
+    ClientChannelPtr getChannel(const std::string& hostPort);
+    ClientChannelPtr getChannel(const muduo::net::InetAddress& addr);
+    // 直接使用服务发现解析好的地址，不再解析字符串
+    ClientChannelPtr getChannel(const ::Endpoint& endpoint);
+
+    // endpoint 下线时主动关闭其连接（已被 Stub 持有的 channel 在最后一个引用释放后析构）
+    void remove(const std::string& hostPort);
+    // 标记 endpoint 下线，过了 retireGrace 仍未重新使用才从池中移除；ServiceDiscovery 成员变化时自动调用
+    void retire(const std::string& hostPort);
+    size_t endpointCount();
+
+private:
+    ChannelPool();
+    ~ChannelPool();
+    ChannelPool(const ChannelPool&) = delete;
+    ChannelPool& operator=(const ChannelPool&) = delete;
+
+    struct Endpoint {
+        std::vector<ClientChannelPtr>  channels;
+        size_t                         next;        // 轮询下标
+        int64_t                        lastUsedUs;  // 最近一次 getChannel 的时间
+        int64_t                        retiredAtUs; // 被服务发现标记下线的时间，0 表示在线
+    };
+
+    ClientChannelPtr getChannel(const std::string& key, const muduo::net::InetAddress& addr);
+    // 回收用的定时器都挂在同一个 loop 上，析构时在该 loop 上取消
+    muduo::net::EventLoop* timerLoopLocked();
+    void startReaper();
+    void reapIdle();
+    void reapRetired(const std::string& hostPort, uint64_t generation);
+
+    std::mutex                                  mutex_;
+    std::unordered_map<std::string, Endpoint>   endpoints_;
+    int                                         connectionsPerEndpoint_;
+    bool                                        limitConcurrency_;
+    ConcurrencyLimiter::Options                 limiterOptions_;
+    double                                      idleTimeout_;
+    double                                      retireGrace_;
+    int                                         listenerId_;
+    bool                                        reaperStarted_;
+    muduo::net::EventLoop*                      timerLoop_;
+    muduo::net::TimerId                         reaperTimer_;
+    // hostPort -> 下线回收定时器及其序号，到期时序号对得上才移除（被取消的旧定时器可能已在执行）
+    std::unordered_map<std::string, std::pair<uint64_t, muduo::net::TimerId>>  retireTimers_;
+    uint64_t                                    nextRetireGeneration_;
+};
+
+#endif // _CHANNELPOOL_H_
@@ -0,0 +1,126 @@
+// ClientChannel.h
+#ifndef _CLIENTCHANNEL_H_
+#define _CLIENTCHANNEL_H_
+
+#include <google/protobuf/service.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/TcpClient.h>
+#include <muduo/base/Mutex.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "RPCChannel.h"
+#include "FutexWaiter.h"
+#include "Endpoint.h"
+#include "ConcurrencyLimiter.h"
+
+// 绑定在某个 IO loop 上的一条客户端连接（TcpClient + RPCChannel），
+// 作为 RpcChannel 交给 Stub 使用，可被任意线程共享调用。
+// 断线后自动重连，断线时未完成的调用全部以失败结束；连接建立前发起的调用先在本地排队
+// （有上限，超过 connectTimeout 仍未连上则以失败结束），因此可以懒连接。
+// 必须在所属 loop 线程析构——由 ClientRuntime::newChannel 返回的 shared_ptr 会保证这一点。
+class ClientChannel : public ::google::protobuf::RpcChannel {
+public:
+    ClientChannel(muduo::net::EventLoop* loop,
+                  const muduo::net::InetAddress& serverAddr,
+                  const std::string& name);
+    ~ClientChannel() override;
+
+    void connect();
+    void disconnect();
+    // 连接建立前排队调用的最长等待时间（秒），同步调用也按它等待首次连接
+    void setConnectTimeout(double seconds) { connectTimeout_ = seconds; }
+    // 等待首次连接建立，返回 false 表示超时
+    bool waitConnected(double seconds) { return firstConnected_.waitFor(seconds); }
+    bool connected() const { return connected_.load(std::memory_order_acquire); }
+    // 每次调用的在途数、延迟和成败，以及响应中捎带的服务端负载回填到 stats，供负载均衡使用；
+    // 需在第一次调用前设置
+    void setStats(const EndpointStatsPtr& stats);
+    // 按 limiter 限制发往该 endpoint 的在途调用数，同一 endpoint 的多条连接共用一个 limiter；
+    // 超过上限的调用在 limiter 的队列中等待或以 RESOURCE_EXHAUSTED 失败。需在第一次调用前设置
+    void setLimiter(const std::shared_ptr<ConcurrencyLimiter>& limiter) { limiter_ = limiter; }
+    const std::shared_ptr<ConcurrencyLimiter>& limiter() const { return limiter_; }
+    // 地址非法、不会建立连接的 channel：之后的调用都以 INVALID_ARGUMENT 和 errorText 失败。需在第一次调用前设置
+    void setAddressError(const std::string& errorText) { addressError_ = errorText; }
+
+    muduo::net::EventLoop*          getLoop() const { return loop_; }
+    const muduo::net::InetAddress&  serverAddress() const { return serverAddr_; }
+    RPCChannel*                     rpcChannel() { return channel_.get(); }
+
+    // 转发给底层 RPCChannel，可在任意线程调用
+    void CallMethod(const ::google::protobuf::MethodDescriptor* method,
+                    ::google::protobuf::RpcController* controller,
+                    const ::google::protobuf::Message* request,
+                    ::google::protobuf::Message* response,
+                    ::google::protobuf::Closure* done) override;
+    // 异步调用，返回调用 id 供 cancel 使用；连接建立前或在 limiter 中排队的调用、本地失败的调用返回 0（不能取消）
+    int64_t CallAsync(const ::google::protobuf::MethodDescriptor* method,
+                      ::google::protobuf::RpcController* controller,
+                      const ::google::protobuf::Message* request,
+                      ::google::protobuf::Message* response,
+                      ::google::protobuf::Closure* done);
+    // 见 RPCChannel::cancel；被取消的调用不计入 endpoint 统计的成败和延迟
+    bool cancel(int64_t id) { return channel_->cancel(id, "rpc call cancelled"); }
+
+private:
+    struct PendingCall {
+        const ::google::protobuf::MethodDescriptor*   method;
+        ::google::protobuf::RpcController*            controller;
+        std::shared_ptr<::google::protobuf::Message>  request;   // 排队期间持有一份拷贝
+        ::google::protobuf::Message*                  response;
+        ::google::protobuf::Closure*                  done;
+        int64_t                                       enqueuedUs;
+    };
+
+    // 返回调用 id，同步调用返回 0
+    int64_t dispatch(const ::google::protobuf::MethodDescriptor* method,
+                     ::google::protobuf::RpcController* controller,
+                     const ::google::protobuf::Message* request,
+                     ::google::protobuf::Message* response,
+                     ::google::protobuf::Closure* done);
+    // 超过并发上限的调用：排队或失败
+    int64_t throttle(const ::google::protobuf::MethodDescriptor* method,
+                     ::google::protobuf::RpcController* controller,
+                     const ::google::protobuf::Message* request,
+                     ::google::protobuf::Message* response,
+                     ::google::protobuf::Closure* done);
+    // 已拿到名额（或没有 limiter）的调用交给 RPCChannel。
+    // 只用共享的对象，排队的调用拿到名额时本 ClientChannel 可能已经析构
+    static int64_t send(const std::shared_ptr<RPCChannel>& channel,
+                        const EndpointStatsPtr& stats,
+                        const std::shared_ptr<ConcurrencyLimiter>& limiter,
+                        const ::google::protobuf::MethodDescriptor* method,
+                        ::google::protobuf::RpcController* controller,
+                        const ::google::protobuf::Message* request,
+                        ::google::protobuf::Message* response,
+                        ::google::protobuf::Closure* done);
+    void onConnection(const muduo::net::TcpConnectionPtr& conn);
+    void flushPending();
+    // 排队超过 connectTimeout 的调用以失败结束，再按剩下最早的调用重新定时；all 为 true 时全部失败
+    void expirePending(bool all);
+
+    muduo::net::EventLoop*       loop_;
+    muduo::net::InetAddress      serverAddr_;
+    muduo::net::TcpClient        client_;
+    std::shared_ptr<RPCChannel>  channel_;
+    std::atomic<bool>            connected_;
+    FutexWaiter                  firstConnected_;
+    double                       connectTimeout_;
+    EndpointStatsPtr             stats_;
+    std::shared_ptr<ConcurrencyLimiter>  limiter_;
+    std::string                  addressError_;
+
+    muduo::MutexLock             mutex_;
+    std::deque<PendingCall>      pending_ GUARDED_BY(mutex_);    // 按排队先后
+    bool                         expireScheduled_ GUARDED_BY(mutex_);
+    muduo::net::TimerId          expireTimer_;
+};
+
+typedef std::shared_ptr<ClientChannel> ClientChannelPtr;
+
+#endif // _CLIENTCHANNEL_H_
@@ -0,0 +1,57 @@
+// ClientRuntime.h
+#ifndef _CLIENTRUNTIME_H_
+#define _CLIENTRUNTIME_H_
+
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/EventLoopThread.h>
+#include <muduo/net/InetAddress.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ClientChannel.h"
+
+// 进程级客户端运行时：持有固定数量的 IO 线程，所有客户端连接都分配到这些 loop 上，
+// 应用线程无需自建 EventLoop，直接通过 ClientChannel（异步 / Future / 同步 Call）发起调用。
+class ClientRuntime {
+public:
+    static ClientRuntime& instance();
+
+    // 启动 IO 线程，只有第一次调用生效；numThreads <= 0 时取 CPU 核数
+    void start(int numThreads = 0);
+    bool started() const { return started_.load(std::memory_order_acquire); }
+    int  threadNum() const;
+
+    // 轮询分配 loop；未 start 时按默认线程数自动启动
+    muduo::net::EventLoop* nextLoop();
+    // 同一个 key（通常是 ip:port）总是落在同一个 loop 上，提高缓存局部性
+    muduo::net::EventLoop* loopForKey(const std::string& key);
+    // 当前线程是否是某个 IO 线程：响应由这些线程投递，在上面阻塞等待会死锁
+    bool inLoopThread() const;
+
+    // 创建一条连接到 serverAddr 的 ClientChannel 并开始连接，loop 按地址固定分配；
+    // 最后一个引用释放时，channel 会在其所属 loop 线程上析构
+    ClientChannelPtr newChannel(const muduo::net::InetAddress& serverAddr);
+    // 地址非法时代替 newChannel：不建立连接，每次调用都以 INVALID_ARGUMENT 和 errorText 失败
+    ClientChannelPtr newInvalidChannel(const std::string& errorText);
+
+private:
+    ClientRuntime();
+    // 最后一个引用释放时在 loop 线程上析构
+    static ClientChannelPtr own(muduo::net::EventLoop* loop, ClientChannel* channel);
+
+    ~ClientRuntime();
+    ClientRuntime(const ClientRuntime&) = delete;
+    ClientRuntime& operator=(const ClientRuntime&) = delete;
+
+    std::mutex                                                 mutex_;
+    std::atomic<bool>                                          started_;
+    std::vector<std::unique_ptr<muduo::net::EventLoopThread>>  threads_;
+    std::vector<muduo::net::EventLoop*>                        loops_;
+    std::atomic<size_t>                                        next_;
+};
+
+#endif // _CLIENTRUNTIME_H_
@@ -0,0 +1,83 @@
+// ConcurrencyLimiter.h
+#ifndef _CONCURRENCYLIMITER_H_
+#define _CONCURRENCYLIMITER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include "rpc.pb.h"
+
+// 客户端对单个 endpoint 的自适应并发上限，ChannelPool 为每个 endpoint 创建一个，该 endpoint 的所有连接共用。
+// 上限按往返延迟的梯度调整（Gradient2）：
+//   gradient = clamp(tolerance × 长期 RTT / 短期 RTT, 0.5, 1)
+//   newLimit = limit × gradient + sqrt(limit)
+// 延迟没有上升时每次增加约 sqrt(limit)，排队使短期 RTT 超过长期 RTT 的 tolerance 倍后开始收缩；
+// 调用超时或服务端资源不足时按 backoffRatio 乘性减小。在途数不到上限一半时不增长，避免空闲时上限虚高。
+// 超过上限的调用按 Options 在本地有界队列中等待，或直接以 RESOURCE_EXHAUSTED 失败
+class ConcurrencyLimiter {
+public:
+    struct Options {
+        Options();
+
+        int     initialLimit;      // 默认 20
+        int     minLimit;          // 默认 4
+        int     maxLimit;          // 默认 1000
+        double  tolerance;         // 短期 RTT 超过长期 RTT 的多少倍开始收缩，默认 1.5
+        double  smoothing;         // 每个样本向新上限移动的比例，默认 0.2
+        double  backoffRatio;      // 超时/资源不足时上限乘以该值，默认 0.9
+        int     maxQueue;          // 超过上限时排队的调用数，0 表示直接失败，默认 0
+        double  maxQueueWait;      // 排队的最长时间（秒），超过后以失败结束，默认 0.1
+    };
+    // 排队的调用拿到名额（true）或排队超时（false）时回调，在释放名额或执行 expire 的线程上执行
+    typedef std::function<void(bool admitted)> Waiter;
+
+    explicit ConcurrencyLimiter(const Options& options = Options());
+
+    // 在途数未达上限时占用一个名额
+    bool tryAcquire();
+    // tryAcquire 失败后排队；队列已满（或不允许排队）时返回 false，waiter 不会被调用。
+    // armTimer 返回 true 表示队列由空变为非空，调用方需在 maxQueueWait 后调用 expire
+    bool enqueue(const Waiter& waiter, bool* armTimer);
+    // 排队超时的调用以 false 回调；返回距下一个排队调用超时的秒数，队列已空时返回 0
+    double expire();
+
+    // 调用结束，释放名额；dropped 表示超时或服务端资源不足
+    void onComplete(int64_t rttUs, bool dropped);
+    // 被取消或没有得到服务端响应的调用只释放名额，不计入延迟样本
+    void onIgnore() { release(); }
+    // 按调用的状态码选择上面两者：OK 记录 rttUs，超时/资源不足按 dropped 计，其余只释放名额
+    void onResult(Krpc::StatusCode status, int64_t rttUs);
+
+    int     limit() const { return limit_.load(std::memory_order_relaxed); }
+    int     inflight() const { return inflight_.load(std::memory_order_relaxed); }
+    double  maxQueueWait() const { return options_.maxQueueWait; }
+
+private:
+    struct QueuedCall {
+        Waiter   waiter;
+        int64_t  enqueuedUs;
+    };
+
+    bool acquireSlot();
+    void release();
+    Waiter popLocked();
+    void update(int64_t rttUs, bool dropped, int inflight);
+    static int64_t nowUs();
+
+    const Options            options_;
+    std::atomic<int>         limit_;
+    std::atomic<int>         inflight_;
+
+    std::mutex               mutex_;          // 保护以下状态
+    double                   estimatedLimit_;
+    double                   shortRttUs_;
+    double                   longRttUs_;
+    int64_t                  lastBackoffUs_;
+    std::deque<QueuedCall>   queue_;
+    std::atomic<size_t>      queued_;         // queue_.size()，释放名额时不加锁判断
+};
+
+#endif // _CONCURRENCYLIMITER_H_
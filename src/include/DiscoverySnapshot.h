@@ -0,0 +1,28 @@
+// DiscoverySnapshot.h
+#ifndef _DISCOVERYSNAPSHOT_H_
+#define _DISCOVERYSNAPSHOT_H_
+
+#include <string>
+#include <vector>
+
+// 服务发现缓存的本地快照文件。客户端启动时先加载它，不必等 ZooKeeper 连上就能选取实例；
+// ZooKeeper 不可用期间重启也能继续使用上一次看到的实例列表。
+//
+// 文件格式（本机字节序，整个文件 mmap 后顺序遍历即可，不需要额外的解析缓冲）：
+//   Header  { char magic[8]; uint32 formatVersion; uint32 entryCount; uint64 payloadSize; uint64 checksum; }
+//   Payload entryCount 个 Entry，紧密排列：
+//     Entry { uint32 keyLen; uint32 hostCount; char key[keyLen]; hostCount 个 { uint32 len; char data[len]; } }
+// checksum 是 payload 的 LoadBalancer::hash。写入时先写临时文件再 rename，读端不会看到写了一半的文件
+class DiscoverySnapshot {
+public:
+    struct Entry {
+        std::string              key;     // "service/method"
+        std::vector<std::string> hosts;   // 实例节点的原始数据，与从 ZooKeeper 读到的一致
+    };
+
+    // 文件不存在、格式或校验不对时返回 false，out 不变
+    static bool load(const std::string& path, std::vector<Entry>* out);
+    static bool save(const std::string& path, const std::vector<Entry>& entries);
+};
+
+#endif // _DISCOVERYSNAPSHOT_H_
@@ -0,0 +1,124 @@
+// Endpoint.h
+#ifndef _ENDPOINT_H_
+#define _ENDPOINT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <muduo/net/InetAddress.h>
+
+class OutlierDetector;
+
+// 单个 endpoint 的运行时统计，由完成的调用回填，供负载均衡使用。
+// 以 ip:port 为键保存在 ServiceDiscovery 中，成员列表刷新时不会丢失。
+class EndpointStats {
+public:
+    EndpointStats();
+    explicit EndpointStats(const std::string& hostPort);
+
+    const std::string& hostPort() const { return hostPort_; }
+    // 调用结果交给 detector 做异常摘除，需在第一次调用前设置；ServiceDiscovery::endpointStats 创建时自动设置
+    void setDetector(OutlierDetector* detector) { detector_ = detector; }
+
+    // 发起调用 / 调用完成（latencyUs 为往返耗时，timedOut 表示因超时失败）
+    void onStart() { inflight_.fetch_add(1, std::memory_order_relaxed); }
+    void onFinish(int64_t latencyUs, bool ok, bool timedOut = false);
+    // 调用被主动取消（如对冲请求中落选的一份）：只减在途数，不计入延迟和成败
+    void onCancel() { inflight_.fetch_sub(1, std::memory_order_relaxed); }
+
+    int      inflight() const { return inflight_.load(std::memory_order_relaxed); }
+    int64_t  ewmaLatencyUs() const { return ewmaUs_.load(std::memory_order_relaxed); }
+    uint64_t successes() const { return successes_.load(std::memory_order_relaxed); }
+    uint64_t failures() const { return failures_.load(std::memory_order_relaxed); }
+    int      consecutiveFailures() const { return consecutiveFailures_.load(std::memory_order_relaxed); }
+    int      consecutiveTimeouts() const { return consecutiveTimeouts_.load(std::memory_order_relaxed); }
+    // 被异常摘除（包括摘除到期、等待探测结果的半开状态）；ejections 为累计摘除次数
+    bool     ejected() const { return ejectedUntilUs_.load(std::memory_order_acquire) != 0; }
+    int      ejections() const { return ejections_.load(std::memory_order_relaxed); }
+    // 没有被摘除，且最近的调用没有连续失败（连续失败 3 次视为不健康，成功一次即恢复）
+    bool     healthy() const;
+
+    // 服务端随响应捎带的负载（RpcHeader.load），1 秒内没有新的上报视为过期
+    void onServerLoad(int inflight, int64_t queueDelayUs, int cpuPermille);
+    bool     hasServerLoad() const;
+    int      serverInflight() const { return serverInflight_.load(std::memory_order_relaxed); }
+    int64_t  serverQueueDelayUs() const { return serverQueueUs_.load(std::memory_order_relaxed); }
+    int      serverCpuPermille() const { return serverCpu_.load(std::memory_order_relaxed); }
+
+    // 用于比较的在途数：本地在途数与服务端上报的在途数（包含其他客户端的请求）取大者
+    int      load() const;
+
+    // peak-EWMA 代价：（延迟 EWMA + 服务端排队时间）*（在途数 + 1）/（1 - CPU 利用率）；
+    // 还没有样本但已有在途请求时给一个大的惩罚值，避免冷启动的 endpoint 因延迟为 0 被持续选中
+    double cost() const;
+
+private:
+    friend class OutlierDetector;
+
+    std::string            hostPort_;
+    OutlierDetector*       detector_;
+    std::atomic<int>       inflight_;
+    std::atomic<int64_t>   ewmaUs_;
+    std::atomic<uint64_t>  successes_;
+    std::atomic<uint64_t>  failures_;
+    std::atomic<int>       consecutiveFailures_;
+    std::atomic<int>       consecutiveTimeouts_;
+    std::mutex             mutex_;         // 保护 EWMA 的读-改-写
+    int64_t                lastSampleUs_;
+
+    std::atomic<int>       serverInflight_;
+    std::atomic<int64_t>   serverQueueUs_;
+    std::atomic<int>       serverCpu_;
+    std::atomic<int64_t>   serverLoadAtUs_;  // 最近一次上报的本地接收时间，0 表示从未上报
+
+    // 以下由 OutlierDetector 维护，时间为 steady 时钟（微秒）
+    std::atomic<int64_t>   ejectedUntilUs_;  // 0 表示未被摘除
+    std::atomic<int>       ejections_;
+    std::atomic<int64_t>   probeAtUs_;       // 半开状态下放行探测请求的时间
+    std::atomic<int64_t>   restoredAtUs_;    // 最近一次恢复的时间
+};
+
+typedef std::shared_ptr<EndpointStats> EndpointStatsPtr;
+
+// 服务发现缓存中的一个实例，在 watch 更新时解析好，选取时直接使用，不再解析字符串
+struct Endpoint {
+    Endpoint() : weight(1), maxConcurrency(0), protocolVersion(0), startTimeMs(0), slowStartUs(0) {}
+
+    // 解析实例节点的数据，支持两种编码：
+    //   protobuf：序列化的 Krpc::EndpointMeta（RpcServer 注册时写入，见 rpc.proto）
+    //   文本："ip:port" 后面可以跟 ";key=value" 属性，例如 "10.0.0.5:8000;weight=3;zone=bj-a;version=1.2.0"，
+    //         IPv6 写成 "[::1]:8000"
+    // 地址非法时返回 false，未知属性忽略
+    static bool parse(const std::string& data, Endpoint* out);
+    // data 是否为 protobuf 编码（第一个字节是 meta_version 的 tag）
+    static bool isMeta(const std::string& data) { return !data.empty() && data[0] == '\x08'; }
+
+    std::string              data;       // 注册中心里的原始实例数据，写本地快照时原样保存
+    std::string              hostPort;   // "ip:port"，也是统计和连接池的 key
+    muduo::net::InetAddress  addr;       // 预先解析好的 sockaddr
+    int                      weight;     // 默认 1
+    std::string              zone;       // 所在可用区，未声明时为空
+    std::string              rack;       // 所在机架，未声明时为空
+    std::string              version;    // 服务构建版本，未声明时为空
+    int                      maxConcurrency;    // 单实例最大并发，0 表示不限
+    int                      protocolVersion;   // 帧格式版本，文本格式注册的实例为 0
+    int64_t                  startTimeMs;       // 进程启动时间（Unix 毫秒），未知为 0
+    EndpointStatsPtr         stats;
+    // 客户端看到它新加入（或重启）的时间（steady 时钟，微秒），慢启动窗口内按比例分配流量；0 表示不需要慢启动
+    int64_t                  slowStartUs;
+
+    // 除统计外的属性是否相同，用于判断实例是否被更新
+    bool sameAttributes(const Endpoint& other) const {
+        return weight == other.weight && zone == other.zone && rack == other.rack && version == other.version
+            && maxConcurrency == other.maxConcurrency && protocolVersion == other.protocolVersion
+            && startTimeMs == other.startTimeMs;
+    }
+};
+
+typedef std::vector<Endpoint> EndpointList;
+
+#endif // _ENDPOINT_H_
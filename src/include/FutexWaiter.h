@@ -0,0 +1,29 @@
+// FutexWaiter.h
+#ifndef _FUTEXWAITER_H_
+#define _FUTEXWAITER_H_
+
+#include <atomic>
+
+// 一次性的轻量等待器：一个或多个线程 wait，任意线程 wake 一次后全部放行。
+// 直接基于 Linux futex，只占一个 int，不需要为每次同步调用创建 mutex + condvar；
+// 若 wake 发生在 wait 真正睡眠之前，则完全不进入内核。
+class FutexWaiter {
+public:
+    FutexWaiter() : state_(kIdle) {}
+
+    // 唤醒所有等待者，重复调用无副作用
+    void wake();
+    // 等待被唤醒，seconds <= 0 表示一直等；返回 false 表示超时
+    bool waitFor(double seconds);
+    void wait() { waitFor(0); }
+    bool woken() const { return state_.load(std::memory_order_acquire) == kWoken; }
+
+private:
+    FutexWaiter(const FutexWaiter&) = delete;
+    FutexWaiter& operator=(const FutexWaiter&) = delete;
+
+    enum { kIdle = 0, kWoken = 1, kSleeping = 2 };
+    std::atomic<int> state_;
+};
+
+#endif // _FUTEXWAITER_H_
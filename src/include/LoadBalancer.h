@@ -0,0 +1,51 @@
+// LoadBalancer.h
+#ifndef _LOADBALANCER_H_
+#define _LOADBALANCER_H_
+
+#include <google/protobuf/message.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Endpoint.h"
+
+// 一次选取的上下文。一致性哈希策略（ring_hash / maglev）按 hashKey 选实例，
+// 同一个 key 总是落到同一个实例上；其他策略忽略它
+struct PickContext {
+    PickContext() : hasHashKey(false), hashKey(0) {}
+
+    static PickContext withHash(uint64_t hash);
+    static PickContext withKey(const std::string& key);
+    // 用请求中的某个字段（标量或字符串，按名字查找）作为 key；字段不存在时不带 key
+    static PickContext fromField(const google::protobuf::Message& request, const std::string& field);
+
+    bool      hasHashKey;
+    uint64_t  hashKey;
+};
+
+// 负载均衡策略接口，每个 service/method 一个实例。
+// rebuild 在成员列表变化时由更新线程调用，pick 在任意调用线程上并发调用。
+class LoadBalancer {
+public:
+    virtual ~LoadBalancer() {}
+
+    virtual void rebuild(const EndpointList& endpoints) {}
+    // 返回 endpoints 中的下标，endpoints 保证非空且与最近一次 rebuild 的一致
+    virtual size_t pick(const EndpointList& endpoints, const PickContext& ctx) = 0;
+
+    // 按名字创建：random（默认）、round_robin（加权轮询）、p2c（两次随机取在途最少）、
+    // ewma（两次随机取 peak-EWMA 代价最小）、ring_hash（ketama 哈希环）、maglev（Maglev 查找表）；
+    // 两个一致性哈希策略可以带有界负载系数，如 "maglev:1.25"（默认 1.25，0 表示不限制，
+    // 其他不大于 1 或不是数字的系数打印告警后按默认值处理）。
+    // 未知名字返回空
+    static std::shared_ptr<LoadBalancer> create(const std::string& policy);
+
+    // 跨进程稳定的 64 位哈希，所有客户端对同一个 key 得到同样的结果
+    static uint64_t hash(const char* data, size_t len);
+    static uint64_t hash(const std::string& s) { return hash(s.data(), s.size()); }
+};
+
+typedef std::shared_ptr<LoadBalancer> LoadBalancerPtr;
+
+#endif // _LOADBALANCER_H_
@@ -0,0 +1,45 @@
+// LoadReporter.h
+#ifndef _LOADREPORTER_H_
+#define _LOADREPORTER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace Krpc {
+class ServerLoad;
+}
+
+// 服务端的负载统计，RpcServer 持有一个，所有连接上的 RPCChannel 共享。
+// 每个响应都带上当前负载（RpcHeader.load），客户端随调用结果一起拿到，
+// 不需要额外的探测请求，也不需要写 ZooKeeper
+class LoadReporter {
+public:
+    LoadReporter();
+
+    // 请求开始处理；queueDelayUs 是从读出请求到开始处理的时间
+    void onRequest(int64_t queueDelayUs);
+    // 请求处理完、回包之前
+    void onResponse() { inflight_.fetch_sub(1, std::memory_order_relaxed); }
+
+    // 填写回包时的负载，CPU 利用率按需采样（间隔不少于 100ms）
+    void fill(Krpc::ServerLoad* load);
+
+    int      inflight() const { return inflight_.load(std::memory_order_relaxed); }
+    int64_t  queueDelayUs() const { return queueDelayUs_.load(std::memory_order_relaxed); }
+    int      cpuPermille() const { return cpuPermille_.load(std::memory_order_relaxed); }
+
+private:
+    void sampleCpu(int64_t nowUs);
+
+    std::atomic<int>       inflight_;
+    std::atomic<int64_t>   queueDelayUs_;   // EWMA
+    std::atomic<int>       cpuPermille_;
+    std::atomic<int64_t>   nextSampleUs_;
+    std::mutex             sampleMutex_;
+    int64_t                lastWallUs_;     // 上次采样的时间
+    int64_t                lastCpuUs_;      // 上次采样时进程累计的 CPU 时间
+    int                    cpus_;
+};
+
+#endif // _LOADREPORTER_H_
@@ -0,0 +1,64 @@
+// OutlierDetector.h
+#ifndef _OUTLIERDETECTOR_H_
+#define _OUTLIERDETECTOR_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "Endpoint.h"
+
+// 客户端异常实例摘除（outlier detection）与熔断。
+// 实例还连着 ZooKeeper、节点还在，但已经频繁出错或明显变慢时，暂时把它从选取中摘除：
+//   * 连续失败 / 连续超时达到阈值：调用结束时立即摘除
+//   * 延迟异常：周期性比较同一方法下各实例的延迟 EWMA，超过中位数若干倍的摘除
+// 摘除时长按 base × 2^已摘除次数 增长，不超过 max；到期后进入半开状态，同一时间只放行一个探测请求，
+// 成功则恢复，失败则以更长的时长再次摘除。同一方法下被摘除的实例超过 maxEjectionPercent 时不再避开，
+// 避免把流量集中压到剩下的少数实例上。ServiceDiscovery 持有一个，参数可以在运行中修改
+class OutlierDetector {
+public:
+    struct Options {
+        Options();
+
+        int     consecutiveErrors;     // 连续失败多少次摘除，0 关闭，默认 5
+        int     consecutiveTimeouts;   // 连续超时多少次摘除，0 关闭，默认 3
+        double  latencyFactor;         // 延迟 EWMA 超过同组中位数多少倍算异常，0 关闭，默认 3
+        double  minLatency;            // 延迟低于此值（秒）不算异常，默认 5ms
+        double  interval;              // 延迟检测周期（秒），默认 1s
+        double  baseEjection;          // 首次摘除时长（秒），默认 10s
+        double  maxEjection;           // 摘除时长上限（秒），默认 300s
+        int     maxEjectionPercent;    // 同一方法下最多避开多少比例的实例，默认 50
+    };
+
+    OutlierDetector();
+
+    void setOptions(const Options& options);
+    Options options() const;
+    int64_t intervalUs() const { return intervalUs_.load(std::memory_order_relaxed); }
+
+    // 调用结束（EndpointStats::onFinish 已更新计数之后）：连续失败/超时达到阈值时摘除，
+    // 半开状态下的结果决定恢复还是再次摘除
+    void onResult(EndpointStats* stats, bool ok);
+    // 选取时：未被摘除、或半开且拿到了探测名额时返回 true
+    bool admit(EndpointStats* stats, int64_t nowUs);
+    // 同一方法下被摘除的实例是否已超过上限（此时不再避开它们）
+    bool overEjectionLimit(const EndpointList& endpoints) const;
+    // 延迟异常检测，由 ServiceDiscovery 按 interval 对每个方法的实例列表调用
+    void sweep(const EndpointList& endpoints);
+
+    static int64_t nowUs();
+
+private:
+    // 以 expectedUntilUs（0 表示当前未被摘除）为前提摘除，状态已被其他线程改变时返回 false
+    bool eject(EndpointStats* stats, int64_t nowUs, int64_t expectedUntilUs, const char* reason);
+
+    std::atomic<int>      consecutiveErrors_;
+    std::atomic<int>      consecutiveTimeouts_;
+    std::atomic<double>   latencyFactor_;
+    std::atomic<int64_t>  minLatencyUs_;
+    std::atomic<int64_t>  intervalUs_;
+    std::atomic<int64_t>  baseEjectionUs_;
+    std::atomic<int64_t>  maxEjectionUs_;
+    std::atomic<int>      maxEjectionPercent_;
+};
+
+#endif // _OUTLIERDETECTOR_H_
@@ -7,9 +7,14 @@
 #include <muduo/net/Buffer.h>
 #include <muduo/base/Atomic.h>
 #include <muduo/base/Mutex.h>
+#include <muduo/net/EventLoop.h>
 #include <map>
 #include <atomic>
+#include <functional>
+#include <memory>
 #include "rpc.pb.h"
+#include "LoadReporter.h"
+#include "RpcController.h"
 struct ServiceInfo
 {
     google::protobuf::Service* service;
@@ -21,48 +26,109 @@ private:
 
     struct OutstandingCall {
         ::google::protobuf::Message* response;
+        ::google::protobuf::RpcController* controller;
         ::google::protobuf::Closure* done;
+        bool borrowed;      // 同步调用：response/done 属于调用方栈，析构时不能 delete
+    };
+    // 服务端单次调用的上下文：request/response 的生命周期延长到 done->Run()，
+    // 这样异步/协程 handler 在 CallMethod 返回后仍可安全读取 request。
+    // 异步 handler 的 done 可能在连接断开、本 channel 释放之后才执行，因此不引用 channel，
+    // 只持有连接的 weak_ptr，连接已不在时丢弃回包
+    struct ServerCall {
+        std::unique_ptr<::google::protobuf::Message> request;
+        std::unique_ptr<::google::protobuf::Message> response;
+        uint64_t id;
+        RpcController controller;       // handler 调用 SetFailed 后以其状态码和错误信息回包
+        std::weak_ptr<muduo::net::TcpConnection> conn;
+        LoadReporter* loadReporter;     // 属于 RpcServer，生命周期覆盖所有调用
     };
 public:
     explicit RPCChannel(const std::shared_ptr<muduo::net::TcpConnection>& conn);
     explicit RPCChannel();
     ~RPCChannel() override;
 
-    // 发起异步 RPC 调用
+    // 发起异步 RPC 调用；done 为空时按 protobuf 约定阻塞，等价于 Call(..., callTimeout_)
     void CallMethod(const ::google::protobuf::MethodDescriptor* method,
                     ::google::protobuf::RpcController* controller,
                     const ::google::protobuf::Message* request,
                     ::google::protobuf::Message* response,
                     ::google::protobuf::Closure* done) override;
 
+    // 同步阻塞调用，可在任意非本 channel IO 线程的线程上并发调用；
+    // timeoutSeconds <= 0 表示不超时。失败/超时返回 false，原因写入 controller（可为空）
+    bool Call(const ::google::protobuf::MethodDescriptor* method,
+              const ::google::protobuf::Message& request,
+              ::google::protobuf::Message* response,
+              double timeoutSeconds,
+              ::google::protobuf::RpcController* controller = nullptr);
+
+    // 与 done 非空的 CallMethod 相同，返回调用 id 供 cancel 使用；本地失败时执行 done 并返回 0
+    int64_t CallAsync(const ::google::protobuf::MethodDescriptor* method,
+                      ::google::protobuf::RpcController* controller,
+                      const ::google::protobuf::Message* request,
+                      ::google::protobuf::Message* response,
+                      ::google::protobuf::Closure* done);
+    // 取消尚未收到响应的调用：从 outstanding 表摘除，以 CANCELLED 失败并执行 done，之后到达的响应不再解析直接丢弃；
+    // 调用已经完成（或正在完成）时返回 false
+    bool cancel(int64_t id, const std::string& reason);
+
+    void setCallTimeout(double seconds) { callTimeout_ = seconds; }
+
     // 设置连接
     void setConnection(const muduo::net::TcpConnectionPtr& conn) {
+        muduo::MutexLockGuard lock(mutex_);
         conn_ = conn;
     }
+    // 连接断开时调用：所有未完成的调用以 reason 失败并执行 done
+    void failOutstandings(const std::string& reason);
     void setServices(const std::map<std::string, ServiceInfo>* services)
     {
         services_ = services;
     }
+    // 服务端：回包时带上 reporter 统计的负载，为空则不带
+    void setLoadReporter(LoadReporter* reporter) { loadReporter_ = reporter; }
+    // 客户端：收到带负载的响应时在 IO 线程上回调，需在第一次调用前设置
+    typedef std::function<void(const Krpc::ServerLoad&)> LoadCallback;
+    void setLoadCallback(const LoadCallback& cb) { loadCallback_ = cb; }
 
     // 接收数据回调
     void onMessage(const muduo::net::TcpConnectionPtr& conn, muduo::net::Buffer* buf, muduo::Timestamp receive_time);
     typedef std::shared_ptr<google::protobuf::Message> MessagePtr;
     typedef std::shared_ptr<Krpc::RpcHeader> RpcMessagePtr;
     void onRPCMessage(const muduo::net::TcpConnectionPtr& conn, const RpcMessagePtr& messagePtr, muduo::Timestamp receive_time);
-    void doneCallback(::google::protobuf::Message* response, uint64_t id);
+    static void doneCallback(ServerCall* call);
 
 private:
+    // 注册 outstanding 并发送请求，返回调用 id；本地失败时执行 done 并返回 0
+    int64_t startCall(const ::google::protobuf::MethodDescriptor* method,
+                      ::google::protobuf::RpcController* controller,
+                      const ::google::protobuf::Message* request,
+                      ::google::protobuf::Message* response,
+                      ::google::protobuf::Closure* done,
+                      bool borrowed);
+    // 从 outstanding 表中摘除尚未收到响应的调用，返回是否摘除成功（成功后迟到的响应会被丢弃）
+    bool cancelCall(int64_t id);
+    void failCall(::google::protobuf::RpcController* controller,
+                  ::google::protobuf::Closure* done,
+                  const std::string& reason,
+                  Krpc::StatusCode code);
+    static void sendError(const muduo::net::TcpConnectionPtr& conn, uint64_t id, Krpc::StatusCode code, const std::string& text);
+    static void sendResponse(const muduo::net::TcpConnectionPtr& conn, const Krpc::RpcHeader& respHdr);
 
-    muduo::net::TcpConnectionPtr conn_;
+    muduo::net::TcpConnectionPtr conn_ GUARDED_BY(mutex_);
     muduo::AtomicInt64            id_;//默认为0
     muduo::MutexLock              mutex_;
     std::map<int64_t, OutstandingCall> outstandings_ GUARDED_BY(mutex_);
 
     const std::map<std::string, ServiceInfo>* services_;
+    LoadReporter*                 loadReporter_;
+    LoadCallback                  loadCallback_;
 
 
     const ::google::protobuf::Message *prototype_;
 
+    double                        callTimeout_;     // done 为空时同步调用的超时（秒）
+
 };
 
 #endif // _RPCCHANNEL_H_
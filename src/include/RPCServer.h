@@ -16,6 +16,8 @@
 #include<string>
 #include<map>
 #include<memory>
+#include<functional>
+#include<thread>
 
 class RpcServer
 {
@@ -28,6 +30,10 @@ public:
     void Run(const std::string& server_ip, int server_port,
              const std::string& zook_ip = "127.0.0.1", const std::string& zook_port="2181");
     void StopServer();
+    // 预热：监听端口之后、注册到 ZooKeeper 之前在单独的线程上执行（填充缓存、建立数据库连接池等），
+    // 期间服务已经可以处理请求，但客户端还发现不了它；返回 false 表示没有就绪，不注册。需在 Run 之前设置
+    typedef std::function<bool()> WarmupHook;
+    void SetWarmupHook(WarmupHook hook) { warmup_ = std::move(hook); }
 
 private:
     std::shared_ptr<muduo::net::TcpServer> server_;
@@ -37,10 +43,17 @@ private:
 
 //    std::atomic<bool>            stopping_{false};
     std::atomic<int>             pending_requests_{0};
+    LoadReporter                 load_reporter_;    // 所有连接共享，回包时捎带给客户端
 
     // New members for graceful shutdown
     ZkClient zkclient_;                      // Moved from local in Run
     std::vector<std::string> instance_paths_; // Store all ephemeral node paths
+    std::vector<ZkClient::Node> registry_nodes_; // 注册时一次提交的全部节点
+    double register_backoff_ = 0.2;          // 注册失败后的下一次重试间隔（秒）
+    std::atomic<bool> unregistered_{false};  // Cleanup 之后不再注册或重试
+    WarmupHook warmup_;
+    std::thread warmup_thread_;
+    void Register(); // 批量注册到 ZK，失败按退避重试
     void Cleanup(); // unregister from ZK and close session
 
     void OnConnection(const muduo::net::TcpConnectionPtr& conn);
@@ -0,0 +1,99 @@
+// RetryPolicy.h
+#ifndef _RETRYPOLICY_H_
+#define _RETRYPOLICY_H_
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "rpc.pb.h"
+
+// 单个方法的重试策略，由 ServiceChannel 按方法设置。
+// 只有幂等的方法才会重试：policy.idempotent 为 true，或 proto 中声明了
+//   rpc Get(...) returns (...) { option idempotency_level = IDEMPOTENT; }  // 或 NO_SIDE_EFFECTS
+// 每次重试换一个没有试过的实例，间隔按指数退避并带随机抖动，还要从 RetryBudget 取到令牌
+struct RetryPolicy {
+    RetryPolicy();
+
+    int     maxAttempts;         // 最多尝试几次（含第一次），1 表示不重试，默认 3
+    double  initialBackoff;      // 第一次重试前等待的时间（秒），默认 10ms
+    double  maxBackoff;          // 退避上限（秒），默认 1s
+    double  backoffMultiplier;   // 每次重试退避时间的倍数，默认 2
+    double  jitter;              // 随机抖动比例，实际等待 backoff × [1 - jitter, 1 + jitter]，默认 0.2
+    std::vector<Krpc::StatusCode> retryableCodes;   // 可重试的状态码，默认 UNAVAILABLE、DEADLINE_EXCEEDED
+    bool    idempotent;          // 调用方声明方法幂等，不必在 proto 中声明
+
+    bool retryable(Krpc::StatusCode code) const;
+    // 第 retry 次重试（从 1 开始）前等待的时间（秒），已加抖动
+    double backoff(int retry) const;
+};
+
+// 单个方法的对冲（hedging）策略，由 ServiceChannel 按方法设置，用于降低尾延迟。
+// 只对只读的方法生效：policy.readOnly 为 true，或 proto 中声明了 option idempotency_level = NO_SIDE_EFFECTS。
+// 第一份请求在 delay 内没有结果时，向另一个实例再发一份（最多 maxAttempts 份），先到的结果为准，
+// 其余的从 outstanding 表中取消，迟到的响应直接丢弃。设置了对冲策略的方法不再按 RetryPolicy 重试
+struct HedgingPolicy {
+    HedgingPolicy();
+
+    int     maxAttempts;         // 最多发出几份（含第一份），1 表示不对冲，默认 2
+    double  delay;               // 发出下一份前等待的时间（秒），0 表示按该方法观测到的延迟分位数，默认 0
+    double  percentile;          // delay 为 0 时使用的分位数（0~100），默认 95
+    double  initialDelay;        // 延迟样本不足时使用的等待时间（秒），默认 50ms
+    double  timeout;             // 整个调用的超时（秒），超时后取消所有在途的请求，默认 5s
+    bool    readOnly;            // 调用方声明方法只读，不必在 proto 中声明
+};
+
+// 单个方法的延迟分布，用于取分位数作为对冲延迟。按 2 的幂划分区间、每个区间再分 4 份（误差不超过 25%），
+// 计数为原子变量，记录时不加锁；每记录 kRecomputeEvery 个样本重新计算一次分位数并把计数减半，
+// 因此反映的是最近几千个调用的延迟
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(int64_t latencyUs);
+    // 最近一次计算出的分位数（微秒），样本不足时返回 0
+    int64_t quantileUs() const { return quantileUs_.load(std::memory_order_relaxed); }
+    void setPercentile(double percentile) { percentile_.store(percentile, std::memory_order_relaxed); }
+
+    static const int kSubBuckets = 4;
+    static const int kBuckets = 32 * kSubBuckets;     // 最大约 2^32 微秒
+    static const int kRecomputeEvery = 1024;
+
+    // 延迟所在的桶，以及该桶的上界（不含，微秒）；分位数取所在桶的上界
+    static int bucketOf(int64_t latencyUs);
+    static int64_t bucketUpperUs(int bucket);
+
+private:
+    void recompute();
+
+    std::atomic<uint32_t>  counts_[kBuckets];
+    std::atomic<uint32_t>  samples_;
+    std::atomic<int64_t>   quantileUs_;
+    std::atomic<double>    percentile_;
+};
+
+// 按客户端的重试预算（令牌桶），防止下游过载时重试把流量放大数倍：
+// 每个请求存入 ratio 个令牌，每次重试取出 1 个；另外每秒补充 minPerSecond 个，保证低流量时也能重试；
+// 最多存 maxTokens 个。默认 ratio 0.1，即重试最多占请求的 10% 左右
+class RetryBudget {
+public:
+    explicit RetryBudget(double ratio = 0.1, double minPerSecond = 10, double maxTokens = 100);
+
+    void onRequest();
+    // 取一个令牌，预算用完时返回 false
+    bool tryRetry();
+    double tokens() const { return tokens_.load(std::memory_order_relaxed) / static_cast<double>(kScale); }
+
+private:
+    static const int64_t kScale = 1000;     // 令牌按千分之一计数
+
+    void refill();
+
+    const int64_t          deposit_;
+    const int64_t          perSecond_;
+    const int64_t          max_;
+    std::atomic<int64_t>   tokens_;
+    std::atomic<int64_t>   lastRefillUs_;
+};
+
+#endif // _RETRYPOLICY_H_
@@ -3,6 +3,8 @@
 
 #include<google/protobuf/service.h>
 #include<string>
+#include<cstdint>
+#include "rpc.pb.h"
 //用于描述RPC调用的控制器
 //其主要作用是跟踪RPC方法调用的状态、错误信息并提供控制功能(如取消调用)。
 class RpcController: public google::protobuf::RpcController
@@ -13,6 +15,23 @@ public:
  bool Failed() const;
 std::string ErrorText() const;
 void SetFailed(const std::string &reason);
+//带状态码的失败，只调用 SetFailed(reason) 时状态码为 UNKNOWN；成功时为 OK
+void SetFailed(const std::string &reason, Krpc::StatusCode code);
+Krpc::StatusCode Status() const;
+//调用因超时失败（状态码 DEADLINE_EXCEEDED），供异常实例摘除区分超时和其他错误
+void SetTimedOut();
+bool TimedOut() const;
+
+//对任意 google::protobuf::RpcController 设置失败：是本类时同时记录状态码，controller 为空时什么也不做
+static void Fail(google::protobuf::RpcController* controller, const std::string &reason, Krpc::StatusCode code);
+//读取任意 controller 的状态码：为空或未失败时为 OK，不是本类时为 UNKNOWN
+static Krpc::StatusCode StatusOf(const google::protobuf::RpcController* controller);
+
+//一致性哈希负载均衡使用的 key，由调用方设置，ServiceDiscovery::pickHost 读取
+void SetHashKey(const std::string &key);
+void SetHashKey(uint64_t hash);
+bool HasHashKey() const;
+uint64_t HashKey() const;
 
 //目前未实现具体的功能
 void StartCancel();
@@ -21,6 +40,9 @@ void NotifyOnCancel(google::protobuf::Closure* callback);
 private:
  bool m_failed;//RPC方法执行过程中的状态
  std::string m_errText;//RPC方法执行过程中的错误信息
+ Krpc::StatusCode m_status;//失败时的状态码
+ bool m_hasHashKey;//是否设置了哈希 key
+ uint64_t m_hashKey;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,365 @@
+// RpcCoroutine.h
+// 可选的 C++20 协程接口：handler 写成 Task<Response>，可以 co_await 下游 RPC、
+// 线程池中的阻塞操作（如 MySQL 连接池）和定时器，挂起期间不占用任何线程，
+// 恢复时回到发起 co_await 的 IO 线程（EventLoop）。
+// 仅在以 -std=c++20 编译的目标中可用，库本身仍按 C++11 编译。
+#ifndef _RPCCOROUTINE_H_
+#define _RPCCOROUTINE_H_
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <coroutine>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <google/protobuf/service.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/base/ThreadPool.h>
+#include "Logger.h"
+#include "RpcFuture.h"
+#include "RpcController.h"
+
+namespace krpc {
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+// 在 loop 线程上恢复协程；不在任何 loop 上时（loop 为空）直接原地恢复
+inline void resumeOn(muduo::net::EventLoop* loop, std::coroutine_handle<> h) {
+    if (loop == nullptr || loop->isInLoopThread()) {
+        h.resume();
+    } else {
+        loop->queueInLoop([h]() { h.resume(); });
+    }
+}
+
+// 回调式操作的 awaiter 基类：回调可能在 await_suspend 返回前就同步触发，
+// 用一个原子标志决定由谁负责恢复协程（后到的一方负责）
+class CallbackAwaiterBase {
+public:
+    bool await_ready() const noexcept { return false; }
+
+protected:
+    // 在 await_suspend 中发起操作之前调用
+    void prepare(std::coroutine_handle<> h) {
+        handle_ = h;
+        loop_   = muduo::net::EventLoop::getEventLoopOfCurrentThread();
+    }
+    // 在 await_suspend 中发起操作之后调用，返回值即 await_suspend 的返回值
+    bool suspendIfPending() {
+        return !fired_.exchange(true, std::memory_order_acq_rel);
+    }
+    // 操作完成时调用（任意线程）
+    void complete() {
+        if (fired_.exchange(true, std::memory_order_acq_rel)) {
+            resumeOn(loop_, handle_);
+        }
+    }
+
+private:
+    std::coroutine_handle<>   handle_;
+    muduo::net::EventLoop*    loop_ = nullptr;
+    std::atomic<bool>         fired_{false};
+};
+
+template <typename T>
+struct ResultSlot {
+    std::optional<T> value;
+    template <typename F> void fill(F& fn) { value.emplace(fn()); }
+    T take() { return std::move(*value); }
+};
+
+template <>
+struct ResultSlot<void> {
+    template <typename F> void fill(F& fn) { fn(); }
+    void take() {}
+};
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr      exception_;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            std::coroutine_handle<> next = h.promise().continuation_;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() { exception_ = std::current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value_;
+
+    Task<T> get_return_object();
+    template <typename U>
+    void return_value(U&& v) { value_.emplace(std::forward<U>(v)); }
+    T result() {
+        if (exception_) std::rethrow_exception(exception_);
+        return std::move(*value_);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void result() {
+        if (exception_) std::rethrow_exception(exception_);
+    }
+};
+
+// 自驱动的顶层协程：立即开始执行，结束时自行销毁帧
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+} // namespace detail
+
+// 惰性启动的协程任务，被 co_await 时才开始执行，结束后通过对称转移恢复等待者
+template <typename T>
+class Task {
+public:
+    typedef detail::TaskPromise<T> promise_type;
+    typedef std::coroutine_handle<promise_type> handle_type;
+
+    Task() noexcept = default;
+    explicit Task(handle_type h) noexcept : handle_(h) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool valid() const noexcept { return static_cast<bool>(handle_); }
+
+    auto operator co_await() && noexcept {
+        // 无效的 Task（默认构造或已被移走）不挂起，在等待者中抛出 std::logic_error
+        struct Awaiter {
+            handle_type handle_;
+            bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle_.promise().continuation_ = awaiting;
+                return handle_;
+            }
+            T await_resume() {
+                if (!handle_) throw std::logic_error("co_await on an invalid Task");
+                return handle_.promise().result();
+            }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    handle_type handle_;
+};
+
+namespace detail {
+template <typename T>
+inline Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+template <typename Response>
+DetachedTask runHandler(Task<Response> task, google::protobuf::RpcController* controller,
+                        Response* response, google::protobuf::Closure* done) {
+    try {
+        *response = co_await std::move(task);
+    } catch (const std::exception& ex) {
+        LOG(ERROR) << "coroutine handler failed: " << ex.what();
+        RpcController::Fail(controller, std::string("handler failed: ") + ex.what(), Krpc::INTERNAL);
+    } catch (...) {
+        LOG(ERROR) << "coroutine handler failed with unknown exception";
+        RpcController::Fail(controller, "handler failed with unknown exception", Krpc::INTERNAL);
+    }
+    // 无论成功与否都要回包，避免客户端的 outstanding 调用永远挂起；失败时客户端收到 INTERNAL 和错误信息
+    done->Run();
+}
+
+inline DetachedTask runDetached(Task<void> task) {
+    try {
+        co_await std::move(task);
+    } catch (const std::exception& ex) {
+        LOG(ERROR) << "detached coroutine failed: " << ex.what();
+    } catch (...) {
+        LOG(ERROR) << "detached coroutine failed with unknown exception";
+    }
+}
+} // namespace detail
+
+// 服务端入口：在生成的 Service 虚函数里调用，把协程 handler 的结果写入 response 后执行 done
+//   void Login(RpcController* ctl, const LoginRequest* req, LoginResponse* rsp, Closure* done) override {
+//       krpc::serve(ctl, LoginCo(*req), rsp, done);
+//   }
+// request/response/controller 由 RPCChannel 持有到 done->Run() 为止，handler 可以按引用接收 request。
+// handler 抛出异常时以 INTERNAL 失败；需要返回其他错误的 handler 可以持有 controller 自行 SetFailed
+template <typename Response>
+void serve(google::protobuf::RpcController* controller, Task<Response> task,
+           Response* response, google::protobuf::Closure* done) {
+    detail::runHandler(std::move(task), controller, response, done);
+}
+
+// 启动一个不关心结果的协程
+inline void spawn(Task<void> task) {
+    detail::runDetached(std::move(task));
+}
+
+// co_await 任意以 Closure* 结尾的回调式调用，典型用法是生成的 Stub：
+//   co_await krpc::rpcCall([&](google::protobuf::Closure* done) {
+//       stub.Login(&ctl, &req, &rsp, done);
+//   });
+// 回调在 channel 的 IO 线程触发，协程在发起调用的 loop 上恢复
+class ClosureAwaiter : public detail::CallbackAwaiterBase {
+public:
+    typedef std::function<void(google::protobuf::Closure*)> IssueFunc;
+
+    explicit ClosureAwaiter(IssueFunc issue) : issue_(std::move(issue)) {}
+
+    bool await_suspend(std::coroutine_handle<> h) {
+        prepare(h);
+        issue_(google::protobuf::NewCallback(this, &ClosureAwaiter::onDone));
+        return suspendIfPending();
+    }
+    void await_resume() const noexcept {}
+
+private:
+    void onDone() { complete(); }
+
+    IssueFunc issue_;
+};
+
+inline ClosureAwaiter rpcCall(ClosureAwaiter::IssueFunc issue) {
+    return ClosureAwaiter(std::move(issue));
+}
+
+// 直接 co_await 一个 Future：成功时得到 shared_ptr<T>，失败时抛出 RpcError
+//   std::shared_ptr<LoginResponse> rsp = co_await krpc::callAsync(stub, &Stub::Login, req);
+// 无效的 Future 视为已失败，不挂起，同样抛出 RpcError
+template <typename T>
+class FutureAwaiter : public detail::CallbackAwaiterBase {
+public:
+    explicit FutureAwaiter(Future<T> future) : future_(std::move(future)) {}
+
+    bool await_ready() const { return future_.ready(); }
+    bool await_suspend(std::coroutine_handle<> h) {
+        prepare(h);
+        future_.onComplete([this](const Future<T>&) { complete(); });
+        return suspendIfPending();
+    }
+    std::shared_ptr<T> await_resume() {
+        if (!future_.valid()) {
+            throw RpcError("co_await on an invalid future");
+        }
+        if (future_.failed()) {
+            throw RpcError(future_.errorText());
+        }
+        return future_.value();
+    }
+
+private:
+    Future<T> future_;
+};
+
+template <typename T>
+FutureAwaiter<T> operator co_await(Future<T> future) {
+    return FutureAwaiter<T>(std::move(future));
+}
+
+// 把阻塞操作（获取 DB 连接、执行 SQL 等）丢到线程池执行，完成后回到原 loop 恢复，
+// IO 线程在此期间可以继续处理其他请求
+template <typename F>
+class PoolAwaiter : public detail::CallbackAwaiterBase {
+public:
+    typedef typename std::invoke_result<F&>::type result_type;
+
+    PoolAwaiter(muduo::ThreadPool& pool, F fn) : pool_(pool), fn_(std::move(fn)) {}
+
+    bool await_suspend(std::coroutine_handle<> h) {
+        prepare(h);
+        pool_.run([this]() {
+            try {
+                slot_.fill(fn_);
+            } catch (...) {
+                exception_ = std::current_exception();
+            }
+            complete();
+        });
+        return suspendIfPending();
+    }
+    result_type await_resume() {
+        if (exception_) std::rethrow_exception(exception_);
+        return slot_.take();
+    }
+
+private:
+    muduo::ThreadPool&              pool_;
+    F                               fn_;
+    detail::ResultSlot<result_type> slot_;
+    std::exception_ptr              exception_;
+};
+
+template <typename F>
+PoolAwaiter<F> runIn(muduo::ThreadPool& pool, F fn) {
+    return PoolAwaiter<F>(pool, std::move(fn));
+}
+
+// 在当前 loop 上挂起 seconds 秒；不在 loop 线程上时立即返回
+class SleepAwaiter {
+public:
+    explicit SleepAwaiter(double seconds) : seconds_(seconds) {}
+
+    bool await_ready() const noexcept { return seconds_ <= 0; }
+    bool await_suspend(std::coroutine_handle<> h) {
+        muduo::net::EventLoop* loop = muduo::net::EventLoop::getEventLoopOfCurrentThread();
+        if (loop == nullptr) {
+            return false;
+        }
+        loop->runAfter(seconds_, [h]() { h.resume(); });
+        return true;
+    }
+    void await_resume() const noexcept {}
+
+private:
+    double seconds_;
+};
+
+inline SleepAwaiter sleepFor(double seconds) {
+    return SleepAwaiter(seconds);
+}
+
+} // namespace krpc
+
+#endif // __cpp_impl_coroutine
+
+#endif // _RPCCOROUTINE_H_
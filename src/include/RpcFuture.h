@@ -0,0 +1,380 @@
+// RpcFuture.h
+// 基于 RPCChannel 的 Future 风格客户端接口，以及 then / whenAll / whenAny 组合子。
+// 续体（continuation）直接在完成 Future 的线程上执行——对 RPC 调用而言就是
+// channel 所在的 IO 线程，不会额外切换线程；若 then 时 Future 已完成，则在调用线程上立即执行。
+#ifndef _RPCFUTURE_H_
+#define _RPCFUTURE_H_
+
+#include <google/protobuf/service.h>
+#include <google/protobuf/descriptor.h>
+#include "RpcController.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace krpc {
+
+// RPC 失败时由协程接口抛出
+class RpcError : public std::runtime_error {
+public:
+    explicit RpcError(const std::string& what) : std::runtime_error(what) {}
+};
+
+// then 的续体返回 void 时，下游 Future 的值类型
+struct Unit {};
+
+template <typename T> class Future;
+template <typename T> class Promise;
+
+namespace detail {
+
+// 回调只在完成时拿到 Future，不在 callbacks 里持有指回自身的 Future：
+// Promise 被丢弃、永远不完成时，state 连同回调一起释放
+template <typename T>
+struct FutureState {
+    std::mutex                                           mutex;
+    bool                                                 done   = false;
+    bool                                                 failed = false;
+    std::string                                          error;
+    std::shared_ptr<T>                                   value;
+    std::vector<std::function<void(const Future<T>&)>>   callbacks;
+};
+
+template <typename T, typename F>
+struct ThenResult;
+
+inline const char* invalidFutureError() { return "invalid (default-constructed) future"; }
+
+} // namespace detail
+
+// 默认构造的 Future 没有关联的 Promise（valid() 为 false），视为已经失败：
+// then / whenAll 等照常完成，不会永远等下去
+template <typename T>
+class Future {
+public:
+    typedef T value_type;
+
+    Future() = default;
+
+    bool valid() const { return static_cast<bool>(state_); }
+
+    bool ready() const {
+        if (!state_) return true;
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->done;
+    }
+    bool failed() const {
+        if (!state_) return true;
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->done && state_->failed;
+    }
+    std::string errorText() const {
+        if (!state_) return detail::invalidFutureError();
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->error;
+    }
+    // 未完成或失败时返回空指针
+    std::shared_ptr<T> value() const {
+        if (!state_) return std::shared_ptr<T>();
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->value;
+    }
+
+    // 完成（成功或失败）时回调，回调参数为已完成的 Future 本身
+    void onComplete(std::function<void(const Future<T>&)> cb) const {
+        if (state_) {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (!state_->done) {
+                state_->callbacks.push_back(std::move(cb));
+                return;
+            }
+        }
+        cb(*this);
+    }
+
+    // 续体 f 接收已完成的 Future<T>，返回值决定下游 Future 类型：
+    //   void -> Future<Unit>；Future<U> -> Future<U>（自动展开，用于串联依赖调用）；U -> Future<U>
+    // f 抛出的异常会使下游 Future 失败
+    template <typename F>
+    Future<typename detail::ThenResult<T, F>::type> then(F f) const;
+
+private:
+    template <typename U> friend class Promise;
+    explicit Future(const std::shared_ptr<detail::FutureState<T>>& state) : state_(state) {}
+
+    std::shared_ptr<detail::FutureState<T>> state_;
+};
+
+template <typename T>
+class Promise {
+public:
+    Promise() : state_(std::make_shared<detail::FutureState<T>>()) {}
+
+    Future<T> getFuture() const { return Future<T>(state_); }
+
+    // 只有第一次设置生效，返回是否由本次调用完成了 Future
+    bool setValue(std::shared_ptr<T> value) const { return complete(false, std::string(), std::move(value)); }
+    bool setFailed(const std::string& reason) const { return complete(true, reason, std::shared_ptr<T>()); }
+    // 把另一个已完成 Future 的结果转交给本 Promise
+    bool setFrom(const Future<T>& other) const {
+        return other.failed() ? setFailed(other.errorText()) : setValue(other.value());
+    }
+
+private:
+    bool complete(bool failed, const std::string& reason, std::shared_ptr<T> value) const {
+        std::vector<std::function<void(const Future<T>&)>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (state_->done) {
+                return false;
+            }
+            state_->done   = true;
+            state_->failed = failed;
+            state_->error  = reason;
+            state_->value  = std::move(value);
+            callbacks.swap(state_->callbacks);
+        }
+        Future<T> self(state_);
+        for (size_t i = 0; i < callbacks.size(); ++i) {
+            callbacks[i](self);
+        }
+        return true;
+    }
+
+    std::shared_ptr<detail::FutureState<T>> state_;
+};
+
+template <typename T>
+Future<T> makeReadyFuture(std::shared_ptr<T> value) {
+    Promise<T> promise;
+    promise.setValue(std::move(value));
+    return promise.getFuture();
+}
+
+template <typename T>
+Future<T> makeFailedFuture(const std::string& reason) {
+    Promise<T> promise;
+    promise.setFailed(reason);
+    return promise.getFuture();
+}
+
+namespace detail {
+
+// 根据续体返回类型 R 决定如何完成下游 Promise
+template <typename R>
+struct ThenInvoker {
+    typedef R type;
+    template <typename F, typename T>
+    static void invoke(F& f, const Future<T>& in, const Promise<R>& out) {
+        out.setValue(std::make_shared<R>(f(in)));
+    }
+};
+
+template <>
+struct ThenInvoker<void> {
+    typedef Unit type;
+    template <typename F, typename T>
+    static void invoke(F& f, const Future<T>& in, const Promise<Unit>& out) {
+        f(in);
+        out.setValue(std::make_shared<Unit>());
+    }
+};
+
+template <typename U>
+struct ThenInvoker<Future<U>> {
+    typedef U type;
+    template <typename F, typename T>
+    static void invoke(F& f, const Future<T>& in, const Promise<U>& out) {
+        Future<U> inner = f(in);
+        if (!inner.valid()) {
+            out.setFailed("continuation returned an invalid future");
+            return;
+        }
+        inner.onComplete([out](const Future<U>& done) { out.setFrom(done); });
+    }
+};
+
+template <typename T, typename F>
+struct ThenResult {
+    typedef decltype(std::declval<F&>()(std::declval<const Future<T>&>())) result_type;
+    typedef ThenInvoker<result_type> invoker;
+    typedef typename invoker::type type;
+};
+
+} // namespace detail
+
+template <typename T>
+template <typename F>
+Future<typename detail::ThenResult<T, F>::type> Future<T>::then(F f) const {
+    typedef typename detail::ThenResult<T, F>::invoker Invoker;
+    typedef typename detail::ThenResult<T, F>::type U;
+    Promise<U> next;
+    onComplete([f, next](const Future<T>& done) mutable {
+        try {
+            Invoker::invoke(f, done, next);
+        } catch (const std::exception& ex) {
+            next.setFailed(ex.what());
+        } catch (...) {
+            next.setFailed("unknown exception in continuation");
+        }
+    });
+    return next.getFuture();
+}
+
+// 所有 Future 完成（无论成败）后完成，结果按输入顺序给出，由调用方逐个检查 failed()。
+// 各输入的回调只持有结果槽位，完成时把回调拿到的 Future 写进自己的槽位，不持有输入本身：
+// 某个输入永远不完成时，丢弃它的 Promise 就能释放整个组合
+template <typename T>
+Future<std::vector<Future<T>>> whenAll(const std::vector<Future<T>>& futures) {
+    typedef std::vector<Future<T>> Result;
+    Promise<Result> promise;
+    std::shared_ptr<Result> slots = std::make_shared<Result>(futures.size());
+    if (futures.empty()) {
+        promise.setValue(slots);
+        return promise.getFuture();
+    }
+    std::shared_ptr<std::atomic<size_t>> remaining = std::make_shared<std::atomic<size_t>>(futures.size());
+    for (size_t i = 0; i < futures.size(); ++i) {
+        futures[i].onComplete([promise, slots, remaining, i](const Future<T>& done) {
+            (*slots)[i] = done;
+            if (remaining->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                promise.setValue(slots);
+            }
+        });
+    }
+    return promise.getFuture();
+}
+
+namespace detail {
+// C++11 没有 std::index_sequence
+template <size_t... Is> struct IndexSeq {};
+template <size_t N, size_t... Is> struct MakeIndexSeq : MakeIndexSeq<N - 1, N - 1, Is...> {};
+template <size_t... Is> struct MakeIndexSeq<0, Is...> { typedef IndexSeq<Is...> type; };
+
+template <size_t I, typename Result, typename T>
+int attachSlot(const Future<T>& future, const Promise<Result>& promise, const std::shared_ptr<Result>& slots,
+               const std::shared_ptr<std::atomic<size_t>>& remaining) {
+    future.onComplete([promise, slots, remaining](const Future<T>& done) {
+        std::get<I>(*slots) = done;
+        if (remaining->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            promise.setValue(slots);
+        }
+    });
+    return 0;
+}
+
+template <typename Result, size_t... Is, typename... Ts>
+void attachSlots(IndexSeq<Is...>, const Promise<Result>& promise, const std::shared_ptr<Result>& slots,
+                 const std::shared_ptr<std::atomic<size_t>>& remaining, const Future<Ts>&... futures) {
+    int expand[] = {0, attachSlot<Is>(futures, promise, slots, remaining)...};
+    (void)expand;
+}
+} // namespace detail
+
+// 异构版本：whenAll(loginFuture, registerFuture) -> Future<tuple<Future<A>, Future<B>>>
+template <typename... Ts>
+Future<std::tuple<Future<Ts>...>> whenAll(const Future<Ts>&... futures) {
+    typedef std::tuple<Future<Ts>...> Result;
+    Promise<Result> promise;
+    std::shared_ptr<Result> slots = std::make_shared<Result>();
+    if (sizeof...(Ts) == 0) {
+        promise.setValue(slots);
+        return promise.getFuture();
+    }
+    std::shared_ptr<std::atomic<size_t>> remaining = std::make_shared<std::atomic<size_t>>(sizeof...(Ts));
+    detail::attachSlots(typename detail::MakeIndexSeq<sizeof...(Ts)>::type(), promise, slots, remaining,
+                        futures...);
+    return promise.getFuture();
+}
+
+// 第一个完成（无论成败）的 Future 及其下标
+template <typename T>
+Future<std::pair<size_t, Future<T>>> whenAny(const std::vector<Future<T>>& futures) {
+    typedef std::pair<size_t, Future<T>> Result;
+    Promise<Result> promise;
+    if (futures.empty()) {
+        promise.setFailed("whenAny called with no futures");
+        return promise.getFuture();
+    }
+    for (size_t i = 0; i < futures.size(); ++i) {
+        futures[i].onComplete([promise, i](const Future<T>& done) {
+            promise.setValue(std::make_shared<Result>(i, done));
+        });
+    }
+    return promise.getFuture();
+}
+
+namespace detail {
+
+// 连接 CallMethod 与 Promise 的一次性 Closure。
+// 约定与 RPCChannel 一致：未完成的调用在 channel 析构时 response/done 会被直接 delete，
+// 此时析构函数负责把 Future 置为失败；response 在此之前归 channel 所有
+template <typename Response>
+class PromiseClosure : public google::protobuf::Closure {
+public:
+    PromiseClosure() : response_(new Response), ran_(false) {}
+    ~PromiseClosure() override {
+        if (!ran_) {
+            promise_.setFailed("rpc channel destroyed with call outstanding");
+        }
+    }
+
+    void Run() override {
+        ran_ = true;
+        std::shared_ptr<Response> response(response_);
+        if (controller_.Failed()) {
+            promise_.setFailed(controller_.ErrorText());
+        } else {
+            promise_.setValue(response);
+        }
+        delete this;
+    }
+
+    Response*          response()   { return response_; }
+    RpcController*     controller() { return &controller_; }
+    Future<Response>   future() const { return promise_.getFuture(); }
+
+private:
+    Promise<Response>  promise_;
+    Response*          response_;
+    RpcController      controller_;
+    bool               ran_;
+};
+
+} // namespace detail
+
+// 通过任意 RpcChannel（通常是 RPCChannel）发起调用，request 在调用返回前即已序列化
+template <typename Response>
+Future<Response> callAsync(google::protobuf::RpcChannel* channel,
+                           const google::protobuf::MethodDescriptor* method,
+                           const google::protobuf::Message& request) {
+    detail::PromiseClosure<Response>* done = new detail::PromiseClosure<Response>;
+    Future<Response> future = done->future();
+    channel->CallMethod(method, done->controller(), &request, done->response(), done);
+    return future;
+}
+
+// 通过生成的 Stub 发起调用：
+//   auto f = krpc::callAsync(stub, &Kuser::UserServiceRpc_Stub::Login, request);
+template <typename Stub, typename StubClass, typename Request, typename Response>
+Future<Response> callAsync(Stub& stub,
+                           void (StubClass::*method)(google::protobuf::RpcController*,
+                                                     const Request*, Response*,
+                                                     google::protobuf::Closure*),
+                           const Request& request) {
+    detail::PromiseClosure<Response>* done = new detail::PromiseClosure<Response>;
+    Future<Response> future = done->future();
+    (stub.*method)(done->controller(), &request, done->response(), done);
+    return future;
+}
+
+} // namespace krpc
+
+#endif // _RPCFUTURE_H_
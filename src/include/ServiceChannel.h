@@ -0,0 +1,83 @@
+// ServiceChannel.h
+#ifndef _SERVICECHANNEL_H_
+#define _SERVICECHANNEL_H_
+
+#include <google/protobuf/service.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ClientChannel.h"
+#include "RetryPolicy.h"
+#include "ServiceDiscovery.h"
+
+// 按 service 调用的 RpcChannel，交给 Stub 使用，可被任意线程共享：
+// 每次调用通过 ServiceDiscovery 选取实例、从 ChannelPool 取共享连接，调用方不再自己 pickEndpoint。
+// 失败时按该方法的 RetryPolicy 重试——只重试幂等方法、只重试可重试的状态码、每次换一个没试过的实例，
+// 间隔指数退避，并受 RetryBudget 限制。同步调用在调用线程上等待退避，异步调用用 ClientRuntime 的定时器。
+// 只读方法可以改为设置 HedgingPolicy：第一份请求迟迟没有结果时向另一个实例再发一份，先到的为准。
+// RpcController 带哈希 key 时按 key 选取（一致性哈希策略下重试会落到列表中的下一个实例）
+class ServiceChannel : public ::google::protobuf::RpcChannel {
+public:
+    explicit ServiceChannel(const std::string& service);
+
+    // 未单独设置的方法使用默认策略；默认策略不重试（maxAttempts = 1）。可以在运行中修改
+    void setDefaultRetryPolicy(const RetryPolicy& policy);
+    void setRetryPolicy(const std::string& method, const RetryPolicy& policy);
+    // 预算默认每个 ServiceChannel 一个；多个 ServiceChannel 设置同一个即共享预算。需在第一次调用前设置
+    void setRetryBudget(const std::shared_ptr<RetryBudget>& budget) { budget_ = budget; }
+    const std::shared_ptr<RetryBudget>& retryBudget() const { return budget_; }
+
+    // 对冲策略按方法设置，默认不对冲；设置后该方法不再按 RetryPolicy 重试。可以在运行中修改
+    void setHedgingPolicy(const std::string& method, const HedgingPolicy& policy);
+    // 对冲预算，与重试预算分开计算：每个对冲调用存入令牌，每多发一份取一个。需在第一次调用前设置
+    void setHedgingBudget(const std::shared_ptr<RetryBudget>& budget) { hedgeBudget_ = budget; }
+    const std::shared_ptr<RetryBudget>& hedgingBudget() const { return hedgeBudget_; }
+
+    const std::string& service() const { return service_; }
+
+    void CallMethod(const ::google::protobuf::MethodDescriptor* method,
+                    ::google::protobuf::RpcController* controller,
+                    const ::google::protobuf::Message* request,
+                    ::google::protobuf::Message* response,
+                    ::google::protobuf::Closure* done) override;
+
+private:
+    // 方法第一次调用时解析，策略修改后重新生成；进行中的调用持有旧的一份
+    struct MethodState {
+        ServiceKey   key;
+        std::string  name;           // "service/method"，用于日志
+        RetryPolicy  policy;
+        bool         idempotent;     // policy.idempotent 或 proto 中声明的 idempotency_level
+        bool         hedged;         // 设置了对冲策略且方法只读
+        HedgingPolicy                      hedging;
+        std::shared_ptr<LatencyHistogram>  latency;    // 该方法的延迟分布，策略修改后保留
+    };
+    typedef std::shared_ptr<const MethodState> MethodStatePtr;
+    class AsyncCall;
+    class HedgedCall;
+
+    MethodStatePtr methodState(const ::google::protobuf::MethodDescriptor* method);
+    // 选取实例并取连接，重试时排除 tried 中的实例并清掉上一次的结果；没有可选实例时返回空
+    static ClientChannelPtr pickChannel(const MethodState& state, int attempt,
+                                        ::google::protobuf::RpcController* controller,
+                                        ::google::protobuf::Message* response,
+                                        std::vector<std::string>* tried);
+    static bool shouldRetry(const MethodState& state, RetryBudget* budget,
+                            const ::google::protobuf::RpcController* controller, int attempts);
+
+    std::string                                 service_;
+    std::shared_ptr<RetryBudget>                budget_;
+    std::shared_ptr<RetryBudget>                hedgeBudget_;
+    std::mutex                                  mutex_;
+    RetryPolicy                                 defaultPolicy_;
+    std::unordered_map<std::string, RetryPolicy>                                policies_;
+    std::unordered_map<std::string, HedgingPolicy>                              hedgingPolicies_;
+    std::unordered_map<const ::google::protobuf::MethodDescriptor*, std::shared_ptr<LatencyHistogram>> latencies_;
+    std::unordered_map<const ::google::protobuf::MethodDescriptor*, MethodStatePtr> states_;
+};
+
+#endif // _SERVICECHANNEL_H_
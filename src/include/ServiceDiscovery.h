@@ -7,11 +7,17 @@
 #include <iostream>
 #include <string>
 #include <mutex>
+#include <map>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "Zookeeperutil.h"
 #include "Logger.h"
+#include "Endpoint.h"
+#include "LoadBalancer.h"
+#include "OutlierDetector.h"
+#include "RpcController.h"
 
 //#include <muduo/net/Callbacks.h>
 //#include <muduo/net/Buffer.h>
@@ -20,48 +26,327 @@
 #include <random>
 #include <queue>
 #include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// 一次成员变化：某个 service/method 的实例增减，以及属性（权重、zone、版本）变化
+struct MembershipChange {
+    std::string               key;       // "service/method"
+    EndpointList              added;
+    EndpointList              removed;
+    EndpointList              updated;
+    // 随本次变化不再属于任何已订阅方法的 ip:port，可以回收其连接
+    std::vector<std::string>  gone;
+};
+typedef std::function<void(const MembershipChange&)> MembershipListener;
+
+// 预先解析好的 "service/method"，热路径上按它选取，省掉每次拼接和查找字符串
+class ServiceKey {
+public:
+    ServiceKey() : id_(kInvalid) {}
+    bool valid() const { return id_ != kInvalid; }
+
+private:
+    friend class ServiceDiscovery;
+    static const uint32_t kInvalid = 0xffffffffu;
+    explicit ServiceKey(uint32_t id) : id_(id) {}
+
+    uint32_t id_;
+};
+
 // 伪代码示例
 class ServiceDiscovery {
 public:
 
     static ServiceDiscovery& instance();
     void init(const std::string& host, const std::string& port);
+    // prefetch：启动时就订阅的 "service/method"、"service"（其下所有方法）或 "*"（整棵树）
+    void init(const std::string& host, const std::string& port, const std::vector<std::string>& prefetch);
     std::string pickHost(const std::string& service, const std::string& method);
+    // 带上下文的选取：一致性哈希策略按 ctx / controller 中的哈希 key 选实例
+    std::string pickHost(const std::string& service, const std::string& method, const PickContext& ctx);
+    std::string pickHost(const std::string& service, const std::string& method, const RpcController& controller);
+
+    // 热路径接口：先 resolve 一次拿到 key，之后每次 pickEndpoint 不加锁、不分配内存。
+    // 返回的引用指向当前线程持有的缓存快照，在本线程下一次 pickEndpoint / pickHost 之前有效；
+    // 没有可用实例时抛出 std::runtime_error
+    // 第一次 resolve 某个 key 时同步从 ZooKeeper 拉取并注册 watcher（其他线程正在拉取同一 key 时等它完成）；
+    // 在成员变化回调中 resolve 新的 key 不等待，拉取完成前 pickEndpoint 可能找不到实例
+    ServiceKey resolve(const std::string& service, const std::string& method);
+    const Endpoint& pickEndpoint(const ServiceKey& key, const PickContext& ctx = PickContext());
+    // 重试用：排除 excluded 中的 hostPort 后选取，先按原策略重选，仍落在排除的实例上时顺序查找；
+    // 没有其他实例时返回 nullptr（不抛异常）。返回的指针有效期同 pickEndpoint
+    const Endpoint* pickEndpointExcept(const ServiceKey& key, const PickContext& ctx,
+                                       const std::vector<std::string>& excluded);
+
     std::string QueryServiceHost(ZkClient* zkclient, const std::string& service_name,
                                  const std::string& method_name, int &idx);
 
+    // 负载均衡策略，名字见 LoadBalancer::create；按 service 设置，未设置的 service 用默认策略（random）。
+    // 可以在运行中切换，未知策略名返回 false
+    bool setBalancer(const std::string& service, const std::string& policy);
+    bool setDefaultBalancer(const std::string& policy);
+
+    // 就近路由：设置本进程所在的可用区后，只在同可用区的实例中选取；本可用区健康实例的比例低于
+    // minHealthyFraction，或平均利用率高于 maxUtilization 时，改为在全部实例中选取（溢出到其他可用区）。
+    // 利用率是在途数 / 实例声明的 max_concurrency，没有声明时用服务端上报的 CPU 利用率。
+    // zone 为空表示关闭（默认），可以在运行中修改
+    void setLocalZone(const std::string& zone);
+    void setZoneSpillover(double minHealthyFraction, double maxUtilization);
+
+    // 慢启动窗口（秒）：首次拉取之后新加入或重启（start_time_ms 变化）的实例，在窗口内分到的流量
+    // 从 10% 线性增加到正常份额，避免冷缓存、空连接池的实例一上线就承担全部份额。
+    // 带哈希 key 的选取不受影响。默认 0（关闭），可以在运行中修改
+    void setSlowStartWindow(double seconds);
+
+    // 异常实例摘除与熔断（见 OutlierDetector.h），默认开启；阈值设为 0 关闭对应的检测
+    void setOutlierDetection(const OutlierDetector::Options& options);
+    OutlierDetector::Options outlierDetection() const { return outlier_.options(); }
+
+    // watcher 事件合并窗口（秒）：同一方法在窗口内的多次变化（如批量发布时实例逐个上下线）
+    // 只触发一次重新拉取；0 表示收到事件立即拉取（连续事件仍会在排队期间合并）
+    void setWatchDebounce(double seconds);
+
+    struct WatchStats {
+        uint64_t events;       // 收到的 watcher 事件数
+        uint64_t coalesced;    // 被合并掉的事件数
+        uint64_t refreshes;    // 实际发起的重新拉取次数
+        int64_t  lastLagUs;    // 最近一次从收到第一个事件到新列表发布的延迟
+        int64_t  maxLagUs;     // 上述延迟的最大值
+    };
+    WatchStats watchStats() const;
+
+    // 本地快照文件（格式见 DiscoverySnapshot.h）：设置后 init 先从文件加载实例列表、不等 ZooKeeper 连上就返回，
+    // 连上后再逐个方法刷新；之后每次列表变化都写回文件。需在 init 之前设置，默认不使用
+    void setSnapshotPath(const std::string& path);
+    // 没有可用快照时 init 等待 ZooKeeper 连接的最长时间（秒），默认 5s；超时后 init 照常返回，后台继续重连
+    void setConnectTimeout(double seconds);
+
+    // watcher 处理线程数，需在 init 之前设置，默认 min(4, CPU 核数)。
+    // 事件按 "service/method" 哈希到固定线程，同一方法的刷新严格按顺序处理，不同方法之间并行
+    void setWatchWorkers(int n);
+
+    // 成员变化监听：实例列表刷新后按差量回调（在该方法所属的 watcher 线程上、锁外执行，应尽快返回）。
+    // 列表没有变化时不回调；返回的 id 用于注销
+    int addMembershipListener(MembershipListener listener);
+    void removeMembershipListener(int id);
+
+    // 某个 endpoint 的运行时统计（不存在则创建），调用方在调用开始/结束时回填，
+    // ChannelPool 创建的连接会自动回填
+    EndpointStatsPtr endpointStats(const std::string& hostPort);
+
 private:
     // watcher 回调（符合 C API 签名）
     static void zkWatcher(zhandle_t* zh, int type,  int state, const char* path, void* ctx);
 
-    // 真正处理事件：path 变更后，重新拉取对应节点，更新 cache_
-    void handleEvent(const std::string& path, int type);
+    // 合并后的一次待刷新
+    struct PendingRefresh {
+        std::string service;
+        std::string method;
+        int64_t     firstEventUs;   // 窗口内第一个事件到达的时间
+        int64_t     dueUs;          // 到期后才发起拉取
+        int         events;         // 窗口内合并的事件数
+    };
+    // 真正处理事件：合并窗口到期后重新拉取对应方法节点，更新缓存
+    void handleEvent(const PendingRefresh& refresh);
+    static int64_t steadyNowUs();
+    static constexpr double kDefaultWatchDebounce = 0.05;   // 秒
+    typedef std::pair<std::string, std::string> MethodName;   // (service, method)
+    // 首次订阅一批方法：并发发起拉取并等待全部完成（有超时），已订阅的跳过，
+    // 其他线程正在拉取的 key 等那次拉取完成
+    struct Subscription;
+    void subscribe(const std::vector<MethodName>& methods);
+    void startSubscription(const std::shared_ptr<Subscription>& sub, const std::vector<MethodName>& todo);
+    void waitSubscription(const std::shared_ptr<Subscription>& sub);
+    void finishSubscription(const std::shared_ptr<Subscription>& sub);
+    // 异步拉取方法节点下的实例并注册 watcher：子节点和各实例数据的读取在同一会话上流水线发出，
+    // 全部返回后交给该方法所属的 watcher 线程写入缓存，再执行 done
+    struct MethodFetch;
+    void fetchMethodAsync(const std::string& service, const std::string& method, std::function<void()> done);
+    void finishFetch(const std::shared_ptr<MethodFetch>& fetch);
+    // 新布局：拉取 /service/instances 下的全部实例（每个 server 一个节点，数据中列出提供的方法），
+    // 在本地按方法展开、与旧布局方法节点下的实例合并后更新该 service 下所有已订阅的方法；
+    // 节点不存在时只用旧布局
+    void fetchServiceAsync(const std::string& service, std::function<void()> done);
+    void fetchDataAsync(const std::shared_ptr<MethodFetch>& fetch, const std::vector<std::string>& paths);
+    void fallbackToMethods(const std::shared_ptr<MethodFetch>& fetch);
+    void applyInstances(const std::shared_ptr<MethodFetch>& fetch);
+    void applyMethodHosts(const std::shared_ptr<MethodFetch>& fetch);
+    // 一个 server 实例：data 已去掉 methods 属性，与旧布局下单个方法节点中的实例数据一致
+    struct InstanceInfo {
+        std::string              data;
+        std::vector<std::string> methods;
+    };
+    struct ServiceInstances {
+        ServiceInstances() : seq(0) {}
+        uint64_t                  seq;
+        std::vector<InstanceInfo> instances;
+    };
+    // 旧布局一个方法节点下最近一次拉到的实例数据
+    struct LegacyMethod {
+        LegacyMethod() : seq(0) {}
+        uint64_t                  seq;      // 0 表示首次拉取还没返回
+        std::vector<std::string>  hosts;
+    };
+    static std::vector<std::string> methodHosts(const ServiceInstances& service, const std::string& method);
+    std::vector<std::string> mergedHostsLocked(const std::string& service, const std::string& key);
+    // 解析实例数据，忽略非法和重复的实例
+    EndpointList parseHosts(const std::string& key, const std::vector<std::string>& hosts);
+    // 用新拉到的实例列表替换 key 对应的缓存，并重建其负载均衡器；seq 比已应用的旧时丢弃
+    void updateHosts(const std::string& service, const std::string& key,
+                     const std::vector<std::string>& hosts, uint64_t seq);
+
+    struct ServiceEntry {
+        std::string      key;         // "service/method"
+        std::string      service;
+        EndpointList     endpoints;
+        LoadBalancerPtr  balancer;    // 只对本 entry 的 endpoints 做过 rebuild，发布后不再修改
+        // 与本地可用区相同的实例及其负载均衡器；没有设置本地可用区、或所有实例都在本地时为空
+        EndpointList     localEndpoints;
+        LoadBalancerPtr  localBalancer;
+        int64_t          newestSlowStartUs;   // endpoints 中最晚的 slowStartUs，0 表示都不需要慢启动
+    };
+    typedef std::shared_ptr<const ServiceEntry> ServiceEntryPtr;
+    // 发布后只读的缓存快照，按 ServiceKey 的 id 下标访问
+    struct Snapshot {
+        std::vector<ServiceEntryPtr> entries;
+    };
+    typedef std::shared_ptr<const Snapshot> SnapshotPtr;
+
+    static void diffEndpoints(const EndpointList& before, EndpointList& after, MembershipChange* change);
+    // 本可用区的实例是否不足以承接流量，需要溢出到其他可用区
+    bool shouldSpill(const EndpointList& local) const;
+    // 慢启动：选中预热中的实例时按比例接受，不接受则重新选取
+    size_t slowStartPick(const EndpointList& endpoints, LoadBalancer* balancer, const PickContext& ctx,
+                         size_t idx, int64_t windowUs);
+    // 在 entry 上按策略选取（含就近路由、慢启动和异常摘除），entry 的实例列表不能为空
+    const Endpoint& pickFrom(const ServiceEntry& entry, const PickContext& ctx);
+    // 选中被摘除的实例时改选其他实例；被摘除的比例超过上限时照常使用
+    size_t outlierPick(const EndpointList& endpoints, LoadBalancer* balancer, const PickContext& ctx, size_t idx);
+    // 周期性做延迟异常检测
+    void runOutlierSweeps();
+
+    // 以下调用方需持有 cache_mutex_
+    LoadBalancerPtr newBalancer(const std::string& service);
+    uint32_t keyIdLocked(const std::string& key);
+    ServiceEntryPtr makeEntryLocked(const std::string& key, const std::string& service,
+                                    const EndpointList& endpoints);
+    // 在当前快照的基础上替换若干 entry，生成并发布新快照
+    void publishLocked(const std::vector<std::pair<uint32_t, ServiceEntryPtr>>& changes);
+    // 策略或可用区设置变化后，为满足 match 的 entry 重新生成 balancer 并发布
+    void rebuildEntriesLocked(const std::function<bool(const ServiceEntry&)>& match);
+
+    // 读端：当前线程缓存的快照，版本号变化时才重新加载
+    const SnapshotPtr& currentSnapshot();
+
+    // 本地快照：启动时加载，返回加载的方法数；列表变化后写回
+    size_t loadSnapshot();
+    void persistSnapshot();
+    // ZooKeeper（重新）连上时刷新还没和 ZooKeeper 对上的方法
+    void onZkConnected();
 private:
-    ServiceDiscovery(): worker_(&ServiceDiscovery::processEvents, this), stop_(false){}
+    ServiceDiscovery(): snapshot_(std::make_shared<Snapshot>()), version_(1), nextFetchSeq_(0), nextListenerId_(0),
+                        connectTimeout_(kDefaultConnectTimeout), persistedVersion_(0),
+                        zoneMinHealthy_(kDefaultZoneMinHealthy), zoneMaxUtilization_(kDefaultZoneMaxUtilization),
+                        slowStartWindowUs_(0), outlierStop_(false),
+                        eventCount_(0), coalescedCount_(0), refreshCount_(0), lastLagUs_(0), maxLagUs_(0),
+                        debounceUs_(static_cast<int64_t>(kDefaultWatchDebounce * 1000 * 1000)),
+                        workerCount_(0), workersStarted_(false){}
     ~ServiceDiscovery() {
-        {
-            std::lock_guard<std::mutex> lk(queueMtx_);
-            stop_ = true;
-        }
-        queueCv_.notify_one();
-        worker_.join();
+        // 先关闭会话：zookeeper_close 返回时 C 客户端的线程已经退出，不会再有 watcher / completion 回调
+        // 访问下面的成员（zkClient_ 声明在最前，析构在最后）；之后再停 watcher 线程
+        zkClient_.Close();
+        stopWorkers();
     }
     ZkClient zkClient_;
     std::mutex cache_mutex_;
     std::mutex zk_mutex_;
-    // key: "service/method" -> list of "ip:port"
-    std::unordered_map<std::string, std::vector<std::string>> cache_;
+    // 读写分离（RCU）：写端在 cache_mutex_ 下复制快照、替换变化的 entry 后整体发布，
+    // 读端只比较版本号，命中时直接使用线程本地持有的快照，不加锁也不动引用计数
+    SnapshotPtr               snapshot_;      // 用 std::atomic_load / atomic_store 访问
+    std::atomic<uint64_t>     version_;
+    // key: "service/method" -> ServiceKey id，只增不删
+    std::unordered_map<std::string, uint32_t> keyIds_;
+    // 已完成首次拉取的 key / 需要处理 watcher 事件的 key
+    std::unordered_set<std::string> subscribed_;
+    std::unordered_set<std::string> watched_;
+    // 首次拉取进行中的 key，完成（或超时）后移入 subscribed_
+    std::unordered_map<std::string, std::shared_ptr<Subscription>> subscribing_;
+    // 拉取序号全局递增，每个 key 记录已应用的序号；新旧两种布局的结果按同一个序号比较先后
+    uint64_t nextFetchSeq_;
+    std::unordered_map<std::string, uint64_t> appliedSeqs_;
+    // 有 /service/instances 节点的 service 及其最近一次拉到的实例；确认没有 instances 节点的 service
+    std::unordered_map<std::string, ServiceInstances> instances_;
+    std::unordered_set<std::string> legacyServices_;
+    // 仍在拉取旧布局方法节点的 key：service 没有 instances 节点，或方法节点下还有实例（滚动升级中）；
+    // 方法节点空了且新布局已接管后移除，之后只在方法节点的 watcher 触发时才再拉取
+    std::unordered_map<std::string, LegacyMethod> legacyMethods_;
+    // ip:port -> 出现在多少个已订阅方法中，降到 0 时记入 MembershipChange::gone
+    std::unordered_map<std::string, int> endpointRefs_;
+    std::map<int, MembershipListener> listeners_;
+    int nextListenerId_;
+    // service -> 策略名
+    std::unordered_map<std::string, std::string> policies_;
+    std::string defaultPolicy_;
+    std::string localZone_;
+
+    std::mutex stats_mutex_;
+    // key: "ip:port"，不随成员变化删除，实例下线再上线后统计依然可用
+    std::unordered_map<std::string, EndpointStatsPtr> stats_;
+
+
+    // 来自本地快照、或最近一次拉取失败的 key：ZooKeeper 连上时重新拉取
+    std::unordered_set<std::string> unsynced_;
+    static constexpr double   kDefaultConnectTimeout = 5.0;   // 秒
+    std::string               snapshotPath_;
+    double                    connectTimeout_;
+    std::mutex                persist_mutex_;
+    uint64_t                  persistedVersion_;   // 已写入文件的快照版本
+
+    static constexpr double   kDefaultZoneMinHealthy     = 0.7;
+    static constexpr double   kDefaultZoneMaxUtilization = 0.8;
+    std::atomic<double>       zoneMinHealthy_;
+    std::atomic<double>       zoneMaxUtilization_;
+    std::atomic<int64_t>      slowStartWindowUs_;
+
+    // 所有 EndpointStats 共用的异常摘除参数和逻辑，stats_ 中的统计持有它的指针；
+    // 延迟异常检测由 outlierThread_ 按周期执行
+    OutlierDetector           outlier_;
+    std::mutex                outlierMutex_;
+    std::condition_variable   outlierCv_;
+    bool                      outlierStop_;
+    std::thread               outlierThread_;
 
+    std::atomic<uint64_t>     eventCount_;
+    std::atomic<uint64_t>     coalescedCount_;
+    std::atomic<uint64_t>     refreshCount_;
+    std::atomic<int64_t>      lastLagUs_;
+    std::atomic<int64_t>      maxLagUs_;
 
-    //demon线程用于独立管理zkwatcher触发的事件回调
-    struct ZkEvent { std::string path; int type; };
-    std::thread               worker_;
-    std::mutex                queueMtx_;
-    std::condition_variable   queueCv_;
-    bool                      stop_;
-    std::queue<ZkEvent>       events_;
+    //demon线程用于独立管理zkwatcher触发的事件回调：按方法合并后延迟一个窗口再处理。
+    //多个线程，每个方法固定落在一个线程（shard）上，保证同一方法的事件和更新按顺序处理
+    struct WatchShard {
+        WatchShard() : stop(false) {}
+        std::mutex                mutex;
+        std::condition_variable   cv;
+        bool                      stop;
+        std::unordered_map<std::string, PendingRefresh> pending;   // key: "service/method"
+        std::queue<std::string>   dueOrder;
+        std::queue<std::function<void()>> tasks;   // 拉取完成后的写缓存任务，优先于刷新执行
+        std::thread               thread;
+    };
+    std::atomic<int64_t>      debounceUs_;
+    int                       workerCount_;        // 0 表示按 CPU 核数决定
+    std::atomic<bool>         workersStarted_;
+    std::vector<std::unique_ptr<WatchShard>> shards_;   // 启动后不再变化
 
-    void processEvents();
+    void startWorkers();
+    void stopWorkers();
+    WatchShard* shardFor(const std::string& key);
+    // 在 key 所属的 watcher 线程上执行；线程尚未启动时直接在当前线程执行
+    void runInShard(const std::string& key, std::function<void()> task);
+    void processEvents(WatchShard* shard);
     void enqueueEvent(const std::string& path, int type);
 
 
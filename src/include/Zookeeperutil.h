@@ -5,6 +5,9 @@
 #include<zookeeper/zookeeper.h>
 #include<string>
 #include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
 class RpcServer; // forward declaration
 //封装的zk客户端
 class ZkClient
@@ -12,10 +15,18 @@ class ZkClient
 public:
     ZkClient();
     ~ZkClient();
-    //zkclient启动连接zkserver
-    void Start(const std::string& host, const std::string& port);
-    //在zkserver中创建一个节点，根据指定的path
-    void Create(const char* path,const char* data,int datalen,int state=0);
+    //zkclient启动连接zkserver，一直等到连接成功；创建句柄失败时返回 false
+    bool Start(const std::string& host, const std::string& port);
+    // 只发起连接，不等待；连接由 C 客户端在后台建立，断开后也会自动重连
+    bool Connect(const std::string& host, const std::string& port);
+    // 等待连接成功，seconds <= 0 表示一直等；返回 false 表示超时
+    bool WaitConnected(double seconds);
+    bool IsConnected();
+    // 每次（重新）连上 ZooKeeper 时回调，在 C 客户端的 watcher 线程上执行，需在 Connect 之前设置
+    typedef std::function<void()> ConnectedCallback;
+    void SetConnectedCallback(ConnectedCallback cb) { m_connectedCb = std::move(cb); }
+    //在zkserver中创建一个节点，根据指定的path；节点已存在也返回 true，失败只打日志
+    bool Create(const char* path,const char* data,int datalen,int state=0);
     void Delete(const char* path);
     void Close();
 
@@ -28,8 +39,38 @@ public:
     int GetChildrenW(const char* path, watcher_fn watcher, void* watcherCtx, struct String_vector* strings);
     // 带 watcher 的异步获取节点数据
     int GetDataW(const char* path, watcher_fn watcher, void* watcherCtx, char* buffer, int* bufferlen);
+    // 带 watcher 的存在性检查，节点被创建 / 删除时触发
+    int ExistsW(const char* path, watcher_fn watcher, void* watcherCtx);
+
+    // 异步版本：请求发出后立即返回，多个请求在同一会话上流水线发送，不必逐个等待往返。
+    // 回调恰好执行一次——正常情况下在 ZooKeeper 的 completion 线程上，发送失败时在调用线程上直接执行；
+    // 回调中不能再调用同步接口（会阻塞 completion 线程导致死锁）
+    typedef std::function<void(int rc, const std::vector<std::string>& children)> ChildrenCallback;
+    typedef std::function<void(int rc, const std::string& data)> DataCallback;
+    typedef std::function<void(int rc)> ExistsCallback;
+    void AsyncGetChildrenW(const char* path, watcher_fn watcher, void* watcherCtx, ChildrenCallback cb);
+    void AsyncGetDataW(const char* path, watcher_fn watcher, void* watcherCtx, DataCallback cb);
+    void AsyncExistsW(const char* path, watcher_fn watcher, void* watcherCtx, ExistsCallback cb);
+
+    // 批量注册：flags 为 0 的持久节点流水线并发创建（已存在视为成功，按给出的顺序发送，父节点写在前面）；
+    // 临时节点放进一个 zoo_multi 事务一起创建，上一个会话遗留的同名临时节点在同一事务里先删除。
+    // 整批只需两次往返，cb(rc) 恰好执行一次（通常在 completion 线程上），失败由调用方决定是否重试
+    struct Node {
+        std::string path;
+        std::string data;
+        int         flags;
+    };
+    typedef std::function<void(int rc)> BatchCallback;
+    void CreateBatchAsync(const std::vector<Node>& nodes, BatchCallback cb);
+    // 一个 zoo_multi 删除一批节点，已不存在的节点跳过后重试剩余部分
+    int DeleteBatch(const std::vector<std::string>& paths);
 private:
+    friend void global_watcher(zhandle_t*, int, int, const char*, void*);
     //Zk的客户端句柄
     zhandle_t* m_zhandle;
+    std::mutex              m_mutex;
+    std::condition_variable m_cv;
+    bool                    m_connected;
+    ConnectedCallback       m_connectedCb;
 };
 #endif
@@ -13,7 +13,7 @@
 #error incompatible with your Protocol Buffer headers. Please update
 #error your headers.
 #endif
-#if 3021000 < PROTOBUF_MIN_PROTOC_VERSION
+#if 3021012 < PROTOBUF_MIN_PROTOC_VERSION
 #error This file was generated by an older version of protoc which is
 #error incompatible with your Protocol Buffer headers. Please
 #error regenerate this file with a newer version of protoc.
@@ -46,12 +46,20 @@ struct TableStruct_rpc_2eproto {
 };
 extern const ::PROTOBUF_NAMESPACE_ID::internal::DescriptorTable descriptor_table_rpc_2eproto;
 namespace Krpc {
+class EndpointMeta;
+struct EndpointMetaDefaultTypeInternal;
+extern EndpointMetaDefaultTypeInternal _EndpointMeta_default_instance_;
 class RpcHeader;
 struct RpcHeaderDefaultTypeInternal;
 extern RpcHeaderDefaultTypeInternal _RpcHeader_default_instance_;
+class ServerLoad;
+struct ServerLoadDefaultTypeInternal;
+extern ServerLoadDefaultTypeInternal _ServerLoad_default_instance_;
 }  // namespace Krpc
 PROTOBUF_NAMESPACE_OPEN
+template<> ::Krpc::EndpointMeta* Arena::CreateMaybeMessage<::Krpc::EndpointMeta>(Arena*);
 template<> ::Krpc::RpcHeader* Arena::CreateMaybeMessage<::Krpc::RpcHeader>(Arena*);
+template<> ::Krpc::ServerLoad* Arena::CreateMaybeMessage<::Krpc::ServerLoad>(Arena*);
 PROTOBUF_NAMESPACE_CLOSE
 namespace Krpc {
 
@@ -80,6 +88,38 @@ inline bool MessageType_Parse(
   return ::PROTOBUF_NAMESPACE_ID::internal::ParseNamedEnum<MessageType>(
     MessageType_descriptor(), name, value);
 }
+enum StatusCode : int {
+  OK = 0,
+  CANCELLED = 1,
+  UNKNOWN = 2,
+  INVALID_ARGUMENT = 3,
+  DEADLINE_EXCEEDED = 4,
+  RESOURCE_EXHAUSTED = 8,
+  UNIMPLEMENTED = 12,
+  INTERNAL = 13,
+  UNAVAILABLE = 14,
+  StatusCode_INT_MIN_SENTINEL_DO_NOT_USE_ = std::numeric_limits<int32_t>::min(),
+  StatusCode_INT_MAX_SENTINEL_DO_NOT_USE_ = std::numeric_limits<int32_t>::max()
+};
+bool StatusCode_IsValid(int value);
+constexpr StatusCode StatusCode_MIN = OK;
+constexpr StatusCode StatusCode_MAX = UNAVAILABLE;
+constexpr int StatusCode_ARRAYSIZE = StatusCode_MAX + 1;
+
+const ::PROTOBUF_NAMESPACE_ID::EnumDescriptor* StatusCode_descriptor();
+template<typename T>
+inline const std::string& StatusCode_Name(T enum_t_value) {
+  static_assert(::std::is_same<T, StatusCode>::value ||
+    ::std::is_integral<T>::value,
+    "Incorrect type passed to function StatusCode_Name.");
+  return ::PROTOBUF_NAMESPACE_ID::internal::NameOfEnum(
+    StatusCode_descriptor(), enum_t_value);
+}
+inline bool StatusCode_Parse(
+    ::PROTOBUF_NAMESPACE_ID::ConstStringParam name, StatusCode* value) {
+  return ::PROTOBUF_NAMESPACE_ID::internal::ParseNamedEnum<StatusCode>(
+    StatusCode_descriptor(), name, value);
+}
 // ===================================================================
 
 class RpcHeader final :
@@ -206,8 +246,11 @@ class RpcHeader final :
     kServiceNameFieldNumber = 3,
     kMethodNameFieldNumber = 4,
     kPayloadFieldNumber = 5,
+    kErrorTextFieldNumber = 8,
+    kLoadFieldNumber = 6,
     kIdFieldNumber = 2,
     kTypeFieldNumber = 1,
+    kStatusFieldNumber = 7,
   };
   // bytes service_name = 3;
   void clear_service_name();
@@ -251,25 +294,526 @@ class RpcHeader final :
   std::string* _internal_mutable_payload();
   public:
 
+  // bytes error_text = 8;
+  void clear_error_text();
+  const std::string& error_text() const;
+  template <typename ArgT0 = const std::string&, typename... ArgT>
+  void set_error_text(ArgT0&& arg0, ArgT... args);
+  std::string* mutable_error_text();
+  PROTOBUF_NODISCARD std::string* release_error_text();
+  void set_allocated_error_text(std::string* error_text);
+  private:
+  const std::string& _internal_error_text() const;
+  inline PROTOBUF_ALWAYS_INLINE void _internal_set_error_text(const std::string& value);
+  std::string* _internal_mutable_error_text();
+  public:
+
+  // .Krpc.ServerLoad load = 6;
+  bool has_load() const;
+  private:
+  bool _internal_has_load() const;
+  public:
+  void clear_load();
+  const ::Krpc::ServerLoad& load() const;
+  PROTOBUF_NODISCARD ::Krpc::ServerLoad* release_load();
+  ::Krpc::ServerLoad* mutable_load();
+  void set_allocated_load(::Krpc::ServerLoad* load);
+  private:
+  const ::Krpc::ServerLoad& _internal_load() const;
+  ::Krpc::ServerLoad* _internal_mutable_load();
+  public:
+  void unsafe_arena_set_allocated_load(
+      ::Krpc::ServerLoad* load);
+  ::Krpc::ServerLoad* unsafe_arena_release_load();
+
   // fixed64 id = 2;
   void clear_id();
   uint64_t id() const;
   void set_id(uint64_t value);
   private:
-  uint64_t _internal_id() const;
-  void _internal_set_id(uint64_t value);
+  uint64_t _internal_id() const;
+  void _internal_set_id(uint64_t value);
+  public:
+
+  // .Krpc.MessageType type = 1;
+  void clear_type();
+  ::Krpc::MessageType type() const;
+  void set_type(::Krpc::MessageType value);
+  private:
+  ::Krpc::MessageType _internal_type() const;
+  void _internal_set_type(::Krpc::MessageType value);
+  public:
+
+  // .Krpc.StatusCode status = 7;
+  void clear_status();
+  ::Krpc::StatusCode status() const;
+  void set_status(::Krpc::StatusCode value);
+  private:
+  ::Krpc::StatusCode _internal_status() const;
+  void _internal_set_status(::Krpc::StatusCode value);
+  public:
+
+  // @@protoc_insertion_point(class_scope:Krpc.RpcHeader)
+ private:
+  class _Internal;
+
+  template <typename T> friend class ::PROTOBUF_NAMESPACE_ID::Arena::InternalHelper;
+  typedef void InternalArenaConstructable_;
+  typedef void DestructorSkippable_;
+  struct Impl_ {
+    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr service_name_;
+    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr method_name_;
+    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr payload_;
+    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr error_text_;
+    ::Krpc::ServerLoad* load_;
+    uint64_t id_;
+    int type_;
+    int status_;
+    mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
+  };
+  union { Impl_ _impl_; };
+  friend struct ::TableStruct_rpc_2eproto;
+};
+// -------------------------------------------------------------------
+
+class ServerLoad final :
+    public ::PROTOBUF_NAMESPACE_ID::Message /* @@protoc_insertion_point(class_definition:Krpc.ServerLoad) */ {
+ public:
+  inline ServerLoad() : ServerLoad(nullptr) {}
+  ~ServerLoad() override;
+  explicit PROTOBUF_CONSTEXPR ServerLoad(::PROTOBUF_NAMESPACE_ID::internal::ConstantInitialized);
+
+  ServerLoad(const ServerLoad& from);
+  ServerLoad(ServerLoad&& from) noexcept
+    : ServerLoad() {
+    *this = ::std::move(from);
+  }
+
+  inline ServerLoad& operator=(const ServerLoad& from) {
+    CopyFrom(from);
+    return *this;
+  }
+  inline ServerLoad& operator=(ServerLoad&& from) noexcept {
+    if (this == &from) return *this;
+    if (GetOwningArena() == from.GetOwningArena()
+  #ifdef PROTOBUF_FORCE_COPY_IN_MOVE
+        && GetOwningArena() != nullptr
+  #endif  // !PROTOBUF_FORCE_COPY_IN_MOVE
+    ) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* descriptor() {
+    return GetDescriptor();
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* GetDescriptor() {
+    return default_instance().GetMetadata().descriptor;
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Reflection* GetReflection() {
+    return default_instance().GetMetadata().reflection;
+  }
+  static const ServerLoad& default_instance() {
+    return *internal_default_instance();
+  }
+  static inline const ServerLoad* internal_default_instance() {
+    return reinterpret_cast<const ServerLoad*>(
+               &_ServerLoad_default_instance_);
+  }
+  static constexpr int kIndexInFileMessages =
+    1;
+
+  friend void swap(ServerLoad& a, ServerLoad& b) {
+    a.Swap(&b);
+  }
+  inline void Swap(ServerLoad* other) {
+    if (other == this) return;
+  #ifdef PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() != nullptr &&
+        GetOwningArena() == other->GetOwningArena()) {
+   #else  // PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() == other->GetOwningArena()) {
+  #endif  // !PROTOBUF_FORCE_COPY_IN_SWAP
+      InternalSwap(other);
+    } else {
+      ::PROTOBUF_NAMESPACE_ID::internal::GenericSwap(this, other);
+    }
+  }
+  void UnsafeArenaSwap(ServerLoad* other) {
+    if (other == this) return;
+    GOOGLE_DCHECK(GetOwningArena() == other->GetOwningArena());
+    InternalSwap(other);
+  }
+
+  // implements Message ----------------------------------------------
+
+  ServerLoad* New(::PROTOBUF_NAMESPACE_ID::Arena* arena = nullptr) const final {
+    return CreateMaybeMessage<ServerLoad>(arena);
+  }
+  using ::PROTOBUF_NAMESPACE_ID::Message::CopyFrom;
+  void CopyFrom(const ServerLoad& from);
+  using ::PROTOBUF_NAMESPACE_ID::Message::MergeFrom;
+  void MergeFrom( const ServerLoad& from) {
+    ServerLoad::MergeImpl(*this, from);
+  }
+  private:
+  static void MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg);
+  public:
+  PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
+  bool IsInitialized() const final;
+
+  size_t ByteSizeLong() const final;
+  const char* _InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) final;
+  uint8_t* _InternalSerialize(
+      uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const final;
+  int GetCachedSize() const final { return _impl_._cached_size_.Get(); }
+
+  private:
+  void SharedCtor(::PROTOBUF_NAMESPACE_ID::Arena* arena, bool is_message_owned);
+  void SharedDtor();
+  void SetCachedSize(int size) const final;
+  void InternalSwap(ServerLoad* other);
+
+  private:
+  friend class ::PROTOBUF_NAMESPACE_ID::internal::AnyMetadata;
+  static ::PROTOBUF_NAMESPACE_ID::StringPiece FullMessageName() {
+    return "Krpc.ServerLoad";
+  }
+  protected:
+  explicit ServerLoad(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                       bool is_message_owned = false);
+  public:
+
+  static const ClassData _class_data_;
+  const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*GetClassData() const final;
+
+  ::PROTOBUF_NAMESPACE_ID::Metadata GetMetadata() const final;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  enum : int {
+    kInflightFieldNumber = 1,
+    kQueueDelayUsFieldNumber = 2,
+    kCpuPermilleFieldNumber = 3,
+  };
+  // uint32 inflight = 1;
+  void clear_inflight();
+  uint32_t inflight() const;
+  void set_inflight(uint32_t value);
+  private:
+  uint32_t _internal_inflight() const;
+  void _internal_set_inflight(uint32_t value);
+  public:
+
+  // uint32 queue_delay_us = 2;
+  void clear_queue_delay_us();
+  uint32_t queue_delay_us() const;
+  void set_queue_delay_us(uint32_t value);
+  private:
+  uint32_t _internal_queue_delay_us() const;
+  void _internal_set_queue_delay_us(uint32_t value);
+  public:
+
+  // uint32 cpu_permille = 3;
+  void clear_cpu_permille();
+  uint32_t cpu_permille() const;
+  void set_cpu_permille(uint32_t value);
+  private:
+  uint32_t _internal_cpu_permille() const;
+  void _internal_set_cpu_permille(uint32_t value);
+  public:
+
+  // @@protoc_insertion_point(class_scope:Krpc.ServerLoad)
+ private:
+  class _Internal;
+
+  template <typename T> friend class ::PROTOBUF_NAMESPACE_ID::Arena::InternalHelper;
+  typedef void InternalArenaConstructable_;
+  typedef void DestructorSkippable_;
+  struct Impl_ {
+    uint32_t inflight_;
+    uint32_t queue_delay_us_;
+    uint32_t cpu_permille_;
+    mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
+  };
+  union { Impl_ _impl_; };
+  friend struct ::TableStruct_rpc_2eproto;
+};
+// -------------------------------------------------------------------
+
+class EndpointMeta final :
+    public ::PROTOBUF_NAMESPACE_ID::Message /* @@protoc_insertion_point(class_definition:Krpc.EndpointMeta) */ {
+ public:
+  inline EndpointMeta() : EndpointMeta(nullptr) {}
+  ~EndpointMeta() override;
+  explicit PROTOBUF_CONSTEXPR EndpointMeta(::PROTOBUF_NAMESPACE_ID::internal::ConstantInitialized);
+
+  EndpointMeta(const EndpointMeta& from);
+  EndpointMeta(EndpointMeta&& from) noexcept
+    : EndpointMeta() {
+    *this = ::std::move(from);
+  }
+
+  inline EndpointMeta& operator=(const EndpointMeta& from) {
+    CopyFrom(from);
+    return *this;
+  }
+  inline EndpointMeta& operator=(EndpointMeta&& from) noexcept {
+    if (this == &from) return *this;
+    if (GetOwningArena() == from.GetOwningArena()
+  #ifdef PROTOBUF_FORCE_COPY_IN_MOVE
+        && GetOwningArena() != nullptr
+  #endif  // !PROTOBUF_FORCE_COPY_IN_MOVE
+    ) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* descriptor() {
+    return GetDescriptor();
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* GetDescriptor() {
+    return default_instance().GetMetadata().descriptor;
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Reflection* GetReflection() {
+    return default_instance().GetMetadata().reflection;
+  }
+  static const EndpointMeta& default_instance() {
+    return *internal_default_instance();
+  }
+  static inline const EndpointMeta* internal_default_instance() {
+    return reinterpret_cast<const EndpointMeta*>(
+               &_EndpointMeta_default_instance_);
+  }
+  static constexpr int kIndexInFileMessages =
+    2;
+
+  friend void swap(EndpointMeta& a, EndpointMeta& b) {
+    a.Swap(&b);
+  }
+  inline void Swap(EndpointMeta* other) {
+    if (other == this) return;
+  #ifdef PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() != nullptr &&
+        GetOwningArena() == other->GetOwningArena()) {
+   #else  // PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() == other->GetOwningArena()) {
+  #endif  // !PROTOBUF_FORCE_COPY_IN_SWAP
+      InternalSwap(other);
+    } else {
+      ::PROTOBUF_NAMESPACE_ID::internal::GenericSwap(this, other);
+    }
+  }
+  void UnsafeArenaSwap(EndpointMeta* other) {
+    if (other == this) return;
+    GOOGLE_DCHECK(GetOwningArena() == other->GetOwningArena());
+    InternalSwap(other);
+  }
+
+  // implements Message ----------------------------------------------
+
+  EndpointMeta* New(::PROTOBUF_NAMESPACE_ID::Arena* arena = nullptr) const final {
+    return CreateMaybeMessage<EndpointMeta>(arena);
+  }
+  using ::PROTOBUF_NAMESPACE_ID::Message::CopyFrom;
+  void CopyFrom(const EndpointMeta& from);
+  using ::PROTOBUF_NAMESPACE_ID::Message::MergeFrom;
+  void MergeFrom( const EndpointMeta& from) {
+    EndpointMeta::MergeImpl(*this, from);
+  }
+  private:
+  static void MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg);
+  public:
+  PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
+  bool IsInitialized() const final;
+
+  size_t ByteSizeLong() const final;
+  const char* _InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) final;
+  uint8_t* _InternalSerialize(
+      uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const final;
+  int GetCachedSize() const final { return _impl_._cached_size_.Get(); }
+
+  private:
+  void SharedCtor(::PROTOBUF_NAMESPACE_ID::Arena* arena, bool is_message_owned);
+  void SharedDtor();
+  void SetCachedSize(int size) const final;
+  void InternalSwap(EndpointMeta* other);
+
+  private:
+  friend class ::PROTOBUF_NAMESPACE_ID::internal::AnyMetadata;
+  static ::PROTOBUF_NAMESPACE_ID::StringPiece FullMessageName() {
+    return "Krpc.EndpointMeta";
+  }
+  protected:
+  explicit EndpointMeta(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                       bool is_message_owned = false);
+  public:
+
+  static const ClassData _class_data_;
+  const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*GetClassData() const final;
+
+  ::PROTOBUF_NAMESPACE_ID::Metadata GetMetadata() const final;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  enum : int {
+    kMethodsFieldNumber = 11,
+    kHostFieldNumber = 2,
+    kZoneFieldNumber = 5,
+    kRackFieldNumber = 6,
+    kBuildVersionFieldNumber = 9,
+    kMetaVersionFieldNumber = 1,
+    kPortFieldNumber = 3,
+    kWeightFieldNumber = 4,
+    kMaxConcurrencyFieldNumber = 7,
+    kStartTimeMsFieldNumber = 10,
+    kProtocolVersionFieldNumber = 8,
+  };
+  // repeated string methods = 11;
+  int methods_size() const;
+  private:
+  int _internal_methods_size() const;
+  public:
+  void clear_methods();
+  const std::string& methods(int index) const;
+  std::string* mutable_methods(int index);
+  void set_methods(int index, const std::string& value);
+  void set_methods(int index, std::string&& value);
+  void set_methods(int index, const char* value);
+  void set_methods(int index, const char* value, size_t size);
+  std::string* add_methods();
+  void add_methods(const std::string& value);
+  void add_methods(std::string&& value);
+  void add_methods(const char* value);
+  void add_methods(const char* value, size_t size);
+  const ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField<std::string>& methods() const;
+  ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField<std::string>* mutable_methods();
+  private:
+  const std::string& _internal_methods(int index) const;
+  std::string* _internal_add_methods();
+  public:
+
+  // string host = 2;
+  void clear_host();
+  const std::string& host() const;
+  template <typename ArgT0 = const std::string&, typename... ArgT>
+  void set_host(ArgT0&& arg0, ArgT... args);
+  std::string* mutable_host();
+  PROTOBUF_NODISCARD std::string* release_host();
+  void set_allocated_host(std::string* host);
+  private:
+  const std::string& _internal_host() const;
+  inline PROTOBUF_ALWAYS_INLINE void _internal_set_host(const std::string& value);
+  std::string* _internal_mutable_host();
+  public:
+
+  // string zone = 5;
+  void clear_zone();
+  const std::string& zone() const;
+  template <typename ArgT0 = const std::string&, typename... ArgT>
+  void set_zone(ArgT0&& arg0, ArgT... args);
+  std::string* mutable_zone();
+  PROTOBUF_NODISCARD std::string* release_zone();
+  void set_allocated_zone(std::string* zone);
+  private:
+  const std::string& _internal_zone() const;
+  inline PROTOBUF_ALWAYS_INLINE void _internal_set_zone(const std::string& value);
+  std::string* _internal_mutable_zone();
+  public:
+
+  // string rack = 6;
+  void clear_rack();
+  const std::string& rack() const;
+  template <typename ArgT0 = const std::string&, typename... ArgT>
+  void set_rack(ArgT0&& arg0, ArgT... args);
+  std::string* mutable_rack();
+  PROTOBUF_NODISCARD std::string* release_rack();
+  void set_allocated_rack(std::string* rack);
+  private:
+  const std::string& _internal_rack() const;
+  inline PROTOBUF_ALWAYS_INLINE void _internal_set_rack(const std::string& value);
+  std::string* _internal_mutable_rack();
+  public:
+
+  // string build_version = 9;
+  void clear_build_version();
+  const std::string& build_version() const;
+  template <typename ArgT0 = const std::string&, typename... ArgT>
+  void set_build_version(ArgT0&& arg0, ArgT... args);
+  std::string* mutable_build_version();
+  PROTOBUF_NODISCARD std::string* release_build_version();
+  void set_allocated_build_version(std::string* build_version);
+  private:
+  const std::string& _internal_build_version() const;
+  inline PROTOBUF_ALWAYS_INLINE void _internal_set_build_version(const std::string& value);
+  std::string* _internal_mutable_build_version();
+  public:
+
+  // uint32 meta_version = 1;
+  void clear_meta_version();
+  uint32_t meta_version() const;
+  void set_meta_version(uint32_t value);
+  private:
+  uint32_t _internal_meta_version() const;
+  void _internal_set_meta_version(uint32_t value);
+  public:
+
+  // uint32 port = 3;
+  void clear_port();
+  uint32_t port() const;
+  void set_port(uint32_t value);
+  private:
+  uint32_t _internal_port() const;
+  void _internal_set_port(uint32_t value);
+  public:
+
+  // uint32 weight = 4;
+  void clear_weight();
+  uint32_t weight() const;
+  void set_weight(uint32_t value);
+  private:
+  uint32_t _internal_weight() const;
+  void _internal_set_weight(uint32_t value);
+  public:
+
+  // uint32 max_concurrency = 7;
+  void clear_max_concurrency();
+  uint32_t max_concurrency() const;
+  void set_max_concurrency(uint32_t value);
+  private:
+  uint32_t _internal_max_concurrency() const;
+  void _internal_set_max_concurrency(uint32_t value);
+  public:
+
+  // int64 start_time_ms = 10;
+  void clear_start_time_ms();
+  int64_t start_time_ms() const;
+  void set_start_time_ms(int64_t value);
+  private:
+  int64_t _internal_start_time_ms() const;
+  void _internal_set_start_time_ms(int64_t value);
   public:
 
-  // .Krpc.MessageType type = 1;
-  void clear_type();
-  ::Krpc::MessageType type() const;
-  void set_type(::Krpc::MessageType value);
+  // uint32 protocol_version = 8;
+  void clear_protocol_version();
+  uint32_t protocol_version() const;
+  void set_protocol_version(uint32_t value);
   private:
-  ::Krpc::MessageType _internal_type() const;
-  void _internal_set_type(::Krpc::MessageType value);
+  uint32_t _internal_protocol_version() const;
+  void _internal_set_protocol_version(uint32_t value);
   public:
 
-  // @@protoc_insertion_point(class_scope:Krpc.RpcHeader)
+  // @@protoc_insertion_point(class_scope:Krpc.EndpointMeta)
  private:
   class _Internal;
 
@@ -277,11 +821,17 @@ class RpcHeader final :
   typedef void InternalArenaConstructable_;
   typedef void DestructorSkippable_;
   struct Impl_ {
-    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr service_name_;
-    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr method_name_;
-    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr payload_;
-    uint64_t id_;
-    int type_;
+    ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField<std::string> methods_;
+    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr host_;
+    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr zone_;
+    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr rack_;
+    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr build_version_;
+    uint32_t meta_version_;
+    uint32_t port_;
+    uint32_t weight_;
+    uint32_t max_concurrency_;
+    int64_t start_time_ms_;
+    uint32_t protocol_version_;
     mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
   };
   union { Impl_ _impl_; };
@@ -488,9 +1038,636 @@ inline void RpcHeader::set_allocated_payload(std::string* payload) {
   // @@protoc_insertion_point(field_set_allocated:Krpc.RpcHeader.payload)
 }
 
+// .Krpc.ServerLoad load = 6;
+inline bool RpcHeader::_internal_has_load() const {
+  return this != internal_default_instance() && _impl_.load_ != nullptr;
+}
+inline bool RpcHeader::has_load() const {
+  return _internal_has_load();
+}
+inline void RpcHeader::clear_load() {
+  if (GetArenaForAllocation() == nullptr && _impl_.load_ != nullptr) {
+    delete _impl_.load_;
+  }
+  _impl_.load_ = nullptr;
+}
+inline const ::Krpc::ServerLoad& RpcHeader::_internal_load() const {
+  const ::Krpc::ServerLoad* p = _impl_.load_;
+  return p != nullptr ? *p : reinterpret_cast<const ::Krpc::ServerLoad&>(
+      ::Krpc::_ServerLoad_default_instance_);
+}
+inline const ::Krpc::ServerLoad& RpcHeader::load() const {
+  // @@protoc_insertion_point(field_get:Krpc.RpcHeader.load)
+  return _internal_load();
+}
+inline void RpcHeader::unsafe_arena_set_allocated_load(
+    ::Krpc::ServerLoad* load) {
+  if (GetArenaForAllocation() == nullptr) {
+    delete reinterpret_cast<::PROTOBUF_NAMESPACE_ID::MessageLite*>(_impl_.load_);
+  }
+  _impl_.load_ = load;
+  if (load) {
+    
+  } else {
+    
+  }
+  // @@protoc_insertion_point(field_unsafe_arena_set_allocated:Krpc.RpcHeader.load)
+}
+inline ::Krpc::ServerLoad* RpcHeader::release_load() {
+  
+  ::Krpc::ServerLoad* temp = _impl_.load_;
+  _impl_.load_ = nullptr;
+#ifdef PROTOBUF_FORCE_COPY_IN_RELEASE
+  auto* old =  reinterpret_cast<::PROTOBUF_NAMESPACE_ID::MessageLite*>(temp);
+  temp = ::PROTOBUF_NAMESPACE_ID::internal::DuplicateIfNonNull(temp);
+  if (GetArenaForAllocation() == nullptr) { delete old; }
+#else  // PROTOBUF_FORCE_COPY_IN_RELEASE
+  if (GetArenaForAllocation() != nullptr) {
+    temp = ::PROTOBUF_NAMESPACE_ID::internal::DuplicateIfNonNull(temp);
+  }
+#endif  // !PROTOBUF_FORCE_COPY_IN_RELEASE
+  return temp;
+}
+inline ::Krpc::ServerLoad* RpcHeader::unsafe_arena_release_load() {
+  // @@protoc_insertion_point(field_release:Krpc.RpcHeader.load)
+  
+  ::Krpc::ServerLoad* temp = _impl_.load_;
+  _impl_.load_ = nullptr;
+  return temp;
+}
+inline ::Krpc::ServerLoad* RpcHeader::_internal_mutable_load() {
+  
+  if (_impl_.load_ == nullptr) {
+    auto* p = CreateMaybeMessage<::Krpc::ServerLoad>(GetArenaForAllocation());
+    _impl_.load_ = p;
+  }
+  return _impl_.load_;
+}
+inline ::Krpc::ServerLoad* RpcHeader::mutable_load() {
+  ::Krpc::ServerLoad* _msg = _internal_mutable_load();
+  // @@protoc_insertion_point(field_mutable:Krpc.RpcHeader.load)
+  return _msg;
+}
+inline void RpcHeader::set_allocated_load(::Krpc::ServerLoad* load) {
+  ::PROTOBUF_NAMESPACE_ID::Arena* message_arena = GetArenaForAllocation();
+  if (message_arena == nullptr) {
+    delete _impl_.load_;
+  }
+  if (load) {
+    ::PROTOBUF_NAMESPACE_ID::Arena* submessage_arena =
+        ::PROTOBUF_NAMESPACE_ID::Arena::InternalGetOwningArena(load);
+    if (message_arena != submessage_arena) {
+      load = ::PROTOBUF_NAMESPACE_ID::internal::GetOwnedMessage(
+          message_arena, load, submessage_arena);
+    }
+    
+  } else {
+    
+  }
+  _impl_.load_ = load;
+  // @@protoc_insertion_point(field_set_allocated:Krpc.RpcHeader.load)
+}
+
+// .Krpc.StatusCode status = 7;
+inline void RpcHeader::clear_status() {
+  _impl_.status_ = 0;
+}
+inline ::Krpc::StatusCode RpcHeader::_internal_status() const {
+  return static_cast< ::Krpc::StatusCode >(_impl_.status_);
+}
+inline ::Krpc::StatusCode RpcHeader::status() const {
+  // @@protoc_insertion_point(field_get:Krpc.RpcHeader.status)
+  return _internal_status();
+}
+inline void RpcHeader::_internal_set_status(::Krpc::StatusCode value) {
+  
+  _impl_.status_ = value;
+}
+inline void RpcHeader::set_status(::Krpc::StatusCode value) {
+  _internal_set_status(value);
+  // @@protoc_insertion_point(field_set:Krpc.RpcHeader.status)
+}
+
+// bytes error_text = 8;
+inline void RpcHeader::clear_error_text() {
+  _impl_.error_text_.ClearToEmpty();
+}
+inline const std::string& RpcHeader::error_text() const {
+  // @@protoc_insertion_point(field_get:Krpc.RpcHeader.error_text)
+  return _internal_error_text();
+}
+template <typename ArgT0, typename... ArgT>
+inline PROTOBUF_ALWAYS_INLINE
+void RpcHeader::set_error_text(ArgT0&& arg0, ArgT... args) {
+ 
+ _impl_.error_text_.SetBytes(static_cast<ArgT0 &&>(arg0), args..., GetArenaForAllocation());
+  // @@protoc_insertion_point(field_set:Krpc.RpcHeader.error_text)
+}
+inline std::string* RpcHeader::mutable_error_text() {
+  std::string* _s = _internal_mutable_error_text();
+  // @@protoc_insertion_point(field_mutable:Krpc.RpcHeader.error_text)
+  return _s;
+}
+inline const std::string& RpcHeader::_internal_error_text() const {
+  return _impl_.error_text_.Get();
+}
+inline void RpcHeader::_internal_set_error_text(const std::string& value) {
+  
+  _impl_.error_text_.Set(value, GetArenaForAllocation());
+}
+inline std::string* RpcHeader::_internal_mutable_error_text() {
+  
+  return _impl_.error_text_.Mutable(GetArenaForAllocation());
+}
+inline std::string* RpcHeader::release_error_text() {
+  // @@protoc_insertion_point(field_release:Krpc.RpcHeader.error_text)
+  return _impl_.error_text_.Release();
+}
+inline void RpcHeader::set_allocated_error_text(std::string* error_text) {
+  if (error_text != nullptr) {
+    
+  } else {
+    
+  }
+  _impl_.error_text_.SetAllocated(error_text, GetArenaForAllocation());
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.error_text_.IsDefault()) {
+    _impl_.error_text_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  // @@protoc_insertion_point(field_set_allocated:Krpc.RpcHeader.error_text)
+}
+
+// -------------------------------------------------------------------
+
+// ServerLoad
+
+// uint32 inflight = 1;
+inline void ServerLoad::clear_inflight() {
+  _impl_.inflight_ = 0u;
+}
+inline uint32_t ServerLoad::_internal_inflight() const {
+  return _impl_.inflight_;
+}
+inline uint32_t ServerLoad::inflight() const {
+  // @@protoc_insertion_point(field_get:Krpc.ServerLoad.inflight)
+  return _internal_inflight();
+}
+inline void ServerLoad::_internal_set_inflight(uint32_t value) {
+  
+  _impl_.inflight_ = value;
+}
+inline void ServerLoad::set_inflight(uint32_t value) {
+  _internal_set_inflight(value);
+  // @@protoc_insertion_point(field_set:Krpc.ServerLoad.inflight)
+}
+
+// uint32 queue_delay_us = 2;
+inline void ServerLoad::clear_queue_delay_us() {
+  _impl_.queue_delay_us_ = 0u;
+}
+inline uint32_t ServerLoad::_internal_queue_delay_us() const {
+  return _impl_.queue_delay_us_;
+}
+inline uint32_t ServerLoad::queue_delay_us() const {
+  // @@protoc_insertion_point(field_get:Krpc.ServerLoad.queue_delay_us)
+  return _internal_queue_delay_us();
+}
+inline void ServerLoad::_internal_set_queue_delay_us(uint32_t value) {
+  
+  _impl_.queue_delay_us_ = value;
+}
+inline void ServerLoad::set_queue_delay_us(uint32_t value) {
+  _internal_set_queue_delay_us(value);
+  // @@protoc_insertion_point(field_set:Krpc.ServerLoad.queue_delay_us)
+}
+
+// uint32 cpu_permille = 3;
+inline void ServerLoad::clear_cpu_permille() {
+  _impl_.cpu_permille_ = 0u;
+}
+inline uint32_t ServerLoad::_internal_cpu_permille() const {
+  return _impl_.cpu_permille_;
+}
+inline uint32_t ServerLoad::cpu_permille() const {
+  // @@protoc_insertion_point(field_get:Krpc.ServerLoad.cpu_permille)
+  return _internal_cpu_permille();
+}
+inline void ServerLoad::_internal_set_cpu_permille(uint32_t value) {
+  
+  _impl_.cpu_permille_ = value;
+}
+inline void ServerLoad::set_cpu_permille(uint32_t value) {
+  _internal_set_cpu_permille(value);
+  // @@protoc_insertion_point(field_set:Krpc.ServerLoad.cpu_permille)
+}
+
+// -------------------------------------------------------------------
+
+// EndpointMeta
+
+// uint32 meta_version = 1;
+inline void EndpointMeta::clear_meta_version() {
+  _impl_.meta_version_ = 0u;
+}
+inline uint32_t EndpointMeta::_internal_meta_version() const {
+  return _impl_.meta_version_;
+}
+inline uint32_t EndpointMeta::meta_version() const {
+  // @@protoc_insertion_point(field_get:Krpc.EndpointMeta.meta_version)
+  return _internal_meta_version();
+}
+inline void EndpointMeta::_internal_set_meta_version(uint32_t value) {
+  
+  _impl_.meta_version_ = value;
+}
+inline void EndpointMeta::set_meta_version(uint32_t value) {
+  _internal_set_meta_version(value);
+  // @@protoc_insertion_point(field_set:Krpc.EndpointMeta.meta_version)
+}
+
+// string host = 2;
+inline void EndpointMeta::clear_host() {
+  _impl_.host_.ClearToEmpty();
+}
+inline const std::string& EndpointMeta::host() const {
+  // @@protoc_insertion_point(field_get:Krpc.EndpointMeta.host)
+  return _internal_host();
+}
+template <typename ArgT0, typename... ArgT>
+inline PROTOBUF_ALWAYS_INLINE
+void EndpointMeta::set_host(ArgT0&& arg0, ArgT... args) {
+ 
+ _impl_.host_.Set(static_cast<ArgT0 &&>(arg0), args..., GetArenaForAllocation());
+  // @@protoc_insertion_point(field_set:Krpc.EndpointMeta.host)
+}
+inline std::string* EndpointMeta::mutable_host() {
+  std::string* _s = _internal_mutable_host();
+  // @@protoc_insertion_point(field_mutable:Krpc.EndpointMeta.host)
+  return _s;
+}
+inline const std::string& EndpointMeta::_internal_host() const {
+  return _impl_.host_.Get();
+}
+inline void EndpointMeta::_internal_set_host(const std::string& value) {
+  
+  _impl_.host_.Set(value, GetArenaForAllocation());
+}
+inline std::string* EndpointMeta::_internal_mutable_host() {
+  
+  return _impl_.host_.Mutable(GetArenaForAllocation());
+}
+inline std::string* EndpointMeta::release_host() {
+  // @@protoc_insertion_point(field_release:Krpc.EndpointMeta.host)
+  return _impl_.host_.Release();
+}
+inline void EndpointMeta::set_allocated_host(std::string* host) {
+  if (host != nullptr) {
+    
+  } else {
+    
+  }
+  _impl_.host_.SetAllocated(host, GetArenaForAllocation());
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.host_.IsDefault()) {
+    _impl_.host_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  // @@protoc_insertion_point(field_set_allocated:Krpc.EndpointMeta.host)
+}
+
+// uint32 port = 3;
+inline void EndpointMeta::clear_port() {
+  _impl_.port_ = 0u;
+}
+inline uint32_t EndpointMeta::_internal_port() const {
+  return _impl_.port_;
+}
+inline uint32_t EndpointMeta::port() const {
+  // @@protoc_insertion_point(field_get:Krpc.EndpointMeta.port)
+  return _internal_port();
+}
+inline void EndpointMeta::_internal_set_port(uint32_t value) {
+  
+  _impl_.port_ = value;
+}
+inline void EndpointMeta::set_port(uint32_t value) {
+  _internal_set_port(value);
+  // @@protoc_insertion_point(field_set:Krpc.EndpointMeta.port)
+}
+
+// uint32 weight = 4;
+inline void EndpointMeta::clear_weight() {
+  _impl_.weight_ = 0u;
+}
+inline uint32_t EndpointMeta::_internal_weight() const {
+  return _impl_.weight_;
+}
+inline uint32_t EndpointMeta::weight() const {
+  // @@protoc_insertion_point(field_get:Krpc.EndpointMeta.weight)
+  return _internal_weight();
+}
+inline void EndpointMeta::_internal_set_weight(uint32_t value) {
+  
+  _impl_.weight_ = value;
+}
+inline void EndpointMeta::set_weight(uint32_t value) {
+  _internal_set_weight(value);
+  // @@protoc_insertion_point(field_set:Krpc.EndpointMeta.weight)
+}
+
+// string zone = 5;
+inline void EndpointMeta::clear_zone() {
+  _impl_.zone_.ClearToEmpty();
+}
+inline const std::string& EndpointMeta::zone() const {
+  // @@protoc_insertion_point(field_get:Krpc.EndpointMeta.zone)
+  return _internal_zone();
+}
+template <typename ArgT0, typename... ArgT>
+inline PROTOBUF_ALWAYS_INLINE
+void EndpointMeta::set_zone(ArgT0&& arg0, ArgT... args) {
+ 
+ _impl_.zone_.Set(static_cast<ArgT0 &&>(arg0), args..., GetArenaForAllocation());
+  // @@protoc_insertion_point(field_set:Krpc.EndpointMeta.zone)
+}
+inline std::string* EndpointMeta::mutable_zone() {
+  std::string* _s = _internal_mutable_zone();
+  // @@protoc_insertion_point(field_mutable:Krpc.EndpointMeta.zone)
+  return _s;
+}
+inline const std::string& EndpointMeta::_internal_zone() const {
+  return _impl_.zone_.Get();
+}
+inline void EndpointMeta::_internal_set_zone(const std::string& value) {
+  
+  _impl_.zone_.Set(value, GetArenaForAllocation());
+}
+inline std::string* EndpointMeta::_internal_mutable_zone() {
+  
+  return _impl_.zone_.Mutable(GetArenaForAllocation());
+}
+inline std::string* EndpointMeta::release_zone() {
+  // @@protoc_insertion_point(field_release:Krpc.EndpointMeta.zone)
+  return _impl_.zone_.Release();
+}
+inline void EndpointMeta::set_allocated_zone(std::string* zone) {
+  if (zone != nullptr) {
+    
+  } else {
+    
+  }
+  _impl_.zone_.SetAllocated(zone, GetArenaForAllocation());
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.zone_.IsDefault()) {
+    _impl_.zone_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  // @@protoc_insertion_point(field_set_allocated:Krpc.EndpointMeta.zone)
+}
+
+// string rack = 6;
+inline void EndpointMeta::clear_rack() {
+  _impl_.rack_.ClearToEmpty();
+}
+inline const std::string& EndpointMeta::rack() const {
+  // @@protoc_insertion_point(field_get:Krpc.EndpointMeta.rack)
+  return _internal_rack();
+}
+template <typename ArgT0, typename... ArgT>
+inline PROTOBUF_ALWAYS_INLINE
+void EndpointMeta::set_rack(ArgT0&& arg0, ArgT... args) {
+ 
+ _impl_.rack_.Set(static_cast<ArgT0 &&>(arg0), args..., GetArenaForAllocation());
+  // @@protoc_insertion_point(field_set:Krpc.EndpointMeta.rack)
+}
+inline std::string* EndpointMeta::mutable_rack() {
+  std::string* _s = _internal_mutable_rack();
+  // @@protoc_insertion_point(field_mutable:Krpc.EndpointMeta.rack)
+  return _s;
+}
+inline const std::string& EndpointMeta::_internal_rack() const {
+  return _impl_.rack_.Get();
+}
+inline void EndpointMeta::_internal_set_rack(const std::string& value) {
+  
+  _impl_.rack_.Set(value, GetArenaForAllocation());
+}
+inline std::string* EndpointMeta::_internal_mutable_rack() {
+  
+  return _impl_.rack_.Mutable(GetArenaForAllocation());
+}
+inline std::string* EndpointMeta::release_rack() {
+  // @@protoc_insertion_point(field_release:Krpc.EndpointMeta.rack)
+  return _impl_.rack_.Release();
+}
+inline void EndpointMeta::set_allocated_rack(std::string* rack) {
+  if (rack != nullptr) {
+    
+  } else {
+    
+  }
+  _impl_.rack_.SetAllocated(rack, GetArenaForAllocation());
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.rack_.IsDefault()) {
+    _impl_.rack_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  // @@protoc_insertion_point(field_set_allocated:Krpc.EndpointMeta.rack)
+}
+
+// uint32 max_concurrency = 7;
+inline void EndpointMeta::clear_max_concurrency() {
+  _impl_.max_concurrency_ = 0u;
+}
+inline uint32_t EndpointMeta::_internal_max_concurrency() const {
+  return _impl_.max_concurrency_;
+}
+inline uint32_t EndpointMeta::max_concurrency() const {
+  // @@protoc_insertion_point(field_get:Krpc.EndpointMeta.max_concurrency)
+  return _internal_max_concurrency();
+}
+inline void EndpointMeta::_internal_set_max_concurrency(uint32_t value) {
+  
+  _impl_.max_concurrency_ = value;
+}
+inline void EndpointMeta::set_max_concurrency(uint32_t value) {
+  _internal_set_max_concurrency(value);
+  // @@protoc_insertion_point(field_set:Krpc.EndpointMeta.max_concurrency)
+}
+
+// uint32 protocol_version = 8;
+inline void EndpointMeta::clear_protocol_version() {
+  _impl_.protocol_version_ = 0u;
+}
+inline uint32_t EndpointMeta::_internal_protocol_version() const {
+  return _impl_.protocol_version_;
+}
+inline uint32_t EndpointMeta::protocol_version() const {
+  // @@protoc_insertion_point(field_get:Krpc.EndpointMeta.protocol_version)
+  return _internal_protocol_version();
+}
+inline void EndpointMeta::_internal_set_protocol_version(uint32_t value) {
+  
+  _impl_.protocol_version_ = value;
+}
+inline void EndpointMeta::set_protocol_version(uint32_t value) {
+  _internal_set_protocol_version(value);
+  // @@protoc_insertion_point(field_set:Krpc.EndpointMeta.protocol_version)
+}
+
+// string build_version = 9;
+inline void EndpointMeta::clear_build_version() {
+  _impl_.build_version_.ClearToEmpty();
+}
+inline const std::string& EndpointMeta::build_version() const {
+  // @@protoc_insertion_point(field_get:Krpc.EndpointMeta.build_version)
+  return _internal_build_version();
+}
+template <typename ArgT0, typename... ArgT>
+inline PROTOBUF_ALWAYS_INLINE
+void EndpointMeta::set_build_version(ArgT0&& arg0, ArgT... args) {
+ 
+ _impl_.build_version_.Set(static_cast<ArgT0 &&>(arg0), args..., GetArenaForAllocation());
+  // @@protoc_insertion_point(field_set:Krpc.EndpointMeta.build_version)
+}
+inline std::string* EndpointMeta::mutable_build_version() {
+  std::string* _s = _internal_mutable_build_version();
+  // @@protoc_insertion_point(field_mutable:Krpc.EndpointMeta.build_version)
+  return _s;
+}
+inline const std::string& EndpointMeta::_internal_build_version() const {
+  return _impl_.build_version_.Get();
+}
+inline void EndpointMeta::_internal_set_build_version(const std::string& value) {
+  
+  _impl_.build_version_.Set(value, GetArenaForAllocation());
+}
+inline std::string* EndpointMeta::_internal_mutable_build_version() {
+  
+  return _impl_.build_version_.Mutable(GetArenaForAllocation());
+}
+inline std::string* EndpointMeta::release_build_version() {
+  // @@protoc_insertion_point(field_release:Krpc.EndpointMeta.build_version)
+  return _impl_.build_version_.Release();
+}
+inline void EndpointMeta::set_allocated_build_version(std::string* build_version) {
+  if (build_version != nullptr) {
+    
+  } else {
+    
+  }
+  _impl_.build_version_.SetAllocated(build_version, GetArenaForAllocation());
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.build_version_.IsDefault()) {
+    _impl_.build_version_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  // @@protoc_insertion_point(field_set_allocated:Krpc.EndpointMeta.build_version)
+}
+
+// int64 start_time_ms = 10;
+inline void EndpointMeta::clear_start_time_ms() {
+  _impl_.start_time_ms_ = int64_t{0};
+}
+inline int64_t EndpointMeta::_internal_start_time_ms() const {
+  return _impl_.start_time_ms_;
+}
+inline int64_t EndpointMeta::start_time_ms() const {
+  // @@protoc_insertion_point(field_get:Krpc.EndpointMeta.start_time_ms)
+  return _internal_start_time_ms();
+}
+inline void EndpointMeta::_internal_set_start_time_ms(int64_t value) {
+  
+  _impl_.start_time_ms_ = value;
+}
+inline void EndpointMeta::set_start_time_ms(int64_t value) {
+  _internal_set_start_time_ms(value);
+  // @@protoc_insertion_point(field_set:Krpc.EndpointMeta.start_time_ms)
+}
+
+// repeated string methods = 11;
+inline int EndpointMeta::_internal_methods_size() const {
+  return _impl_.methods_.size();
+}
+inline int EndpointMeta::methods_size() const {
+  return _internal_methods_size();
+}
+inline void EndpointMeta::clear_methods() {
+  _impl_.methods_.Clear();
+}
+inline std::string* EndpointMeta::add_methods() {
+  std::string* _s = _internal_add_methods();
+  // @@protoc_insertion_point(field_add_mutable:Krpc.EndpointMeta.methods)
+  return _s;
+}
+inline const std::string& EndpointMeta::_internal_methods(int index) const {
+  return _impl_.methods_.Get(index);
+}
+inline const std::string& EndpointMeta::methods(int index) const {
+  // @@protoc_insertion_point(field_get:Krpc.EndpointMeta.methods)
+  return _internal_methods(index);
+}
+inline std::string* EndpointMeta::mutable_methods(int index) {
+  // @@protoc_insertion_point(field_mutable:Krpc.EndpointMeta.methods)
+  return _impl_.methods_.Mutable(index);
+}
+inline void EndpointMeta::set_methods(int index, const std::string& value) {
+  _impl_.methods_.Mutable(index)->assign(value);
+  // @@protoc_insertion_point(field_set:Krpc.EndpointMeta.methods)
+}
+inline void EndpointMeta::set_methods(int index, std::string&& value) {
+  _impl_.methods_.Mutable(index)->assign(std::move(value));
+  // @@protoc_insertion_point(field_set:Krpc.EndpointMeta.methods)
+}
+inline void EndpointMeta::set_methods(int index, const char* value) {
+  GOOGLE_DCHECK(value != nullptr);
+  _impl_.methods_.Mutable(index)->assign(value);
+  // @@protoc_insertion_point(field_set_char:Krpc.EndpointMeta.methods)
+}
+inline void EndpointMeta::set_methods(int index, const char* value, size_t size) {
+  _impl_.methods_.Mutable(index)->assign(
+    reinterpret_cast<const char*>(value), size);
+  // @@protoc_insertion_point(field_set_pointer:Krpc.EndpointMeta.methods)
+}
+inline std::string* EndpointMeta::_internal_add_methods() {
+  return _impl_.methods_.Add();
+}
+inline void EndpointMeta::add_methods(const std::string& value) {
+  _impl_.methods_.Add()->assign(value);
+  // @@protoc_insertion_point(field_add:Krpc.EndpointMeta.methods)
+}
+inline void EndpointMeta::add_methods(std::string&& value) {
+  _impl_.methods_.Add(std::move(value));
+  // @@protoc_insertion_point(field_add:Krpc.EndpointMeta.methods)
+}
+inline void EndpointMeta::add_methods(const char* value) {
+  GOOGLE_DCHECK(value != nullptr);
+  _impl_.methods_.Add()->assign(value);
+  // @@protoc_insertion_point(field_add_char:Krpc.EndpointMeta.methods)
+}
+inline void EndpointMeta::add_methods(const char* value, size_t size) {
+  _impl_.methods_.Add()->assign(reinterpret_cast<const char*>(value), size);
+  // @@protoc_insertion_point(field_add_pointer:Krpc.EndpointMeta.methods)
+}
+inline const ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField<std::string>&
+EndpointMeta::methods() const {
+  // @@protoc_insertion_point(field_list:Krpc.EndpointMeta.methods)
+  return _impl_.methods_;
+}
+inline ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField<std::string>*
+EndpointMeta::mutable_methods() {
+  // @@protoc_insertion_point(field_mutable_list:Krpc.EndpointMeta.methods)
+  return &_impl_.methods_;
+}
+
 #ifdef __GNUC__
   #pragma GCC diagnostic pop
 #endif  // __GNUC__
+// -------------------------------------------------------------------
+
+// -------------------------------------------------------------------
+
 
 // @@protoc_insertion_point(namespace_scope)
 
@@ -503,6 +1680,11 @@ template <>
 inline const EnumDescriptor* GetEnumDescriptor< ::Krpc::MessageType>() {
   return ::Krpc::MessageType_descriptor();
 }
+template <> struct is_proto_enum< ::Krpc::StatusCode> : ::std::true_type {};
+template <>
+inline const EnumDescriptor* GetEnumDescriptor< ::Krpc::StatusCode>() {
+  return ::Krpc::StatusCode_descriptor();
+}
 
 PROTOBUF_NAMESPACE_CLOSE
 
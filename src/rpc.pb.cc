@@ -26,8 +26,11 @@ PROTOBUF_CONSTEXPR RpcHeader::RpcHeader(
     /*decltype(_impl_.service_name_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
   , /*decltype(_impl_.method_name_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
   , /*decltype(_impl_.payload_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+  , /*decltype(_impl_.error_text_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+  , /*decltype(_impl_.load_)*/nullptr
   , /*decltype(_impl_.id_)*/uint64_t{0u}
   , /*decltype(_impl_.type_)*/0
+  , /*decltype(_impl_.status_)*/0
   , /*decltype(_impl_._cached_size_)*/{}} {}
 struct RpcHeaderDefaultTypeInternal {
   PROTOBUF_CONSTEXPR RpcHeaderDefaultTypeInternal()
@@ -38,9 +41,47 @@ struct RpcHeaderDefaultTypeInternal {
   };
 };
 PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 RpcHeaderDefaultTypeInternal _RpcHeader_default_instance_;
+PROTOBUF_CONSTEXPR ServerLoad::ServerLoad(
+    ::_pbi::ConstantInitialized): _impl_{
+    /*decltype(_impl_.inflight_)*/0u
+  , /*decltype(_impl_.queue_delay_us_)*/0u
+  , /*decltype(_impl_.cpu_permille_)*/0u
+  , /*decltype(_impl_._cached_size_)*/{}} {}
+struct ServerLoadDefaultTypeInternal {
+  PROTOBUF_CONSTEXPR ServerLoadDefaultTypeInternal()
+      : _instance(::_pbi::ConstantInitialized{}) {}
+  ~ServerLoadDefaultTypeInternal() {}
+  union {
+    ServerLoad _instance;
+  };
+};
+PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 ServerLoadDefaultTypeInternal _ServerLoad_default_instance_;
+PROTOBUF_CONSTEXPR EndpointMeta::EndpointMeta(
+    ::_pbi::ConstantInitialized): _impl_{
+    /*decltype(_impl_.methods_)*/{}
+  , /*decltype(_impl_.host_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+  , /*decltype(_impl_.zone_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+  , /*decltype(_impl_.rack_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+  , /*decltype(_impl_.build_version_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+  , /*decltype(_impl_.meta_version_)*/0u
+  , /*decltype(_impl_.port_)*/0u
+  , /*decltype(_impl_.weight_)*/0u
+  , /*decltype(_impl_.max_concurrency_)*/0u
+  , /*decltype(_impl_.start_time_ms_)*/int64_t{0}
+  , /*decltype(_impl_.protocol_version_)*/0u
+  , /*decltype(_impl_._cached_size_)*/{}} {}
+struct EndpointMetaDefaultTypeInternal {
+  PROTOBUF_CONSTEXPR EndpointMetaDefaultTypeInternal()
+      : _instance(::_pbi::ConstantInitialized{}) {}
+  ~EndpointMetaDefaultTypeInternal() {}
+  union {
+    EndpointMeta _instance;
+  };
+};
+PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 EndpointMetaDefaultTypeInternal _EndpointMeta_default_instance_;
 }  // namespace Krpc
-static ::_pb::Metadata file_level_metadata_rpc_2eproto[1];
-static const ::_pb::EnumDescriptor* file_level_enum_descriptors_rpc_2eproto[1];
+static ::_pb::Metadata file_level_metadata_rpc_2eproto[3];
+static const ::_pb::EnumDescriptor* file_level_enum_descriptors_rpc_2eproto[2];
 static constexpr ::_pb::ServiceDescriptor const** file_level_service_descriptors_rpc_2eproto = nullptr;
 
 const uint32_t TableStruct_rpc_2eproto::offsets[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
@@ -55,27 +96,74 @@ const uint32_t TableStruct_rpc_2eproto::offsets[] PROTOBUF_SECTION_VARIABLE(prot
   PROTOBUF_FIELD_OFFSET(::Krpc::RpcHeader, _impl_.service_name_),
   PROTOBUF_FIELD_OFFSET(::Krpc::RpcHeader, _impl_.method_name_),
   PROTOBUF_FIELD_OFFSET(::Krpc::RpcHeader, _impl_.payload_),
+  PROTOBUF_FIELD_OFFSET(::Krpc::RpcHeader, _impl_.load_),
+  PROTOBUF_FIELD_OFFSET(::Krpc::RpcHeader, _impl_.status_),
+  PROTOBUF_FIELD_OFFSET(::Krpc::RpcHeader, _impl_.error_text_),
+  ~0u,  // no _has_bits_
+  PROTOBUF_FIELD_OFFSET(::Krpc::ServerLoad, _internal_metadata_),
+  ~0u,  // no _extensions_
+  ~0u,  // no _oneof_case_
+  ~0u,  // no _weak_field_map_
+  ~0u,  // no _inlined_string_donated_
+  PROTOBUF_FIELD_OFFSET(::Krpc::ServerLoad, _impl_.inflight_),
+  PROTOBUF_FIELD_OFFSET(::Krpc::ServerLoad, _impl_.queue_delay_us_),
+  PROTOBUF_FIELD_OFFSET(::Krpc::ServerLoad, _impl_.cpu_permille_),
+  ~0u,  // no _has_bits_
+  PROTOBUF_FIELD_OFFSET(::Krpc::EndpointMeta, _internal_metadata_),
+  ~0u,  // no _extensions_
+  ~0u,  // no _oneof_case_
+  ~0u,  // no _weak_field_map_
+  ~0u,  // no _inlined_string_donated_
+  PROTOBUF_FIELD_OFFSET(::Krpc::EndpointMeta, _impl_.meta_version_),
+  PROTOBUF_FIELD_OFFSET(::Krpc::EndpointMeta, _impl_.host_),
+  PROTOBUF_FIELD_OFFSET(::Krpc::EndpointMeta, _impl_.port_),
+  PROTOBUF_FIELD_OFFSET(::Krpc::EndpointMeta, _impl_.weight_),
+  PROTOBUF_FIELD_OFFSET(::Krpc::EndpointMeta, _impl_.zone_),
+  PROTOBUF_FIELD_OFFSET(::Krpc::EndpointMeta, _impl_.rack_),
+  PROTOBUF_FIELD_OFFSET(::Krpc::EndpointMeta, _impl_.max_concurrency_),
+  PROTOBUF_FIELD_OFFSET(::Krpc::EndpointMeta, _impl_.protocol_version_),
+  PROTOBUF_FIELD_OFFSET(::Krpc::EndpointMeta, _impl_.build_version_),
+  PROTOBUF_FIELD_OFFSET(::Krpc::EndpointMeta, _impl_.start_time_ms_),
+  PROTOBUF_FIELD_OFFSET(::Krpc::EndpointMeta, _impl_.methods_),
 };
 static const ::_pbi::MigrationSchema schemas[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
   { 0, -1, -1, sizeof(::Krpc::RpcHeader)},
+  { 14, -1, -1, sizeof(::Krpc::ServerLoad)},
+  { 23, -1, -1, sizeof(::Krpc::EndpointMeta)},
 };
 
 static const ::_pb::Message* const file_default_instances[] = {
   &::Krpc::_RpcHeader_default_instance_._instance,
+  &::Krpc::_ServerLoad_default_instance_._instance,
+  &::Krpc::_EndpointMeta_default_instance_._instance,
 };
 
 const char descriptor_table_protodef_rpc_2eproto[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) =
-  "\n\trpc.proto\022\004Krpc\"t\n\tRpcHeader\022\037\n\004type\030\001"
-  " \001(\0162\021.Krpc.MessageType\022\n\n\002id\030\002 \001(\006\022\024\n\014s"
-  "ervice_name\030\003 \001(\014\022\023\n\013method_name\030\004 \001(\014\022\017"
-  "\n\007payload\030\005 \001(\014*(\n\013MessageType\022\013\n\007REQUES"
-  "T\020\000\022\014\n\010RESPONSE\020\001b\006proto3"
+  "\n\trpc.proto\022\004Krpc\"\312\001\n\tRpcHeader\022\037\n\004type\030"
+  "\001 \001(\0162\021.Krpc.MessageType\022\n\n\002id\030\002 \001(\006\022\024\n\014"
+  "service_name\030\003 \001(\014\022\023\n\013method_name\030\004 \001(\014\022"
+  "\017\n\007payload\030\005 \001(\014\022\036\n\004load\030\006 \001(\0132\020.Krpc.Se"
+  "rverLoad\022 \n\006status\030\007 \001(\0162\020.Krpc.StatusCo"
+  "de\022\022\n\nerror_text\030\010 \001(\014\"L\n\nServerLoad\022\020\n\010"
+  "inflight\030\001 \001(\r\022\026\n\016queue_delay_us\030\002 \001(\r\022\024"
+  "\n\014cpu_permille\030\003 \001(\r\"\336\001\n\014EndpointMeta\022\024\n"
+  "\014meta_version\030\001 \001(\r\022\014\n\004host\030\002 \001(\t\022\014\n\004por"
+  "t\030\003 \001(\r\022\016\n\006weight\030\004 \001(\r\022\014\n\004zone\030\005 \001(\t\022\014\n"
+  "\004rack\030\006 \001(\t\022\027\n\017max_concurrency\030\007 \001(\r\022\030\n\020"
+  "protocol_version\030\010 \001(\r\022\025\n\rbuild_version\030"
+  "\t \001(\t\022\025\n\rstart_time_ms\030\n \001(\003\022\017\n\007methods\030"
+  "\013 \003(\t*(\n\013MessageType\022\013\n\007REQUEST\020\000\022\014\n\010RES"
+  "PONSE\020\001*\247\001\n\nStatusCode\022\006\n\002OK\020\000\022\r\n\tCANCEL"
+  "LED\020\001\022\013\n\007UNKNOWN\020\002\022\024\n\020INVALID_ARGUMENT\020\003"
+  "\022\025\n\021DEADLINE_EXCEEDED\020\004\022\026\n\022RESOURCE_EXHA"
+  "USTED\020\010\022\021\n\rUNIMPLEMENTED\020\014\022\014\n\010INTERNAL\020\r"
+  "\022\017\n\013UNAVAILABLE\020\016b\006proto3"
   ;
 static ::_pbi::once_flag descriptor_table_rpc_2eproto_once;
 const ::_pbi::DescriptorTable descriptor_table_rpc_2eproto = {
-    false, false, 185, descriptor_table_protodef_rpc_2eproto,
+    false, false, 745, descriptor_table_protodef_rpc_2eproto,
     "rpc.proto",
-    &descriptor_table_rpc_2eproto_once, nullptr, 0, 1,
+    &descriptor_table_rpc_2eproto_once, nullptr, 0, 3,
     schemas, file_default_instances, TableStruct_rpc_2eproto::offsets,
     file_level_metadata_rpc_2eproto, file_level_enum_descriptors_rpc_2eproto,
     file_level_service_descriptors_rpc_2eproto,
@@ -101,13 +189,39 @@ bool MessageType_IsValid(int value) {
   }
 }
 
+const ::PROTOBUF_NAMESPACE_ID::EnumDescriptor* StatusCode_descriptor() {
+  ::PROTOBUF_NAMESPACE_ID::internal::AssignDescriptors(&descriptor_table_rpc_2eproto);
+  return file_level_enum_descriptors_rpc_2eproto[1];
+}
+bool StatusCode_IsValid(int value) {
+  switch (value) {
+    case 0:
+    case 1:
+    case 2:
+    case 3:
+    case 4:
+    case 8:
+    case 12:
+    case 13:
+    case 14:
+      return true;
+    default:
+      return false;
+  }
+}
+
 
 // ===================================================================
 
 class RpcHeader::_Internal {
  public:
+  static const ::Krpc::ServerLoad& load(const RpcHeader* msg);
 };
 
+const ::Krpc::ServerLoad&
+RpcHeader::_Internal::load(const RpcHeader* msg) {
+  return *msg->_impl_.load_;
+}
 RpcHeader::RpcHeader(::PROTOBUF_NAMESPACE_ID::Arena* arena,
                          bool is_message_owned)
   : ::PROTOBUF_NAMESPACE_ID::Message(arena, is_message_owned) {
@@ -121,8 +235,11 @@ RpcHeader::RpcHeader(const RpcHeader& from)
       decltype(_impl_.service_name_){}
     , decltype(_impl_.method_name_){}
     , decltype(_impl_.payload_){}
+    , decltype(_impl_.error_text_){}
+    , decltype(_impl_.load_){nullptr}
     , decltype(_impl_.id_){}
     , decltype(_impl_.type_){}
+    , decltype(_impl_.status_){}
     , /*decltype(_impl_._cached_size_)*/{}};
 
   _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
@@ -150,9 +267,20 @@ RpcHeader::RpcHeader(const RpcHeader& from)
     _this->_impl_.payload_.Set(from._internal_payload(), 
       _this->GetArenaForAllocation());
   }
+  _impl_.error_text_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.error_text_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (!from._internal_error_text().empty()) {
+    _this->_impl_.error_text_.Set(from._internal_error_text(), 
+      _this->GetArenaForAllocation());
+  }
+  if (from._internal_has_load()) {
+    _this->_impl_.load_ = new ::Krpc::ServerLoad(*from._impl_.load_);
+  }
   ::memcpy(&_impl_.id_, &from._impl_.id_,
-    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.type_) -
-    reinterpret_cast<char*>(&_impl_.id_)) + sizeof(_impl_.type_));
+    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.status_) -
+    reinterpret_cast<char*>(&_impl_.id_)) + sizeof(_impl_.status_));
   // @@protoc_insertion_point(copy_constructor:Krpc.RpcHeader)
 }
 
@@ -164,8 +292,11 @@ inline void RpcHeader::SharedCtor(
       decltype(_impl_.service_name_){}
     , decltype(_impl_.method_name_){}
     , decltype(_impl_.payload_){}
+    , decltype(_impl_.error_text_){}
+    , decltype(_impl_.load_){nullptr}
     , decltype(_impl_.id_){uint64_t{0u}}
     , decltype(_impl_.type_){0}
+    , decltype(_impl_.status_){0}
     , /*decltype(_impl_._cached_size_)*/{}
   };
   _impl_.service_name_.InitDefault();
@@ -180,6 +311,10 @@ inline void RpcHeader::SharedCtor(
   #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
     _impl_.payload_.Set("", GetArenaForAllocation());
   #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  _impl_.error_text_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.error_text_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
 }
 
 RpcHeader::~RpcHeader() {
@@ -196,6 +331,8 @@ inline void RpcHeader::SharedDtor() {
   _impl_.service_name_.Destroy();
   _impl_.method_name_.Destroy();
   _impl_.payload_.Destroy();
+  _impl_.error_text_.Destroy();
+  if (this != internal_default_instance()) delete _impl_.load_;
 }
 
 void RpcHeader::SetCachedSize(int size) const {
@@ -211,9 +348,14 @@ void RpcHeader::Clear() {
   _impl_.service_name_.ClearToEmpty();
   _impl_.method_name_.ClearToEmpty();
   _impl_.payload_.ClearToEmpty();
+  _impl_.error_text_.ClearToEmpty();
+  if (GetArenaForAllocation() == nullptr && _impl_.load_ != nullptr) {
+    delete _impl_.load_;
+  }
+  _impl_.load_ = nullptr;
   ::memset(&_impl_.id_, 0, static_cast<size_t>(
-      reinterpret_cast<char*>(&_impl_.type_) -
-      reinterpret_cast<char*>(&_impl_.id_)) + sizeof(_impl_.type_));
+      reinterpret_cast<char*>(&_impl_.status_) -
+      reinterpret_cast<char*>(&_impl_.id_)) + sizeof(_impl_.status_));
   _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
 }
 
@@ -267,6 +409,32 @@ const char* RpcHeader::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx
         } else
           goto handle_unusual;
         continue;
+      // .Krpc.ServerLoad load = 6;
+      case 6:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 50)) {
+          ptr = ctx->ParseMessage(_internal_mutable_load(), ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // .Krpc.StatusCode status = 7;
+      case 7:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 56)) {
+          uint64_t val = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+          _internal_set_status(static_cast<::Krpc::StatusCode>(val));
+        } else
+          goto handle_unusual;
+        continue;
+      // bytes error_text = 8;
+      case 8:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 66)) {
+          auto str = _internal_mutable_error_text();
+          ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
       default:
         goto handle_unusual;
     }  // switch
@@ -327,6 +495,26 @@ uint8_t* RpcHeader::_InternalSerialize(
         5, this->_internal_payload(), target);
   }
 
+  // .Krpc.ServerLoad load = 6;
+  if (this->_internal_has_load()) {
+    target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::
+      InternalWriteMessage(6, _Internal::load(this),
+        _Internal::load(this).GetCachedSize(), target, stream);
+  }
+
+  // .Krpc.StatusCode status = 7;
+  if (this->_internal_status() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteEnumToArray(
+      7, this->_internal_status(), target);
+  }
+
+  // bytes error_text = 8;
+  if (!this->_internal_error_text().empty()) {
+    target = stream->WriteBytesMaybeAliased(
+        8, this->_internal_error_text(), target);
+  }
+
   if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
     target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
         _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
@@ -364,6 +552,20 @@ size_t RpcHeader::ByteSizeLong() const {
         this->_internal_payload());
   }
 
+  // bytes error_text = 8;
+  if (!this->_internal_error_text().empty()) {
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::BytesSize(
+        this->_internal_error_text());
+  }
+
+  // .Krpc.ServerLoad load = 6;
+  if (this->_internal_has_load()) {
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::MessageSize(
+        *_impl_.load_);
+  }
+
   // fixed64 id = 2;
   if (this->_internal_id() != 0) {
     total_size += 1 + 8;
@@ -375,6 +577,12 @@ size_t RpcHeader::ByteSizeLong() const {
       ::_pbi::WireFormatLite::EnumSize(this->_internal_type());
   }
 
+  // .Krpc.StatusCode status = 7;
+  if (this->_internal_status() != 0) {
+    total_size += 1 +
+      ::_pbi::WireFormatLite::EnumSize(this->_internal_status());
+  }
+
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
@@ -402,12 +610,22 @@ void RpcHeader::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROT
   if (!from._internal_payload().empty()) {
     _this->_internal_set_payload(from._internal_payload());
   }
+  if (!from._internal_error_text().empty()) {
+    _this->_internal_set_error_text(from._internal_error_text());
+  }
+  if (from._internal_has_load()) {
+    _this->_internal_mutable_load()->::Krpc::ServerLoad::MergeFrom(
+        from._internal_load());
+  }
   if (from._internal_id() != 0) {
     _this->_internal_set_id(from._internal_id());
   }
   if (from._internal_type() != 0) {
     _this->_internal_set_type(from._internal_type());
   }
+  if (from._internal_status() != 0) {
+    _this->_internal_set_status(from._internal_status());
+  }
   _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
 }
 
@@ -439,12 +657,16 @@ void RpcHeader::InternalSwap(RpcHeader* other) {
       &_impl_.payload_, lhs_arena,
       &other->_impl_.payload_, rhs_arena
   );
+  ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr::InternalSwap(
+      &_impl_.error_text_, lhs_arena,
+      &other->_impl_.error_text_, rhs_arena
+  );
   ::PROTOBUF_NAMESPACE_ID::internal::memswap<
-      PROTOBUF_FIELD_OFFSET(RpcHeader, _impl_.type_)
-      + sizeof(RpcHeader::_impl_.type_)
-      - PROTOBUF_FIELD_OFFSET(RpcHeader, _impl_.id_)>(
-          reinterpret_cast<char*>(&_impl_.id_),
-          reinterpret_cast<char*>(&other->_impl_.id_));
+      PROTOBUF_FIELD_OFFSET(RpcHeader, _impl_.status_)
+      + sizeof(RpcHeader::_impl_.status_)
+      - PROTOBUF_FIELD_OFFSET(RpcHeader, _impl_.load_)>(
+          reinterpret_cast<char*>(&_impl_.load_),
+          reinterpret_cast<char*>(&other->_impl_.load_));
 }
 
 ::PROTOBUF_NAMESPACE_ID::Metadata RpcHeader::GetMetadata() const {
@@ -453,6 +675,789 @@ void RpcHeader::InternalSwap(RpcHeader* other) {
       file_level_metadata_rpc_2eproto[0]);
 }
 
+// ===================================================================
+
+class ServerLoad::_Internal {
+ public:
+};
+
+ServerLoad::ServerLoad(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                         bool is_message_owned)
+  : ::PROTOBUF_NAMESPACE_ID::Message(arena, is_message_owned) {
+  SharedCtor(arena, is_message_owned);
+  // @@protoc_insertion_point(arena_constructor:Krpc.ServerLoad)
+}
+ServerLoad::ServerLoad(const ServerLoad& from)
+  : ::PROTOBUF_NAMESPACE_ID::Message() {
+  ServerLoad* const _this = this; (void)_this;
+  new (&_impl_) Impl_{
+      decltype(_impl_.inflight_){}
+    , decltype(_impl_.queue_delay_us_){}
+    , decltype(_impl_.cpu_permille_){}
+    , /*decltype(_impl_._cached_size_)*/{}};
+
+  _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+  ::memcpy(&_impl_.inflight_, &from._impl_.inflight_,
+    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.cpu_permille_) -
+    reinterpret_cast<char*>(&_impl_.inflight_)) + sizeof(_impl_.cpu_permille_));
+  // @@protoc_insertion_point(copy_constructor:Krpc.ServerLoad)
+}
+
+inline void ServerLoad::SharedCtor(
+    ::_pb::Arena* arena, bool is_message_owned) {
+  (void)arena;
+  (void)is_message_owned;
+  new (&_impl_) Impl_{
+      decltype(_impl_.inflight_){0u}
+    , decltype(_impl_.queue_delay_us_){0u}
+    , decltype(_impl_.cpu_permille_){0u}
+    , /*decltype(_impl_._cached_size_)*/{}
+  };
+}
+
+ServerLoad::~ServerLoad() {
+  // @@protoc_insertion_point(destructor:Krpc.ServerLoad)
+  if (auto *arena = _internal_metadata_.DeleteReturnArena<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>()) {
+  (void)arena;
+    return;
+  }
+  SharedDtor();
+}
+
+inline void ServerLoad::SharedDtor() {
+  GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
+}
+
+void ServerLoad::SetCachedSize(int size) const {
+  _impl_._cached_size_.Set(size);
+}
+
+void ServerLoad::Clear() {
+// @@protoc_insertion_point(message_clear_start:Krpc.ServerLoad)
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  ::memset(&_impl_.inflight_, 0, static_cast<size_t>(
+      reinterpret_cast<char*>(&_impl_.cpu_permille_) -
+      reinterpret_cast<char*>(&_impl_.inflight_)) + sizeof(_impl_.cpu_permille_));
+  _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
+}
+
+const char* ServerLoad::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
+#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  while (!ctx->Done(&ptr)) {
+    uint32_t tag;
+    ptr = ::_pbi::ReadTag(ptr, &tag);
+    switch (tag >> 3) {
+      // uint32 inflight = 1;
+      case 1:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 8)) {
+          _impl_.inflight_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // uint32 queue_delay_us = 2;
+      case 2:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 16)) {
+          _impl_.queue_delay_us_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // uint32 cpu_permille = 3;
+      case 3:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 24)) {
+          _impl_.cpu_permille_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      default:
+        goto handle_unusual;
+    }  // switch
+  handle_unusual:
+    if ((tag == 0) || ((tag & 7) == 4)) {
+      CHK_(ptr);
+      ctx->SetLastTag(tag);
+      goto message_done;
+    }
+    ptr = UnknownFieldParse(
+        tag,
+        _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(),
+        ptr, ctx);
+    CHK_(ptr != nullptr);
+  }  // while
+message_done:
+  return ptr;
+failure:
+  ptr = nullptr;
+  goto message_done;
+#undef CHK_
+}
+
+uint8_t* ServerLoad::_InternalSerialize(
+    uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const {
+  // @@protoc_insertion_point(serialize_to_array_start:Krpc.ServerLoad)
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  // uint32 inflight = 1;
+  if (this->_internal_inflight() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(1, this->_internal_inflight(), target);
+  }
+
+  // uint32 queue_delay_us = 2;
+  if (this->_internal_queue_delay_us() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(2, this->_internal_queue_delay_us(), target);
+  }
+
+  // uint32 cpu_permille = 3;
+  if (this->_internal_cpu_permille() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(3, this->_internal_cpu_permille(), target);
+  }
+
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:Krpc.ServerLoad)
+  return target;
+}
+
+size_t ServerLoad::ByteSizeLong() const {
+// @@protoc_insertion_point(message_byte_size_start:Krpc.ServerLoad)
+  size_t total_size = 0;
+
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  // uint32 inflight = 1;
+  if (this->_internal_inflight() != 0) {
+    total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_inflight());
+  }
+
+  // uint32 queue_delay_us = 2;
+  if (this->_internal_queue_delay_us() != 0) {
+    total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_queue_delay_us());
+  }
+
+  // uint32 cpu_permille = 3;
+  if (this->_internal_cpu_permille() != 0) {
+    total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_cpu_permille());
+  }
+
+  return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
+}
+
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData ServerLoad::_class_data_ = {
+    ::PROTOBUF_NAMESPACE_ID::Message::CopyWithSourceCheck,
+    ServerLoad::MergeImpl
+};
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*ServerLoad::GetClassData() const { return &_class_data_; }
+
+
+void ServerLoad::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg) {
+  auto* const _this = static_cast<ServerLoad*>(&to_msg);
+  auto& from = static_cast<const ServerLoad&>(from_msg);
+  // @@protoc_insertion_point(class_specific_merge_from_start:Krpc.ServerLoad)
+  GOOGLE_DCHECK_NE(&from, _this);
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  if (from._internal_inflight() != 0) {
+    _this->_internal_set_inflight(from._internal_inflight());
+  }
+  if (from._internal_queue_delay_us() != 0) {
+    _this->_internal_set_queue_delay_us(from._internal_queue_delay_us());
+  }
+  if (from._internal_cpu_permille() != 0) {
+    _this->_internal_set_cpu_permille(from._internal_cpu_permille());
+  }
+  _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+}
+
+void ServerLoad::CopyFrom(const ServerLoad& from) {
+// @@protoc_insertion_point(class_specific_copy_from_start:Krpc.ServerLoad)
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool ServerLoad::IsInitialized() const {
+  return true;
+}
+
+void ServerLoad::InternalSwap(ServerLoad* other) {
+  using std::swap;
+  _internal_metadata_.InternalSwap(&other->_internal_metadata_);
+  ::PROTOBUF_NAMESPACE_ID::internal::memswap<
+      PROTOBUF_FIELD_OFFSET(ServerLoad, _impl_.cpu_permille_)
+      + sizeof(ServerLoad::_impl_.cpu_permille_)
+      - PROTOBUF_FIELD_OFFSET(ServerLoad, _impl_.inflight_)>(
+          reinterpret_cast<char*>(&_impl_.inflight_),
+          reinterpret_cast<char*>(&other->_impl_.inflight_));
+}
+
+::PROTOBUF_NAMESPACE_ID::Metadata ServerLoad::GetMetadata() const {
+  return ::_pbi::AssignDescriptors(
+      &descriptor_table_rpc_2eproto_getter, &descriptor_table_rpc_2eproto_once,
+      file_level_metadata_rpc_2eproto[1]);
+}
+
+// ===================================================================
+
+class EndpointMeta::_Internal {
+ public:
+};
+
+EndpointMeta::EndpointMeta(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                         bool is_message_owned)
+  : ::PROTOBUF_NAMESPACE_ID::Message(arena, is_message_owned) {
+  SharedCtor(arena, is_message_owned);
+  // @@protoc_insertion_point(arena_constructor:Krpc.EndpointMeta)
+}
+EndpointMeta::EndpointMeta(const EndpointMeta& from)
+  : ::PROTOBUF_NAMESPACE_ID::Message() {
+  EndpointMeta* const _this = this; (void)_this;
+  new (&_impl_) Impl_{
+      decltype(_impl_.methods_){from._impl_.methods_}
+    , decltype(_impl_.host_){}
+    , decltype(_impl_.zone_){}
+    , decltype(_impl_.rack_){}
+    , decltype(_impl_.build_version_){}
+    , decltype(_impl_.meta_version_){}
+    , decltype(_impl_.port_){}
+    , decltype(_impl_.weight_){}
+    , decltype(_impl_.max_concurrency_){}
+    , decltype(_impl_.start_time_ms_){}
+    , decltype(_impl_.protocol_version_){}
+    , /*decltype(_impl_._cached_size_)*/{}};
+
+  _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+  _impl_.host_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.host_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (!from._internal_host().empty()) {
+    _this->_impl_.host_.Set(from._internal_host(), 
+      _this->GetArenaForAllocation());
+  }
+  _impl_.zone_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.zone_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (!from._internal_zone().empty()) {
+    _this->_impl_.zone_.Set(from._internal_zone(), 
+      _this->GetArenaForAllocation());
+  }
+  _impl_.rack_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.rack_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (!from._internal_rack().empty()) {
+    _this->_impl_.rack_.Set(from._internal_rack(), 
+      _this->GetArenaForAllocation());
+  }
+  _impl_.build_version_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.build_version_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (!from._internal_build_version().empty()) {
+    _this->_impl_.build_version_.Set(from._internal_build_version(), 
+      _this->GetArenaForAllocation());
+  }
+  ::memcpy(&_impl_.meta_version_, &from._impl_.meta_version_,
+    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.protocol_version_) -
+    reinterpret_cast<char*>(&_impl_.meta_version_)) + sizeof(_impl_.protocol_version_));
+  // @@protoc_insertion_point(copy_constructor:Krpc.EndpointMeta)
+}
+
+inline void EndpointMeta::SharedCtor(
+    ::_pb::Arena* arena, bool is_message_owned) {
+  (void)arena;
+  (void)is_message_owned;
+  new (&_impl_) Impl_{
+      decltype(_impl_.methods_){arena}
+    , decltype(_impl_.host_){}
+    , decltype(_impl_.zone_){}
+    , decltype(_impl_.rack_){}
+    , decltype(_impl_.build_version_){}
+    , decltype(_impl_.meta_version_){0u}
+    , decltype(_impl_.port_){0u}
+    , decltype(_impl_.weight_){0u}
+    , decltype(_impl_.max_concurrency_){0u}
+    , decltype(_impl_.start_time_ms_){int64_t{0}}
+    , decltype(_impl_.protocol_version_){0u}
+    , /*decltype(_impl_._cached_size_)*/{}
+  };
+  _impl_.host_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.host_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  _impl_.zone_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.zone_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  _impl_.rack_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.rack_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  _impl_.build_version_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.build_version_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+}
+
+EndpointMeta::~EndpointMeta() {
+  // @@protoc_insertion_point(destructor:Krpc.EndpointMeta)
+  if (auto *arena = _internal_metadata_.DeleteReturnArena<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>()) {
+  (void)arena;
+    return;
+  }
+  SharedDtor();
+}
+
+inline void EndpointMeta::SharedDtor() {
+  GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
+  _impl_.methods_.~RepeatedPtrField();
+  _impl_.host_.Destroy();
+  _impl_.zone_.Destroy();
+  _impl_.rack_.Destroy();
+  _impl_.build_version_.Destroy();
+}
+
+void EndpointMeta::SetCachedSize(int size) const {
+  _impl_._cached_size_.Set(size);
+}
+
+void EndpointMeta::Clear() {
+// @@protoc_insertion_point(message_clear_start:Krpc.EndpointMeta)
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  _impl_.methods_.Clear();
+  _impl_.host_.ClearToEmpty();
+  _impl_.zone_.ClearToEmpty();
+  _impl_.rack_.ClearToEmpty();
+  _impl_.build_version_.ClearToEmpty();
+  ::memset(&_impl_.meta_version_, 0, static_cast<size_t>(
+      reinterpret_cast<char*>(&_impl_.protocol_version_) -
+      reinterpret_cast<char*>(&_impl_.meta_version_)) + sizeof(_impl_.protocol_version_));
+  _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
+}
+
+const char* EndpointMeta::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
+#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  while (!ctx->Done(&ptr)) {
+    uint32_t tag;
+    ptr = ::_pbi::ReadTag(ptr, &tag);
+    switch (tag >> 3) {
+      // uint32 meta_version = 1;
+      case 1:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 8)) {
+          _impl_.meta_version_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // string host = 2;
+      case 2:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 18)) {
+          auto str = _internal_mutable_host();
+          ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);
+          CHK_(ptr);
+          CHK_(::_pbi::VerifyUTF8(str, "Krpc.EndpointMeta.host"));
+        } else
+          goto handle_unusual;
+        continue;
+      // uint32 port = 3;
+      case 3:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 24)) {
+          _impl_.port_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // uint32 weight = 4;
+      case 4:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 32)) {
+          _impl_.weight_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // string zone = 5;
+      case 5:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 42)) {
+          auto str = _internal_mutable_zone();
+          ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);
+          CHK_(ptr);
+          CHK_(::_pbi::VerifyUTF8(str, "Krpc.EndpointMeta.zone"));
+        } else
+          goto handle_unusual;
+        continue;
+      // string rack = 6;
+      case 6:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 50)) {
+          auto str = _internal_mutable_rack();
+          ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);
+          CHK_(ptr);
+          CHK_(::_pbi::VerifyUTF8(str, "Krpc.EndpointMeta.rack"));
+        } else
+          goto handle_unusual;
+        continue;
+      // uint32 max_concurrency = 7;
+      case 7:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 56)) {
+          _impl_.max_concurrency_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // uint32 protocol_version = 8;
+      case 8:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 64)) {
+          _impl_.protocol_version_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // string build_version = 9;
+      case 9:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 74)) {
+          auto str = _internal_mutable_build_version();
+          ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);
+          CHK_(ptr);
+          CHK_(::_pbi::VerifyUTF8(str, "Krpc.EndpointMeta.build_version"));
+        } else
+          goto handle_unusual;
+        continue;
+      // int64 start_time_ms = 10;
+      case 10:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 80)) {
+          _impl_.start_time_ms_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // repeated string methods = 11;
+      case 11:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 90)) {
+          ptr -= 1;
+          do {
+            ptr += 1;
+            auto str = _internal_add_methods();
+            ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);
+            CHK_(ptr);
+            CHK_(::_pbi::VerifyUTF8(str, "Krpc.EndpointMeta.methods"));
+            if (!ctx->DataAvailable(ptr)) break;
+          } while (::PROTOBUF_NAMESPACE_ID::internal::ExpectTag<90>(ptr));
+        } else
+          goto handle_unusual;
+        continue;
+      default:
+        goto handle_unusual;
+    }  // switch
+  handle_unusual:
+    if ((tag == 0) || ((tag & 7) == 4)) {
+      CHK_(ptr);
+      ctx->SetLastTag(tag);
+      goto message_done;
+    }
+    ptr = UnknownFieldParse(
+        tag,
+        _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(),
+        ptr, ctx);
+    CHK_(ptr != nullptr);
+  }  // while
+message_done:
+  return ptr;
+failure:
+  ptr = nullptr;
+  goto message_done;
+#undef CHK_
+}
+
+uint8_t* EndpointMeta::_InternalSerialize(
+    uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const {
+  // @@protoc_insertion_point(serialize_to_array_start:Krpc.EndpointMeta)
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  // uint32 meta_version = 1;
+  if (this->_internal_meta_version() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(1, this->_internal_meta_version(), target);
+  }
+
+  // string host = 2;
+  if (!this->_internal_host().empty()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::VerifyUtf8String(
+      this->_internal_host().data(), static_cast<int>(this->_internal_host().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::SERIALIZE,
+      "Krpc.EndpointMeta.host");
+    target = stream->WriteStringMaybeAliased(
+        2, this->_internal_host(), target);
+  }
+
+  // uint32 port = 3;
+  if (this->_internal_port() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(3, this->_internal_port(), target);
+  }
+
+  // uint32 weight = 4;
+  if (this->_internal_weight() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(4, this->_internal_weight(), target);
+  }
+
+  // string zone = 5;
+  if (!this->_internal_zone().empty()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::VerifyUtf8String(
+      this->_internal_zone().data(), static_cast<int>(this->_internal_zone().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::SERIALIZE,
+      "Krpc.EndpointMeta.zone");
+    target = stream->WriteStringMaybeAliased(
+        5, this->_internal_zone(), target);
+  }
+
+  // string rack = 6;
+  if (!this->_internal_rack().empty()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::VerifyUtf8String(
+      this->_internal_rack().data(), static_cast<int>(this->_internal_rack().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::SERIALIZE,
+      "Krpc.EndpointMeta.rack");
+    target = stream->WriteStringMaybeAliased(
+        6, this->_internal_rack(), target);
+  }
+
+  // uint32 max_concurrency = 7;
+  if (this->_internal_max_concurrency() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(7, this->_internal_max_concurrency(), target);
+  }
+
+  // uint32 protocol_version = 8;
+  if (this->_internal_protocol_version() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(8, this->_internal_protocol_version(), target);
+  }
+
+  // string build_version = 9;
+  if (!this->_internal_build_version().empty()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::VerifyUtf8String(
+      this->_internal_build_version().data(), static_cast<int>(this->_internal_build_version().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::SERIALIZE,
+      "Krpc.EndpointMeta.build_version");
+    target = stream->WriteStringMaybeAliased(
+        9, this->_internal_build_version(), target);
+  }
+
+  // int64 start_time_ms = 10;
+  if (this->_internal_start_time_ms() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt64ToArray(10, this->_internal_start_time_ms(), target);
+  }
+
+  // repeated string methods = 11;
+  for (int i = 0, n = this->_internal_methods_size(); i < n; i++) {
+    const auto& s = this->_internal_methods(i);
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::VerifyUtf8String(
+      s.data(), static_cast<int>(s.length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::SERIALIZE,
+      "Krpc.EndpointMeta.methods");
+    target = stream->WriteString(11, s, target);
+  }
+
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:Krpc.EndpointMeta)
+  return target;
+}
+
+size_t EndpointMeta::ByteSizeLong() const {
+// @@protoc_insertion_point(message_byte_size_start:Krpc.EndpointMeta)
+  size_t total_size = 0;
+
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  // repeated string methods = 11;
+  total_size += 1 *
+      ::PROTOBUF_NAMESPACE_ID::internal::FromIntSize(_impl_.methods_.size());
+  for (int i = 0, n = _impl_.methods_.size(); i < n; i++) {
+    total_size += ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::StringSize(
+      _impl_.methods_.Get(i));
+  }
+
+  // string host = 2;
+  if (!this->_internal_host().empty()) {
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::StringSize(
+        this->_internal_host());
+  }
+
+  // string zone = 5;
+  if (!this->_internal_zone().empty()) {
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::StringSize(
+        this->_internal_zone());
+  }
+
+  // string rack = 6;
+  if (!this->_internal_rack().empty()) {
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::StringSize(
+        this->_internal_rack());
+  }
+
+  // string build_version = 9;
+  if (!this->_internal_build_version().empty()) {
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::StringSize(
+        this->_internal_build_version());
+  }
+
+  // uint32 meta_version = 1;
+  if (this->_internal_meta_version() != 0) {
+    total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_meta_version());
+  }
+
+  // uint32 port = 3;
+  if (this->_internal_port() != 0) {
+    total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_port());
+  }
+
+  // uint32 weight = 4;
+  if (this->_internal_weight() != 0) {
+    total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_weight());
+  }
+
+  // uint32 max_concurrency = 7;
+  if (this->_internal_max_concurrency() != 0) {
+    total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_max_concurrency());
+  }
+
+  // int64 start_time_ms = 10;
+  if (this->_internal_start_time_ms() != 0) {
+    total_size += ::_pbi::WireFormatLite::Int64SizePlusOne(this->_internal_start_time_ms());
+  }
+
+  // uint32 protocol_version = 8;
+  if (this->_internal_protocol_version() != 0) {
+    total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_protocol_version());
+  }
+
+  return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
+}
+
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData EndpointMeta::_class_data_ = {
+    ::PROTOBUF_NAMESPACE_ID::Message::CopyWithSourceCheck,
+    EndpointMeta::MergeImpl
+};
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*EndpointMeta::GetClassData() const { return &_class_data_; }
+
+
+void EndpointMeta::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg) {
+  auto* const _this = static_cast<EndpointMeta*>(&to_msg);
+  auto& from = static_cast<const EndpointMeta&>(from_msg);
+  // @@protoc_insertion_point(class_specific_merge_from_start:Krpc.EndpointMeta)
+  GOOGLE_DCHECK_NE(&from, _this);
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  _this->_impl_.methods_.MergeFrom(from._impl_.methods_);
+  if (!from._internal_host().empty()) {
+    _this->_internal_set_host(from._internal_host());
+  }
+  if (!from._internal_zone().empty()) {
+    _this->_internal_set_zone(from._internal_zone());
+  }
+  if (!from._internal_rack().empty()) {
+    _this->_internal_set_rack(from._internal_rack());
+  }
+  if (!from._internal_build_version().empty()) {
+    _this->_internal_set_build_version(from._internal_build_version());
+  }
+  if (from._internal_meta_version() != 0) {
+    _this->_internal_set_meta_version(from._internal_meta_version());
+  }
+  if (from._internal_port() != 0) {
+    _this->_internal_set_port(from._internal_port());
+  }
+  if (from._internal_weight() != 0) {
+    _this->_internal_set_weight(from._internal_weight());
+  }
+  if (from._internal_max_concurrency() != 0) {
+    _this->_internal_set_max_concurrency(from._internal_max_concurrency());
+  }
+  if (from._internal_start_time_ms() != 0) {
+    _this->_internal_set_start_time_ms(from._internal_start_time_ms());
+  }
+  if (from._internal_protocol_version() != 0) {
+    _this->_internal_set_protocol_version(from._internal_protocol_version());
+  }
+  _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+}
+
+void EndpointMeta::CopyFrom(const EndpointMeta& from) {
+// @@protoc_insertion_point(class_specific_copy_from_start:Krpc.EndpointMeta)
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool EndpointMeta::IsInitialized() const {
+  return true;
+}
+
+void EndpointMeta::InternalSwap(EndpointMeta* other) {
+  using std::swap;
+  auto* lhs_arena = GetArenaForAllocation();
+  auto* rhs_arena = other->GetArenaForAllocation();
+  _internal_metadata_.InternalSwap(&other->_internal_metadata_);
+  _impl_.methods_.InternalSwap(&other->_impl_.methods_);
+  ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr::InternalSwap(
+      &_impl_.host_, lhs_arena,
+      &other->_impl_.host_, rhs_arena
+  );
+  ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr::InternalSwap(
+      &_impl_.zone_, lhs_arena,
+      &other->_impl_.zone_, rhs_arena
+  );
+  ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr::InternalSwap(
+      &_impl_.rack_, lhs_arena,
+      &other->_impl_.rack_, rhs_arena
+  );
+  ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr::InternalSwap(
+      &_impl_.build_version_, lhs_arena,
+      &other->_impl_.build_version_, rhs_arena
+  );
+  ::PROTOBUF_NAMESPACE_ID::internal::memswap<
+      PROTOBUF_FIELD_OFFSET(EndpointMeta, _impl_.protocol_version_)
+      + sizeof(EndpointMeta::_impl_.protocol_version_)
+      - PROTOBUF_FIELD_OFFSET(EndpointMeta, _impl_.meta_version_)>(
+          reinterpret_cast<char*>(&_impl_.meta_version_),
+          reinterpret_cast<char*>(&other->_impl_.meta_version_));
+}
+
+::PROTOBUF_NAMESPACE_ID::Metadata EndpointMeta::GetMetadata() const {
+  return ::_pbi::AssignDescriptors(
+      &descriptor_table_rpc_2eproto_getter, &descriptor_table_rpc_2eproto_once,
+      file_level_metadata_rpc_2eproto[2]);
+}
+
 // @@protoc_insertion_point(namespace_scope)
 }  // namespace Krpc
 PROTOBUF_NAMESPACE_OPEN
@@ -460,6 +1465,14 @@ template<> PROTOBUF_NOINLINE ::Krpc::RpcHeader*
 Arena::CreateMaybeMessage< ::Krpc::RpcHeader >(Arena* arena) {
   return Arena::CreateMessageInternal< ::Krpc::RpcHeader >(arena);
 }
+template<> PROTOBUF_NOINLINE ::Krpc::ServerLoad*
+Arena::CreateMaybeMessage< ::Krpc::ServerLoad >(Arena* arena) {
+  return Arena::CreateMessageInternal< ::Krpc::ServerLoad >(arena);
+}
+template<> PROTOBUF_NOINLINE ::Krpc::EndpointMeta*
+Arena::CreateMaybeMessage< ::Krpc::EndpointMeta >(Arena* arena) {
+  return Arena::CreateMessageInternal< ::Krpc::EndpointMeta >(arena);
+}
 PROTOBUF_NAMESPACE_CLOSE
 
 // @@protoc_insertion_point(global_scope)